@@ -1,4 +1,4 @@
-from flask import Flask, request, jsonify, abort
+from flask import Flask, request, jsonify, abort, g
 from flask_cors import CORS
 import json
 import os
@@ -40,21 +40,63 @@ else:
         'PORT': '8080',
         'HOST': 'localhost',
         'DEBUG': 'True',
-        'DATABASE': 'movies.db'
+        'DATABASE': 'movies.db',
+        'ENGINE_LOG_LEVEL': 'info',
+        'ADMISSION_CONTROL': '1'
     }
 
 # Create Flask app
 app = Flask(__name__)
 CORS(app, resources={r"/*": {"origins": ["http://localhost:5173", "http://localhost:4173"]}})  # Enable CORS for all routes
 
+# Engine log level (debug, info, warn, error or off); CINEMA_LOG_LEVEL overrides config.ini
+cinema_engine.setLogLevel(os.environ.get('CINEMA_LOG_LEVEL', config['Backend'].get('ENGINE_LOG_LEVEL', 'info')))
+if os.environ.get('CINEMA_LOG_FORMAT'):
+    cinema_engine.setLogFormat(os.environ['CINEMA_LOG_FORMAT'])
+
+# Engine trace spans for recent requests (CINEMA_TRACING=1 turns them on)
+cinema_engine.setTracing(os.environ.get('CINEMA_TRACING', '0') != '0',
+                         int(os.environ.get('CINEMA_TRACE_CAPACITY', '256')))
+
 # Initialize the C++ booking system
 booking_system = cinema_engine.BookingSystem()
 
+# Each request is one engine trace, keyed by the caller's X-Request-ID when given
+@app.before_request
+def begin_engine_trace():
+    g.request_id = request.headers.get('X-Request-ID') or uuid.uuid4().hex
+    cinema_engine.beginTrace(g.request_id, f"{request.method} {request.path}")
+
+@app.after_request
+def add_request_id(response):
+    if 'request_id' in g:
+        response.headers['X-Request-ID'] = g.request_id
+    return response
+
+@app.teardown_request
+def end_engine_trace(exception):
+    cinema_engine.endTrace()
+
 # Load initial data
 data_dir = os.path.join(os.path.dirname(__file__), 'data')
 booking_system.loadMovies(os.path.join(data_dir, "movies.json"))
 booking_system.loadCinemas(os.path.join(data_dir, "cinemas.json"))
 
+# Waiting room and rate limits for booking calls; the engine leaves them off.
+# CINEMA_ADMISSION overrides ADMISSION_CONTROL in config.ini.
+if os.environ.get('CINEMA_ADMISSION', config['Backend'].get('ADMISSION_CONTROL', '1')) != '0':
+    booking_system.configureAdmission({'enabled': True})
+
+# Approximate analytics only: user counts come from bounded sketches instead of
+# exact per-user tallies (e.g. CINEMA_SKETCH_ANALYTICS=1)
+if os.environ.get('CINEMA_SKETCH_ANALYTICS', '0') != '0':
+    booking_system.setSketchAnalytics(True)
+
+# With several worker processes, share seat inventory between them
+# (e.g. CINEMA_SHARED_INVENTORY=/cineverse_seats)
+if os.environ.get('CINEMA_SHARED_INVENTORY'):
+    booking_system.enableSharedInventory(os.environ['CINEMA_SHARED_INVENTORY'])
+
 # JWT Secret key - should be in environment variables in production
 JWT_SECRET = "your-secret-key-should-be-more-secure"
 JWT_EXPIRY = 24  # hours
@@ -252,36 +294,114 @@ def get_admin_bookings():
 
 @app.route('/api/admin/analytics', methods=['GET'])
 def get_analytics():
-    cinemas = load_data('cinemas')
-    movies = load_data('movies')
-    bookings = load_data('bookings')
-    showtimes = load_data('showtimes')
-    
-    # Calculate analytics
-    cinema_bookings = {}
-    movie_bookings = {}
-    
-    for booking in bookings:
-        # Count bookings per cinema
-        cinema_id = booking.get('cinemaId')
-        if cinema_id:
-            cinema_bookings[cinema_id] = cinema_bookings.get(cinema_id, 0) + 1
-        
-        # Count bookings per movie
-        movie_id = booking.get('movieId')
-        if movie_id:
-            movie_bookings[movie_id] = movie_bookings.get(movie_id, 0) + 1
-    
-    analytics = {
-        "totalCinemas": len(cinemas),
-        "totalMovies": len(movies),
-        "totalBookings": len(bookings),
-        "totalShowtimes": len(showtimes),
-        "cinemaBookings": cinema_bookings,
-        "movieBookings": movie_bookings
-    }
-    
-    return jsonify(analytics)
+    try:
+        cinemas = booking_system.getAllCinemas()
+        movies = booking_system.getAllMovies()
+        
+        # Per-cinema and per-movie counts come from the engine's rollups;
+        # active plus cancelled bookings matches the old count of every booking.
+        # Bookings without a usable date are reported apart from the range.
+        def booking_counts(group_by):
+            report = booking_system.analyticsRange("", "", group_by)
+            counts = {}
+            for section in ("totals", "undated"):
+                for key, item in report[section].items():
+                    counts[key] = counts.get(key, 0) + item["bookings"] + item["cancellations"]
+            return counts
+        
+        cinema_bookings = booking_counts("cinema")
+        movie_bookings = booking_counts("movie")
+        
+        analytics = {
+            "totalCinemas": len(cinemas),
+            "totalMovies": len(movies),
+            "totalBookings": sum(cinema_bookings.values()),
+            "totalShowtimes": sum(len(cinema.getShowtimes()) for cinema in cinemas),
+            "cinemaBookings": cinema_bookings,
+            "movieBookings": movie_bookings
+        }
+        
+        # Optional time-range report, e.g. ?from=2025-04-01&to=2025-04-30&groupBy=movie
+        if request.args.get('from') or request.args.get('to'):
+            analytics["range"] = booking_system.analyticsRange(
+                request.args.get('from', ''),
+                request.args.get('to', ''),
+                request.args.get('groupBy', 'total'),
+                request.args.get('granularity', 'day')
+            )
+        
+        return jsonify(analytics)
+    except Exception as e:
+        logger.error(f"Error computing analytics: {str(e)}")
+        return jsonify({"error": "Failed to compute analytics"}), 500
+
+# Engine call counts, latency histograms, lock wait and persistence time;
+# Prometheus text format by default, JSON with ?format=json
+@app.route('/api/metrics', methods=['GET'])
+def engine_metrics():
+    try:
+        if request.args.get('format') == 'json':
+            return jsonify(booking_system.getMetrics())
+        return booking_system.prometheusMetrics(), 200, {'Content-Type': 'text/plain; version=0.0.4; charset=utf-8'}
+    except Exception as e:
+        logger.error(f"Error collecting engine metrics: {str(e)}")
+        return jsonify({"error": "Failed to collect metrics"}), 500
+
+# Engine lock contention profile; PUT {"enabled": true} starts a fresh profile
+@app.route('/api/admin/lock-profile', methods=['GET', 'PUT'])
+def lock_profile():
+    try:
+        if request.method == 'PUT':
+            enabled = bool((request.json or {}).get('enabled', False))
+            booking_system.setLockProfiling(enabled)
+            logger.info(f"Lock profiling {'enabled' if enabled else 'disabled'}")
+        return jsonify(booking_system.lockContentionReport())
+    except Exception as e:
+        logger.error(f"Error updating lock profiling: {str(e)}")
+        return jsonify({"error": str(e)}), 400
+
+# Engine log level, changeable at runtime: PUT {"level": "debug"}
+@app.route('/api/admin/log-level', methods=['GET', 'PUT'])
+def engine_log_level():
+    try:
+        if request.method == 'PUT':
+            cinema_engine.setLogLevel((request.json or {}).get('level', 'info'))
+            logger.info(f"Engine log level set to {cinema_engine.getLogLevel()}")
+        return jsonify({"level": cinema_engine.getLogLevel()})
+    except Exception as e:
+        logger.error(f"Error setting engine log level: {str(e)}")
+        return jsonify({"error": str(e)}), 400
+
+# Recent engine traces, newest first (?limit=50&minMs=10); PUT {"enabled": false} stops tracing
+@app.route('/api/admin/traces', methods=['GET', 'PUT'])
+def engine_traces():
+    try:
+        if request.method == 'PUT':
+            settings = request.json or {}
+            cinema_engine.setTracing(bool(settings.get('enabled', True)), int(settings.get('capacity', 256)))
+            logger.info(f"Engine tracing {'enabled' if cinema_engine.tracingEnabled() else 'disabled'}")
+        return jsonify({
+            "enabled": cinema_engine.tracingEnabled(),
+            "traces": cinema_engine.recentTraces(int(request.args.get('limit', 50)),
+                                                 float(request.args.get('minMs', 0)))
+        })
+    except Exception as e:
+        logger.error(f"Error reading engine traces: {str(e)}")
+        return jsonify({"error": str(e)}), 400
+
+# Chrome trace-event JSON of the stored traces (?requestId= for one), for chrome://tracing or Perfetto
+@app.route('/api/admin/traces/chrome', methods=['GET'])
+def engine_traces_chrome():
+    trace = cinema_engine.chromeTrace(request.args.get('requestId', ''))
+    return trace, 200, {'Content-Type': 'application/json',
+                        'Content-Disposition': 'attachment; filename="engine-trace.json"'}
+
+@app.route('/api/admin/traces/<request_id>', methods=['GET'])
+def engine_trace(request_id):
+    trace = cinema_engine.findTrace(request_id)
+    if trace is None:
+        return jsonify({"error": "Trace not found"}), 404
+    return jsonify(trace)
 
 # Get base endpoint
 @app.route('/api', methods=['GET'])
@@ -715,10 +835,21 @@ def get_showtime(showtime_id):
 @app.route('/api/showtimes/<string:showtime_id>/seats', methods=['GET'])
 def get_booked_seats(showtime_id):
     try:
-        # Get booked seats from the C++ backend
-        booked_seats = booking_system.getBookedSeatsForShowtime(showtime_id)
-        logger.info(f"Returned {len(booked_seats)} booked seats for showtime ID {showtime_id}")
-        return jsonify(booked_seats)
+        # Conditional read against the showtime's seat version; format=bitmap
+        # returns the full seat map with base64 bitsets instead of the booked list
+        etag = request.headers.get('If-None-Match', '').strip('"')
+        seat_format = request.args.get('format', 'list')
+        seat_map = booking_system.getSeatMap(showtime_id, etag, seat_format)
+        if seat_map['notModified']:
+            response = app.response_class(status=304)
+        elif seat_format == 'list':
+            booked_seats = seat_map['booked']
+            logger.info(f"Returned {len(booked_seats)} booked seats for showtime ID {showtime_id}")
+            response = jsonify(booked_seats)
+        else:
+            response = jsonify(dict(seat_map))
+        response.headers['ETag'] = f'"{seat_map["etag"]}"'
+        return response
     except Exception as e:
         logger.error(f"Error fetching seats for showtime {showtime_id}: {str(e)}")
         # Fallback to reading from JSON file if C++ backend fails
@@ -731,6 +862,120 @@ def get_booked_seats(showtime_id):
         logger.info(f"Returned {len(booked_seats)} booked seats from JSON fallback")
         return jsonify(booked_seats)
 
+# Seat deltas since a client's last known version
+@app.route('/api/showtimes/<string:showtime_id>/seats/changes', methods=['GET'])
+def get_seat_changes(showtime_id):
+    try:
+        since = request.args.get('since', default=0, type=int)
+        return jsonify(dict(booking_system.seatChangesSince(showtime_id, since)))
+    except Exception as e:
+        logger.error(f"Error fetching seat changes for showtime {showtime_id}: {str(e)}")
+        return jsonify({"error": "Failed to fetch seat changes"}), 500
+
+# Booked and held seats endpoint
+@app.route('/api/showtimes/<string:showtime_id>/availability', methods=['GET'])
+def get_seat_availability(showtime_id):
+    try:
+        availability = booking_system.getSeatAvailability(showtime_id)
+        return jsonify(dict(availability))
+    except Exception as e:
+        logger.error(f"Error fetching availability for showtime {showtime_id}: {str(e)}")
+        return jsonify({"error": "Failed to fetch seat availability"}), 500
+
+# Seat plan of the screen a showtime runs on
+@app.route('/api/showtimes/<string:showtime_id>/layout', methods=['GET'])
+def get_seat_layout(showtime_id):
+    try:
+        return jsonify(dict(booking_system.getSeatLayout(showtime_id)))
+    except Exception as e:
+        logger.error(f"Error fetching layout for showtime {showtime_id}: {str(e)}")
+        return jsonify({"error": "Failed to fetch seat layout"}), 500
+
+# Server-side price quote for a set of seats
+@app.route('/api/showtimes/<string:showtime_id>/quote', methods=['POST'])
+def quote_seats(showtime_id):
+    try:
+        data = request.json or {}
+        return jsonify(dict(booking_system.quote(showtime_id, data.get('seats', []))))
+    except Exception as e:
+        logger.error(f"Error quoting seats for showtime {showtime_id}: {str(e)}")
+        return jsonify({"error": str(e)}), 400
+
+@app.route('/api/admin/pricing', methods=['GET', 'PUT'])
+def pricing_rules():
+    try:
+        if request.method == 'PUT':
+            booking_system.setPricingRules(request.json or {})
+            logger.info("Updated pricing rules")
+        return jsonify(dict(booking_system.getPricingRules()))
+    except Exception as e:
+        logger.error(f"Error updating pricing rules: {str(e)}")
+        return jsonify({"error": str(e)}), 400
+
+# Best available contiguous seats, optionally held for the user
+@app.route('/api/showtimes/<string:showtime_id>/best-seats', methods=['POST'])
+def find_best_seats(showtime_id):
+    try:
+        data = request.json or {}
+        result = booking_system.findBestSeats(showtime_id, int(data.get('count', 1)), data.get('preferences', {}))
+        return jsonify(dict(result))
+    except cinema_engine.AdmissionError as e:
+        logger.warning(f"Best seat hold not admitted: {str(e)}")
+        return jsonify({"error": str(e)}), 429
+    except Exception as e:
+        logger.error(f"Error finding best seats for showtime {showtime_id}: {str(e)}")
+        return jsonify({"error": str(e)}), 400
+
+# Virtual waiting room for high-demand showtimes
+@app.route('/api/showtimes/<string:showtime_id>/queue', methods=['POST'])
+def enter_waiting_room(showtime_id):
+    try:
+        data = request.json or {}
+        return jsonify(dict(booking_system.enterWaitingRoom(showtime_id, data.get('userId', ''))))
+    except cinema_engine.AdmissionError as e:
+        return jsonify({"error": str(e)}), 429
+
+@app.route('/api/showtimes/<string:showtime_id>/queue/<int:ticket>', methods=['GET'])
+def get_queue_position(showtime_id, ticket):
+    position = booking_system.getQueuePosition(showtime_id, ticket)
+    if position < 0:
+        return jsonify({"error": "Ticket not found or expired"}), 404
+    return jsonify({"ticket": ticket, "position": position})
+
+# Seat hold endpoints
+@app.route('/api/holds', methods=['POST'])
+def hold_seats():
+    try:
+        data = request.json
+        token = booking_system.holdSeats(
+            data['showtimeId'], data['seats'], data['userId'], float(data.get('ttlSeconds', 300)))
+        logger.info(f"Held {len(data['seats'])} seats for showtime {data['showtimeId']}")
+        return jsonify({"holdToken": token})
+    except cinema_engine.AdmissionError as e:
+        logger.warning(f"Seat hold not admitted: {str(e)}")
+        return jsonify({"error": str(e)}), 429
+    except Exception as e:
+        logger.error(f"Error holding seats: {str(e)}")
+        return jsonify({"error": str(e)}), 409
+
+@app.route('/api/holds/<token>/confirm', methods=['POST'])
+def confirm_hold(token):
+    try:
+        booking = booking_system.confirmHold(token, request.json or {})
+        booking_dict = booking.to_dict()
+        logger.info(f"Confirmed hold {token} as booking {booking_dict['id']}")
+        return jsonify(booking_dict)
+    except Exception as e:
+        logger.error(f"Error confirming hold {token}: {str(e)}")
+        return jsonify({"error": str(e)}), 409
+
+@app.route('/api/holds/<token>', methods=['DELETE'])
+def release_hold(token):
+    if booking_system.releaseHold(token):
+        logger.info(f"Released hold {token}")
+        return jsonify({"success": True})
+    return jsonify({"error": "Hold not found"}), 404
+
 # Bookings endpoints
 @app.route('/api/bookings', methods=['POST'])
 def create_booking():
@@ -738,16 +983,39 @@ def create_booking():
         # Get booking data from request
         booking_data = request.json
         
+        # Retries carrying the same Idempotency-Key get the original booking back
+        idempotency_key = request.headers.get('Idempotency-Key')
+        if idempotency_key and 'idempotencyKey' not in booking_data:
+            booking_data['idempotencyKey'] = idempotency_key
+        
         # Create booking using the C++ backend
         booking = booking_system.createBooking(booking_data)
         booking_dict = booking.to_dict()
         
         logger.info(f"Created new booking with ID {booking_dict['id']}")
         return jsonify(booking_dict)
+    except cinema_engine.AdmissionError as e:
+        logger.warning(f"Booking not admitted: {str(e)}")
+        return jsonify({"error": str(e)}), 429
     except Exception as e:
         logger.error(f"Error creating booking: {str(e)}")
         return jsonify({"error": "Failed to create booking"}), 500
 
+# All-or-nothing group booking across one or more showtimes
+@app.route('/api/bookings/batch', methods=['POST'])
+def create_bookings():
+    try:
+        data = request.json or {}
+        bookings = booking_system.createBookings(data.get('bookings', []))
+        logger.info(f"Created batch of {len(bookings)} bookings")
+        return jsonify([booking.to_dict() for booking in bookings])
+    except cinema_engine.AdmissionError as e:
+        logger.warning(f"Booking batch not admitted: {str(e)}")
+        return jsonify({"error": str(e)}), 429
+    except Exception as e:
+        logger.error(f"Error creating booking batch: {str(e)}")
+        return jsonify({"error": str(e)}), 409
+
 @app.route('/api/bookings/<id>', methods=['GET'])
 def get_booking(id):
     try:
@@ -842,6 +1110,7 @@ def sync_showtimes():
 # Add a signal handler to save data when the server shuts down - now disabled
 def signal_handler(sig, frame):
     logger.info("Shutdown signal received. Data saving on shutdown is disabled.")
+    cinema_engine.flushLog()
     sys.exit(0)
 
 # Function to handle cleanup when Flask is running in debug mode - now disabled
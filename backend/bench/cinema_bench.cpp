@@ -0,0 +1,1129 @@
+// Micro-benchmarks for the booking engine's public operations.
+//
+// A small self-contained harness in the style of Google Benchmark: the same
+// registration idiom (BENCHMARK(fn)->ArgsProduct(...)), the same flags
+// (--benchmark_filter, --benchmark_min_time, --benchmark_format,
+// --benchmark_out, --benchmark_context) and the same JSON report layout, so
+// results can be compared with Google Benchmark's tools/compare.py.
+//
+// Datasets are built per (bookings, cinemas) size into a temporary data
+// directory and loaded through the engine's own JSON loaders. Sizes above
+// --max_bookings / --max_cinemas are skipped; the defaults keep a full run
+// to a few minutes. Admission control is disabled so the engine itself is
+// measured, and engine logging is discarded unless --engine_log is given.
+#include "cinema_core.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <random>
+#include <regex>
+#include <thread>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+enum TimeUnit { kNanosecond, kMicrosecond, kMillisecond };
+
+const char* unitName(TimeUnit unit) {
+    switch (unit) {
+        case kNanosecond: return "ns";
+        case kMicrosecond: return "us";
+        case kMillisecond: return "ms";
+    }
+    return "ns";
+}
+
+double unitScale(TimeUnit unit) {
+    switch (unit) {
+        case kNanosecond: return 1e9;
+        case kMicrosecond: return 1e6;
+        case kMillisecond: return 1e3;
+    }
+    return 1e9;
+}
+
+// Process CPU time in seconds
+double cpuSeconds() {
+#ifdef _WIN32
+    return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#else
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+double wallSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Per-run state handed to a benchmark function. The timed region is the
+// `for ([[maybe_unused]] auto _ : state)` loop, minus any PauseTiming/ResumeTiming sections.
+class State {
+public:
+    State(int64_t iterations, std::vector<int64_t> args)
+        : iterations_(iterations), args_(std::move(args)) {}
+
+    int64_t range(size_t index) const { return args_.at(index); }
+    int64_t iterations() const { return iterations_; }
+
+    void PauseTiming() {
+        realSeconds_ += wallSeconds() - realStart_;
+        cpuSeconds_ += cpuSeconds() - cpuStart_;
+    }
+
+    void ResumeTiming() {
+        realStart_ = wallSeconds();
+        cpuStart_ = cpuSeconds();
+    }
+
+    void SetItemsProcessed(int64_t items) { itemsProcessed_ = items; }
+    void SetLabel(const std::string& label) { label_ = label; }
+    void SkipWithError(const std::string& message) {
+        error_ = message;
+        remaining_ = 0;
+    }
+
+    // Custom counters, reported as-is (averaged per iteration by the caller if wanted)
+    std::map<std::string, double> counters;
+
+    struct Iterator {
+        State* state;
+        bool operator!=(const Iterator&) {
+            if (state->remaining_ > 0) {
+                state->remaining_--;
+                return true;
+            }
+            state->PauseTiming();
+            return false;
+        }
+        void operator++() {}
+        int operator*() const { return 0; }
+    };
+
+    Iterator begin() {
+        remaining_ = iterations_;
+        ResumeTiming();
+        return Iterator{this};
+    }
+    Iterator end() { return Iterator{this}; }
+
+private:
+    friend class Runner;
+    int64_t iterations_;
+    int64_t remaining_ = 0;
+    std::vector<int64_t> args_;
+    double realStart_ = 0, cpuStart_ = 0;
+    double realSeconds_ = 0, cpuSeconds_ = 0;
+    int64_t itemsProcessed_ = 0;
+    std::string label_;
+    std::string error_;
+};
+
+class Benchmark {
+public:
+    Benchmark(std::string name, std::function<void(State&)> fn) : name_(std::move(name)), fn_(std::move(fn)) {}
+
+    Benchmark* Args(const std::vector<int64_t>& args) {
+        argSets_.push_back(args);
+        return this;
+    }
+
+    // Cartesian product of the given argument lists
+    Benchmark* ArgsProduct(const std::vector<std::vector<int64_t>>& lists) {
+        std::vector<std::vector<int64_t>> product{{}};
+        for (const auto& list : lists) {
+            std::vector<std::vector<int64_t>> next;
+            for (const auto& prefix : product) {
+                for (int64_t value : list) {
+                    next.push_back(prefix);
+                    next.back().push_back(value);
+                }
+            }
+            product = std::move(next);
+        }
+        argSets_.insert(argSets_.end(), product.begin(), product.end());
+        return this;
+    }
+
+    Benchmark* ArgNames(const std::vector<std::string>& names) {
+        argNames_ = names;
+        return this;
+    }
+
+    Benchmark* Unit(TimeUnit unit) {
+        unit_ = unit;
+        return this;
+    }
+
+    struct Instance {
+        const Benchmark* benchmark;
+        std::string name;
+        std::vector<int64_t> args;
+    };
+
+    std::vector<Instance> instances() const {
+        std::vector<Instance> result;
+        if (argSets_.empty()) {
+            result.push_back({this, name_, {}});
+        }
+        for (const auto& args : argSets_) {
+            std::string name = name_;
+            for (size_t i = 0; i < args.size(); i++) {
+                name += "/";
+                if (i < argNames_.size()) name += argNames_[i] + ":";
+                name += std::to_string(args[i]);
+            }
+            result.push_back({this, name, args});
+        }
+        return result;
+    }
+
+    const std::function<void(State&)>& fn() const { return fn_; }
+    TimeUnit unit() const { return unit_; }
+    const std::vector<std::string>& argNames() const { return argNames_; }
+
+private:
+    std::string name_;
+    std::function<void(State&)> fn_;
+    std::vector<std::vector<int64_t>> argSets_;
+    std::vector<std::string> argNames_;
+    TimeUnit unit_ = kNanosecond;
+};
+
+std::vector<std::unique_ptr<Benchmark>>& registry() {
+    static std::vector<std::unique_ptr<Benchmark>> benchmarks;
+    return benchmarks;
+}
+
+Benchmark* RegisterBenchmark(const char* name, std::function<void(State&)> fn) {
+    registry().push_back(std::make_unique<Benchmark>(name, std::move(fn)));
+    return registry().back().get();
+}
+
+struct Result {
+    std::string name;
+    std::string runName;
+    int64_t iterations = 0;
+    double realTime = 0;  // per iteration, in unit
+    double cpuTime = 0;
+    TimeUnit unit = kNanosecond;
+    double itemsPerSecond = 0;
+    std::string label;
+    std::string error;
+    std::map<std::string, double> counters;
+};
+
+// Runs an instance with a growing iteration count until it takes at least
+// minTime seconds, as Google Benchmark does
+class Runner {
+public:
+    explicit Runner(double minTime) : minTime_(minTime) {}
+
+    Result run(const Benchmark::Instance& instance) const {
+        static constexpr int64_t kMaxIterations = 1000000000;
+        int64_t iterations = 1;
+        while (true) {
+            State state(iterations, instance.args);
+            instance.benchmark->fn()(state);
+
+            bool done = !state.error_.empty() || state.realSeconds_ >= minTime_ || iterations >= kMaxIterations;
+            if (done) {
+                return report(instance, state);
+            }
+            double multiplier = state.realSeconds_ > 0 ? minTime_ * 1.4 / state.realSeconds_ : 100.0;
+            multiplier = std::min(multiplier, 100.0);
+            int64_t next = static_cast<int64_t>(std::llround(iterations * multiplier));
+            iterations = std::min(std::max(next, iterations + 1), kMaxIterations);
+        }
+    }
+
+private:
+    double minTime_;
+
+    static Result report(const Benchmark::Instance& instance, const State& state) {
+        Result result;
+        result.name = instance.name;
+        result.runName = instance.name;
+        result.iterations = state.iterations_;
+        result.unit = instance.benchmark->unit();
+        result.error = state.error_;
+        result.label = state.label_;
+        result.counters = state.counters;
+        if (state.iterations_ > 0) {
+            double scale = unitScale(result.unit);
+            result.realTime = state.realSeconds_ / state.iterations_ * scale;
+            result.cpuTime = state.cpuSeconds_ / state.iterations_ * scale;
+        }
+        if (state.itemsProcessed_ > 0 && state.realSeconds_ > 0) {
+            result.itemsPerSecond = state.itemsProcessed_ / state.realSeconds_;
+        }
+        return result;
+    }
+};
+
+json toJson(const Result& result) {
+    json item;
+    item["name"] = result.name;
+    item["run_name"] = result.runName;
+    item["run_type"] = "iteration";
+    item["repetitions"] = 1;
+    item["repetition_index"] = 0;
+    item["threads"] = 1;
+    item["iterations"] = result.iterations;
+    item["real_time"] = result.realTime;
+    item["cpu_time"] = result.cpuTime;
+    item["time_unit"] = unitName(result.unit);
+    if (result.itemsPerSecond > 0) item["items_per_second"] = result.itemsPerSecond;
+    if (!result.label.empty()) item["label"] = result.label;
+    if (!result.error.empty()) {
+        item["error_occurred"] = true;
+        item["error_message"] = result.error;
+    }
+    for (const auto& [name, value] : result.counters) {
+        item[name] = value;
+    }
+    return item;
+}
+
+std::string hostName() {
+#ifndef _WIN32
+    char name[256] = {0};
+    if (gethostname(name, sizeof(name) - 1) == 0) return name;
+#endif
+    const char* env = std::getenv("COMPUTERNAME");
+    return env ? env : "";
+}
+
+}  // namespace bench
+
+#define BENCH_CONCAT_(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_(a, b)
+#define BENCHMARK(fn) \
+    static ::bench::Benchmark* BENCH_CONCAT(bench_registration_, __LINE__) = ::bench::RegisterBenchmark(#fn, fn)
+
+using bench::State;
+
+// ---------------------------------------------------------------------------
+// Datasets
+
+namespace {
+
+constexpr double kTicketPrice = 300.0;
+constexpr int kSeatsPerBooking = 2;
+// Seats per showtime the dataset fills; the rest of the 140-seat standard
+// layout stays free for the write benchmarks
+constexpr int kFilledSeats = 100;
+
+// Seat labels of the standard layout (rows A-J, aisle after seat 7)
+const std::vector<std::string>& seatLabels() {
+    static const std::vector<std::string> labels = [] {
+        std::vector<std::string> result;
+        for (int row = 0; row < 10; row++) {
+            for (int column = 0; column < 16; column++) {
+                if (column == 7 || column == 8) continue;
+                result.push_back(seat_label(row, column));
+            }
+        }
+        return result;
+    }();
+    return labels;
+}
+
+std::filesystem::path benchRoot() {
+#ifdef _WIN32
+    static const std::string suffix = std::to_string(std::time(nullptr));
+#else
+    static const std::string suffix = std::to_string(getpid());
+#endif
+    return std::filesystem::temp_directory_path() / ("cinema_bench-" + suffix);
+}
+
+// One engine instance loaded with `bookings` bookings spread over `cinemas`
+// cinemas. Benchmarks that write take their seats from the free part of
+// each showtime and add showtimes when those run out.
+struct Dataset {
+    int64_t bookings = 0;
+    int64_t cinemas = 0;
+    std::filesystem::path dir;
+    std::unique_ptr<BookingSystem> system;
+    std::vector<int> movieIds;
+    std::vector<std::string> dates;
+    std::vector<std::string> showtimeIds;
+    std::vector<std::string> userIds;
+    std::vector<std::string> bookingIds;
+    std::unordered_map<std::string, int> nextSeat;  // next free seat index per showtime
+    size_t cursor = 0;                              // round-robin showtime for writes
+    int extraShowtimes = 0;
+
+    // Next free seat pair, adding a showtime when every one is full
+    std::pair<std::string, std::vector<std::string>> freeSeats() {
+        const auto& labels = seatLabels();
+        for (size_t tried = 0; tried < showtimeIds.size(); tried++) {
+            const std::string& showtimeId = showtimeIds[cursor++ % showtimeIds.size()];
+            int& next = nextSeat[showtimeId];
+            if (next + kSeatsPerBooking <= static_cast<int>(labels.size())) {
+                std::vector<std::string> seats(labels.begin() + next, labels.begin() + next + kSeatsPerBooking);
+                next += kSeatsPerBooking;
+                return {showtimeId, seats};
+            }
+        }
+        std::string showtimeId = addShowtime();
+        nextSeat[showtimeId] = kSeatsPerBooking;
+        return {showtimeId, {labels[0], labels[1]}};
+    }
+
+    std::string addShowtime() {
+        std::string id = "show-extra-" + std::to_string(extraShowtimes++);
+        Showtime showtime(id, movieIds[extraShowtimes % movieIds.size()], 1, "Cinema 1",
+                          dates[extraShowtimes % dates.size()], "9:00 PM", "Standard", kTicketPrice);
+        system->addShowtime(showtime);
+        showtimeIds.push_back(id);
+        return id;
+    }
+
+    BookingRequest request(const std::string& showtimeId, const std::vector<std::string>& seats,
+                           const std::string& userId) const {
+        BookingRequest request;
+        request.userId = userId;
+        request.movieId = movieIds[0];
+        request.showtimeId = showtimeId;
+        request.seats = seats;
+        request.totalPrice = kTicketPrice * seats.size();
+        return request;
+    }
+};
+
+std::string dateString(int dayOffset) {
+    std::tm tm = {};
+    tm.tm_year = 2025 - 1900;
+    tm.tm_mon = 4;
+    tm.tm_mday = 1 + dayOffset;
+    tm.tm_hour = 12;
+    std::mktime(&tm);
+    char buffer[16];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d", &tm);
+    return buffer;
+}
+
+void writeDataset(Dataset& data) {
+    static const char* kTimes[] = {"10:00 AM", "1:15 PM", "4:30 PM", "7:45 PM", "10:30 PM"};
+    const int64_t seatsNeeded = data.bookings * kSeatsPerBooking;
+    const int64_t showtimes = std::max<int64_t>(data.cinemas * 4, (seatsNeeded + kFilledSeats - 1) / kFilledSeats);
+    const int64_t perCinema = (showtimes + data.cinemas - 1) / data.cinemas;
+    const int movies = 100;
+    const int days = 14;
+
+    std::filesystem::create_directories(data.dir);
+    for (int i = 0; i < days; i++) data.dates.push_back(dateString(i));
+
+    json moviesJson = json::array();
+    for (int i = 1; i <= movies; i++) {
+        data.movieIds.push_back(i);
+        moviesJson.push_back({{"id", i}, {"title", "Movie " + std::to_string(i)}, {"rating", 7.0},
+                              {"genres", {"Drama"}}, {"cast", {"Actor"}}, {"language", "English"},
+                              {"duration", "2h 10m"}, {"releaseDate", "2025-04-01"}});
+    }
+    std::ofstream(data.dir / "movies.json") << moviesJson.dump();
+
+    {
+        std::ofstream out(data.dir / "cinemas.json");
+        out << "[";
+        int64_t showtime = 0;
+        for (int64_t c = 1; c <= data.cinemas; c++) {
+            json cinema = {{"id", c}, {"name", "Cinema " + std::to_string(c)}, {"location", "City"},
+                           {"screens", 8}, {"totalSeats", 1120}};
+            json list = json::array();
+            for (int64_t k = 0; k < perCinema && showtime < showtimes; k++, showtime++) {
+                std::string id = "show-" + std::to_string(c) + "-" + std::to_string(k);
+                data.showtimeIds.push_back(id);
+                list.push_back({{"id", id}, {"movieId", data.movieIds[showtime % movies]}, {"cinemaId", c},
+                                {"cinemaName", "Cinema " + std::to_string(c)},
+                                {"date", data.dates[k % days]}, {"time", kTimes[k % 5]},
+                                {"screenType", "Standard"}, {"price", kTicketPrice}, {"screen", k % 8}});
+            }
+            cinema["showtimes"] = list;
+            out << (c > 1 ? "," : "") << cinema.dump();
+        }
+        out << "]";
+    }
+
+    // Bookings are streamed out so large sizes do not need one big document here
+    const auto& labels = seatLabels();
+    const int64_t users = std::max<int64_t>(100, data.bookings / 5);
+    std::ofstream out(data.dir / "bookings.json");
+    out << "[";
+    for (int64_t b = 0; b < data.bookings; b++) {
+        const std::string& showtimeId = data.showtimeIds[b % data.showtimeIds.size()];
+        int& next = data.nextSeat[showtimeId];
+        std::vector<std::string> seats(labels.begin() + next, labels.begin() + next + kSeatsPerBooking);
+        next += kSeatsPerBooking;
+        std::string userId = "user-" + std::to_string(b % users);
+        std::string id = "bk-" + std::to_string(b);
+        size_t cinema = b % data.showtimeIds.size() / perCinema + 1;
+        Booking booking(id, userId, data.movieIds[b % movies], "", "", showtimeId,
+                        data.dates[b % days], kTimes[b % 5], static_cast<int>(cinema),
+                        "Cinema " + std::to_string(cinema), "Standard", seats,
+                        kTicketPrice * kSeatsPerBooking, data.dates[b % days], b % 20 == 0);
+        out << (b > 0 ? "," : "") << booking.to_json().dump();
+        if (data.bookingIds.size() < 4096) data.bookingIds.push_back(id);
+        if (data.userIds.size() < 1024 && b < users) data.userIds.push_back(userId);
+    }
+    out << "]";
+}
+
+std::unique_ptr<Dataset> current;
+
+// The dataset for a size, built on first use; only the latest one is kept
+Dataset& dataset(int64_t bookings, int64_t cinemas) {
+    if (current && current->bookings == bookings && current->cinemas == cinemas) {
+        return *current;
+    }
+    if (current) {
+        current->system.reset();
+        std::filesystem::remove_all(current->dir);
+    }
+    current = std::make_unique<Dataset>();
+    current->bookings = bookings;
+    current->cinemas = cinemas;
+    current->dir = benchRoot() / ("b" + std::to_string(bookings) + "-c" + std::to_string(cinemas));
+    writeDataset(*current);
+    current->system = std::make_unique<BookingSystem>(current->dir.string());
+    current->system->loadMovies((current->dir / "movies.json").string());
+    current->system->loadCinemas((current->dir / "cinemas.json").string());
+    AdmissionConfig admission;
+    admission.enabled = false;
+    current->system->configureAdmission(admission);
+    return *current;
+}
+
+const std::vector<int64_t> kBookings = {1000, 10000, 100000, 1000000, 10000000};
+const std::vector<int64_t> kCinemas = {10, 100, 1000, 10000};
+std::atomic<uint64_t> userCounter{0};
+
+std::string freshUser() {
+    return "bench-user-" + std::to_string(userCounter.fetch_add(1));
+}
+
+}  // namespace
+
+// ---------------------------------------------------------------------------
+// Persistence
+
+static void BM_LoadBookings(State& state) {
+    Dataset& data = dataset(state.range(0), 10);
+    for ([[maybe_unused]] auto _ : state) {
+        BookingSystem system(data.dir.string());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LoadBookings)->ArgsProduct({kBookings})->ArgNames({"bookings"})->Unit(bench::kMillisecond);
+
+static void BM_LoadCinemas(State& state) {
+    Dataset& data = dataset(1000, state.range(0));
+    BookingSystem system(data.dir.string());
+    for ([[maybe_unused]] auto _ : state) {
+        system.loadCinemas((data.dir / "cinemas.json").string());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LoadCinemas)->ArgsProduct({kCinemas})->ArgNames({"cinemas"})->Unit(bench::kMillisecond);
+
+static void BM_SaveData(State& state) {
+    Dataset& data = dataset(state.range(0), state.range(1));
+    for ([[maybe_unused]] auto _ : state) {
+        data.system->saveData();
+    }
+}
+BENCHMARK(BM_SaveData)->ArgsProduct({kBookings, {10, 1000}})->ArgNames({"bookings", "cinemas"})
+    ->Unit(bench::kMillisecond);
+
+// ---------------------------------------------------------------------------
+// Catalogue reads
+
+static void BM_GetAllMovies(State& state) {
+    Dataset& data = dataset(1000, 10);
+    for ([[maybe_unused]] auto _ : state) {
+        auto movies = data.system->getAllMovies();
+    }
+}
+BENCHMARK(BM_GetAllMovies)->Unit(bench::kMicrosecond);
+
+static void BM_GetSortedMovies(State& state) {
+    Dataset& data = dataset(1000, 10);
+    for ([[maybe_unused]] auto _ : state) {
+        auto movies = data.system->getSortedMovies();
+    }
+}
+BENCHMARK(BM_GetSortedMovies)->Unit(bench::kMicrosecond);
+
+static void BM_GetPopularMovies(State& state) {
+    Dataset& data = dataset(state.range(0), 10);
+    for ([[maybe_unused]] auto _ : state) {
+        auto movies = data.system->getPopularMovies(10);
+    }
+}
+BENCHMARK(BM_GetPopularMovies)->ArgsProduct({kBookings})->ArgNames({"bookings"})->Unit(bench::kMicrosecond);
+
+static void BM_GetTrendingMovies(State& state) {
+    Dataset& data = dataset(state.range(0), 10);
+    for ([[maybe_unused]] auto _ : state) {
+        auto movies = data.system->getTrendingMovies(10);
+    }
+}
+BENCHMARK(BM_GetTrendingMovies)->ArgsProduct({kBookings})->ArgNames({"bookings"})->Unit(bench::kMicrosecond);
+
+static void BM_GetMovieById(State& state) {
+    Dataset& data = dataset(1000, 10);
+    size_t i = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        Movie movie = data.system->getMovieById(data.movieIds[i++ % data.movieIds.size()]);
+    }
+}
+BENCHMARK(BM_GetMovieById)->Unit(bench::kNanosecond);
+
+static void BM_GetCinemaById(State& state) {
+    Dataset& data = dataset(1000, state.range(0));
+    int64_t i = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        Cinema cinema = data.system->getCinemaById(static_cast<int>(i++ % state.range(0) + 1));
+    }
+}
+BENCHMARK(BM_GetCinemaById)->ArgsProduct({kCinemas})->ArgNames({"cinemas"})->Unit(bench::kMicrosecond);
+
+static void BM_GetShowtimeById(State& state) {
+    Dataset& data = dataset(1000, state.range(0));
+    size_t i = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        Showtime showtime = data.system->getShowtimeById(data.showtimeIds[i++ % data.showtimeIds.size()]);
+    }
+}
+BENCHMARK(BM_GetShowtimeById)->ArgsProduct({kCinemas})->ArgNames({"cinemas"})->Unit(bench::kNanosecond);
+
+static void BM_GetShowtimesByMovie(State& state) {
+    Dataset& data = dataset(1000, state.range(0));
+    size_t i = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        auto showtimes = data.system->getShowtimesByMovie(data.movieIds[i++ % data.movieIds.size()]);
+    }
+}
+BENCHMARK(BM_GetShowtimesByMovie)->ArgsProduct({kCinemas})->ArgNames({"cinemas"})->Unit(bench::kMicrosecond);
+
+static void BM_GetShowtimesByDate(State& state) {
+    Dataset& data = dataset(1000, state.range(0));
+    size_t i = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        auto showtimes = data.system->getShowtimesByDate(data.dates[i++ % data.dates.size()]);
+    }
+}
+BENCHMARK(BM_GetShowtimesByDate)->ArgsProduct({kCinemas})->ArgNames({"cinemas"})->Unit(bench::kMicrosecond);
+
+static void BM_GetShowtimesByMovieAndDate(State& state) {
+    Dataset& data = dataset(1000, state.range(0));
+    size_t i = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        auto showtimes = data.system->getShowtimesByMovieAndDate(data.movieIds[i % data.movieIds.size()],
+                                                                 data.dates[i % data.dates.size()]);
+        i++;
+    }
+}
+BENCHMARK(BM_GetShowtimesByMovieAndDate)->ArgsProduct({kCinemas})->ArgNames({"cinemas"})
+    ->Unit(bench::kMicrosecond);
+
+// ---------------------------------------------------------------------------
+// Seat reads
+
+static void BM_GetBookedSeatsForShowtime(State& state) {
+    Dataset& data = dataset(state.range(0), 10);
+    size_t i = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        auto seats = data.system->getBookedSeatsForShowtime(data.showtimeIds[i++ % data.showtimeIds.size()]);
+    }
+}
+BENCHMARK(BM_GetBookedSeatsForShowtime)->ArgsProduct({kBookings})->ArgNames({"bookings"})
+    ->Unit(bench::kMicrosecond);
+
+static void BM_GetSeatAvailability(State& state) {
+    Dataset& data = dataset(state.range(0), 10);
+    size_t i = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        json availability = data.system->getSeatAvailability(data.showtimeIds[i++ % data.showtimeIds.size()]);
+    }
+}
+BENCHMARK(BM_GetSeatAvailability)->ArgsProduct({kBookings})->ArgNames({"bookings"})->Unit(bench::kMicrosecond);
+
+// format 0 = label lists, 1 = bitmaps
+static void BM_GetSeatMap(State& state) {
+    Dataset& data = dataset(state.range(0), 10);
+    const std::string format = state.range(1) ? "bitmap" : "list";
+    size_t i = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        json map = data.system->getSeatMap(data.showtimeIds[i++ % data.showtimeIds.size()], "", format);
+    }
+}
+BENCHMARK(BM_GetSeatMap)->ArgsProduct({kBookings, {0, 1}})->ArgNames({"bookings", "bitmap"})
+    ->Unit(bench::kMicrosecond);
+
+static void BM_SeatChangesSince(State& state) {
+    Dataset& data = dataset(state.range(0), 10);
+    size_t i = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        json changes = data.system->seatChangesSince(data.showtimeIds[i++ % data.showtimeIds.size()], 0);
+    }
+}
+BENCHMARK(BM_SeatChangesSince)->ArgsProduct({kBookings})->ArgNames({"bookings"})->Unit(bench::kMicrosecond);
+
+static void BM_GetSeatLayout(State& state) {
+    Dataset& data = dataset(1000, 10);
+    for ([[maybe_unused]] auto _ : state) {
+        json layout = data.system->getSeatLayout(data.showtimeIds[0]);
+    }
+}
+BENCHMARK(BM_GetSeatLayout)->Unit(bench::kMicrosecond);
+
+static void BM_Quote(State& state) {
+    Dataset& data = dataset(1000, 10);
+    const std::vector<std::string> seats = {"H3", "H4", "H5", "H6"};
+    size_t i = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        json quote = data.system->quote(data.showtimeIds[i++ % data.showtimeIds.size()], seats);
+    }
+}
+BENCHMARK(BM_Quote)->Unit(bench::kMicrosecond);
+
+static void BM_FindBestSeats(State& state) {
+    Dataset& data = dataset(state.range(0), 10);
+    SeatPreferences preferences;
+    size_t i = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        json block = data.system->findBestSeats(data.showtimeIds[i++ % data.showtimeIds.size()],
+                                                static_cast<int>(state.range(1)), preferences);
+    }
+}
+BENCHMARK(BM_FindBestSeats)->ArgsProduct({{1000, 100000}, {2, 6}})->ArgNames({"bookings", "count"})
+    ->Unit(bench::kMicrosecond);
+
+// ---------------------------------------------------------------------------
+// Writes
+
+static void BM_CreateBooking(State& state) {
+    Dataset& data = dataset(state.range(0), state.range(1));
+    for ([[maybe_unused]] auto _ : state) {
+        state.PauseTiming();
+        auto [showtimeId, seats] = data.freeSeats();
+        BookingRequest request = data.request(showtimeId, seats, freshUser());
+        state.ResumeTiming();
+        data.system->createBooking(request);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CreateBooking)->ArgsProduct({kBookings, kCinemas})->ArgNames({"bookings", "cinemas"})
+    ->Unit(bench::kMicrosecond);
+
+static void BM_CreateBookings(State& state) {
+    Dataset& data = dataset(state.range(0), 10);
+    const int64_t batch = state.range(1);
+    for ([[maybe_unused]] auto _ : state) {
+        state.PauseTiming();
+        std::vector<BookingRequest> requests;
+        for (int64_t i = 0; i < batch; i++) {
+            auto [showtimeId, seats] = data.freeSeats();
+            requests.push_back(data.request(showtimeId, seats, freshUser()));
+        }
+        state.ResumeTiming();
+        data.system->createBookings(requests);
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_CreateBookings)->ArgsProduct({{1000, 100000}, {8, 64}})->ArgNames({"bookings", "batch"})
+    ->Unit(bench::kMicrosecond);
+
+static void BM_HoldAndConfirm(State& state) {
+    Dataset& data = dataset(state.range(0), 10);
+    for ([[maybe_unused]] auto _ : state) {
+        state.PauseTiming();
+        auto [showtimeId, seats] = data.freeSeats();
+        std::string userId = freshUser();
+        BookingRequest request;
+        request.movieId = data.movieIds[0];
+        state.ResumeTiming();
+        std::string token = data.system->holdSeats(showtimeId, seats, userId);
+        data.system->confirmHold(token, request);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HoldAndConfirm)->ArgsProduct({{1000, 100000}})->ArgNames({"bookings"})->Unit(bench::kMicrosecond);
+
+static void BM_HoldAndRelease(State& state) {
+    Dataset& data = dataset(1000, 10);
+    const auto& labels = seatLabels();
+    std::vector<std::string> seats(labels.end() - kSeatsPerBooking, labels.end());
+    size_t i = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        const std::string& showtimeId = data.showtimeIds[i++ % data.showtimeIds.size()];
+        std::string token = data.system->holdSeats(showtimeId, seats, "bench-holder");
+        data.system->releaseHold(token);
+    }
+}
+BENCHMARK(BM_HoldAndRelease)->Unit(bench::kMicrosecond);
+
+static void BM_CancelRestore(State& state) {
+    Dataset& data = dataset(state.range(0), 10);
+    size_t i = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        // Every 20th generated booking starts cancelled; skip those
+        const std::string& id = data.bookingIds[(i++ * 20 + 1) % data.bookingIds.size()];
+        data.system->cancelBooking(id);
+        data.system->restoreBooking(id);
+    }
+}
+BENCHMARK(BM_CancelRestore)->ArgsProduct({kBookings})->ArgNames({"bookings"})->Unit(bench::kMicrosecond);
+
+// Run body(t) on `threads` threads released together; only the run is timed
+template <typename Body>
+static void runTogether(State& state, int threads, Body body) {
+    std::mutex startMutex;
+    std::condition_variable startSignal;
+    bool started = false;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            {
+                std::unique_lock<std::mutex> lock(startMutex);
+                startSignal.wait(lock, [&] { return started; });
+            }
+            body(t);
+        });
+    }
+    state.ResumeTiming();
+    {
+        std::lock_guard<std::mutex> lock(startMutex);
+        started = true;
+    }
+    startSignal.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+// Fresh showtimes with their seat state built, kept away from other writers
+static std::vector<std::string> freshShowtimes(Dataset& data, int count) {
+    std::vector<std::string> showtimes;
+    for (int i = 0; i < count; i++) {
+        std::string id = data.addShowtime();
+        data.nextSeat[id] = static_cast<int>(seatLabels().size());
+        data.system->getSeatAvailability(id);
+        showtimes.push_back(id);
+    }
+    return showtimes;
+}
+
+static void countSeatClaims(State& state, const json& before, const json& after, double attempts) {
+    for (const char* key : {"optimisticClaims", "conflicts", "rejected", "lockedFallbacks"}) {
+        state.counters[key] = (after[key].get<double>() - before[key].get<double>()) / attempts;
+    }
+}
+
+// `threads` buyers race for the same two seats of a fresh showtime, 64
+// showtimes per iteration. One wins each race; the lock-free seat claims turn
+// the rest away without queueing on the engine lock.
+static void BM_SeatContention(State& state) {
+    Dataset& data = dataset(1000, 10);
+    const int threads = static_cast<int>(state.range(0));
+    const int races = 64;
+    json before = data.system->getSeatClaimStats();
+    for ([[maybe_unused]] auto _ : state) {
+        state.PauseTiming();
+        std::vector<std::string> showtimes = freshShowtimes(data, races);
+        runTogether(state, threads, [&](int t) {
+            for (const auto& showtimeId : showtimes) {
+                try {
+                    data.system->createBooking(data.request(showtimeId, {"E7", "E10"}, "racer-" + std::to_string(t)));
+                } catch (const std::exception&) {
+                }
+            }
+        });
+    }
+    const double attempts = static_cast<double>(state.iterations()) * races * threads;
+    countSeatClaims(state, before, data.system->getSeatClaimStats(), attempts);
+    state.SetItemsProcessed(state.iterations() * races * threads);
+}
+BENCHMARK(BM_SeatContention)->ArgsProduct({{1, 2, 4, 8, 16}})->ArgNames({"threads"})->Unit(bench::kMicrosecond);
+
+// `threads` buyers fill a shared showtime together, each booking its own
+// seat pairs (pair p goes to thread p % threads), 8 showtimes per iteration.
+// Nobody conflicts, so throughput should grow with threads.
+static void BM_DisjointBookings(State& state) {
+    Dataset& data = dataset(1000, 10);
+    const int threads = static_cast<int>(state.range(0));
+    const int showtimeCount = 8;
+    const auto& labels = seatLabels();
+    const int pairs = static_cast<int>(labels.size()) / kSeatsPerBooking;
+    json before = data.system->getSeatClaimStats();
+    for ([[maybe_unused]] auto _ : state) {
+        state.PauseTiming();
+        std::vector<std::string> showtimes = freshShowtimes(data, showtimeCount);
+        runTogether(state, threads, [&](int t) {
+            const std::string userId = "buyer-" + std::to_string(t);
+            for (const auto& showtimeId : showtimes) {
+                for (int p = t; p < pairs; p += threads) {
+                    std::vector<std::string> seats(labels.begin() + p * kSeatsPerBooking,
+                                                   labels.begin() + (p + 1) * kSeatsPerBooking);
+                    data.system->createBooking(data.request(showtimeId, seats, userId));
+                }
+            }
+        });
+    }
+    const double bookings = static_cast<double>(state.iterations()) * showtimeCount * pairs;
+    countSeatClaims(state, before, data.system->getSeatClaimStats(), bookings);
+    state.SetItemsProcessed(state.iterations() * showtimeCount * pairs);
+}
+BENCHMARK(BM_DisjointBookings)->ArgsProduct({{1, 2, 4, 8, 16}})->ArgNames({"threads"})->Unit(bench::kMicrosecond);
+
+// ---------------------------------------------------------------------------
+// Lookups by user and analytics
+
+static void BM_GetBookingById(State& state) {
+    Dataset& data = dataset(state.range(0), 10);
+    size_t i = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        Booking booking = data.system->getBookingById(data.bookingIds[i++ % data.bookingIds.size()]);
+    }
+}
+BENCHMARK(BM_GetBookingById)->ArgsProduct({kBookings})->ArgNames({"bookings"})->Unit(bench::kMicrosecond);
+
+static void BM_GetBookingsByUser(State& state) {
+    Dataset& data = dataset(state.range(0), 10);
+    size_t i = 0;
+    for ([[maybe_unused]] auto _ : state) {
+        auto bookings = data.system->getBookingsByUser(data.userIds[i++ % data.userIds.size()]);
+    }
+}
+BENCHMARK(BM_GetBookingsByUser)->ArgsProduct({kBookings})->ArgNames({"bookings"})->Unit(bench::kMicrosecond);
+
+static void BM_GetAllBookings(State& state) {
+    Dataset& data = dataset(state.range(0), 10);
+    for ([[maybe_unused]] auto _ : state) {
+        auto bookings = data.system->getAllBookings();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetAllBookings)->ArgsProduct({kBookings})->ArgNames({"bookings"})->Unit(bench::kMillisecond);
+
+static void BM_GetAnalytics(State& state) {
+    Dataset& data = dataset(state.range(0), 10);
+    const bool approximate = state.range(1) != 0;
+    for ([[maybe_unused]] auto _ : state) {
+        json analytics = data.system->getAnalytics(approximate);
+    }
+}
+BENCHMARK(BM_GetAnalytics)->ArgsProduct({kBookings, {0, 1}})->ArgNames({"bookings", "approximate"})
+    ->Unit(bench::kMicrosecond);
+
+static void BM_BookingReport(State& state) {
+    static const char* kGroups[] = {"movie", "cinema", "user", "day"};
+    Dataset& data = dataset(state.range(0), 100);
+    const std::string groupBy = kGroups[state.range(1)];
+    for ([[maybe_unused]] auto _ : state) {
+        json report = data.system->bookingReport(groupBy);
+    }
+    state.SetLabel(groupBy);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BookingReport)->ArgsProduct({kBookings, {0, 1, 2, 3}})->ArgNames({"bookings", "groupBy"})
+    ->Unit(bench::kMillisecond);
+
+static void BM_AnalyticsRange(State& state) {
+    Dataset& data = dataset(state.range(0), 100);
+    for ([[maybe_unused]] auto _ : state) {
+        json range = data.system->analyticsRange(data.dates.front(), data.dates.back(), "movie", "day");
+    }
+}
+BENCHMARK(BM_AnalyticsRange)->ArgsProduct({kBookings})->ArgNames({"bookings"})->Unit(bench::kMicrosecond);
+
+// ---------------------------------------------------------------------------
+
+namespace {
+
+bool flagValue(const std::string& arg, const std::string& flag, std::string& value) {
+    const std::string prefix = "--" + flag + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) return false;
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+// Skip instances whose "bookings" or "cinemas" argument exceeds the caps
+bool withinLimits(const bench::Benchmark::Instance& instance, int64_t maxBookings, int64_t maxCinemas) {
+    const auto& names = instance.benchmark->argNames();
+    for (size_t i = 0; i < instance.args.size() && i < names.size(); i++) {
+        if (names[i] == "bookings" && instance.args[i] > maxBookings) return false;
+        if (names[i] == "cinemas" && instance.args[i] > maxCinemas) return false;
+    }
+    return true;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "usage: " << program << " [--benchmark_filter=<regex>] [--benchmark_min_time=<seconds>]\n"
+              << "       [--benchmark_format=console|json] [--benchmark_out=<file>]\n"
+              << "       [--benchmark_context=<key>=<value>]... [--benchmark_list_tests]\n"
+              << "       [--max_bookings=<n>] [--max_cinemas=<n>] [--engine_log]\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string filter = ".";
+    double minTime = 0.5;
+    std::string format = "console";
+    std::string outFile;
+    bool listOnly = false;
+    bool engineLog = false;
+    int64_t maxBookings = 100000;
+    int64_t maxCinemas = 1000;
+    std::map<std::string, std::string> context;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i], value;
+        if (flagValue(arg, "benchmark_filter", value)) {
+            filter = value;
+        } else if (flagValue(arg, "benchmark_min_time", value)) {
+            minTime = std::stod(value);  // "0.5" or "0.5s"
+        } else if (flagValue(arg, "benchmark_format", value)) {
+            format = value;
+        } else if (flagValue(arg, "benchmark_out", value)) {
+            outFile = value;
+        } else if (flagValue(arg, "benchmark_out_format", value)) {
+            if (value != "json") {
+                std::cerr << "Only json output files are supported" << std::endl;
+                return 1;
+            }
+        } else if (flagValue(arg, "benchmark_context", value)) {
+            size_t eq = value.find('=');
+            if (eq == std::string::npos) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            context[value.substr(0, eq)] = value.substr(eq + 1);
+        } else if (arg == "--benchmark_list_tests" || arg == "--benchmark_list_tests=true") {
+            listOnly = true;
+        } else if (flagValue(arg, "max_bookings", value)) {
+            maxBookings = std::stoll(value);
+        } else if (flagValue(arg, "max_cinemas", value)) {
+            maxCinemas = std::stoll(value);
+        } else if (arg == "--engine_log") {
+            engineLog = true;
+        } else {
+            printUsage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    if (format != "console" && format != "json") {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::regex pattern(filter);
+    std::vector<bench::Benchmark::Instance> instances;
+    for (const auto& benchmark : bench::registry()) {
+        for (const auto& instance : benchmark->instances()) {
+            if (std::regex_search(instance.name, pattern) && withinLimits(instance, maxBookings, maxCinemas)) {
+                instances.push_back(instance);
+            }
+        }
+    }
+    if (listOnly) {
+        for (const auto& instance : instances) std::cout << instance.name << "\n";
+        return 0;
+    }
+
+    // Results go to stdout; the engine's own logging is off unless asked for
+    std::ostream out(std::cout.rdbuf());
+    std::ostream err(std::cerr.rdbuf());
+    if (!engineLog) {
+        setLogLevel(LogLevel::Off);
+    }
+
+    json report;
+    auto now = std::time(nullptr);
+    char date[64];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+    report["context"] = {
+        {"date", date},
+        {"host_name", bench::hostName()},
+        {"executable", argv[0]},
+        {"num_cpus", std::thread::hardware_concurrency()},
+#ifdef NDEBUG
+        {"library_build_type", "release"},
+#else
+        {"library_build_type", "debug"},
+#endif
+    };
+    for (const auto& [key, value] : context) report["context"][key] = value;
+    report["benchmarks"] = json::array();
+
+    if (format == "console") {
+        out << std::left << std::setw(56) << "Benchmark" << std::right << std::setw(14) << "Time"
+            << std::setw(14) << "CPU" << std::setw(12) << "Iterations" << "\n"
+            << std::string(96, '-') << std::endl;
+    }
+    bench::Runner runner(minTime);
+    int failures = 0;
+    for (const auto& instance : instances) {
+        bench::Result result;
+        try {
+            result = runner.run(instance);
+        } catch (const std::exception& e) {
+            result.name = result.runName = instance.name;
+            result.unit = instance.benchmark->unit();
+            result.error = e.what();
+        }
+        if (!result.error.empty()) failures++;
+        report["benchmarks"].push_back(bench::toJson(result));
+        if (format == "console") {
+            out << std::left << std::setw(56) << result.name << std::right;
+            if (!result.error.empty()) {
+                out << " ERROR: " << result.error << std::endl;
+                continue;
+            }
+            const char* unit = bench::unitName(result.unit);
+            out << std::setw(11) << std::fixed << std::setprecision(1) << result.realTime << " " << std::setw(2) << unit
+                << std::setw(11) << result.cpuTime << " " << std::setw(2) << unit
+                << std::setw(12) << result.iterations;
+            if (result.itemsPerSecond > 0) {
+                out << " items_per_second=" << std::setprecision(0) << result.itemsPerSecond;
+            }
+            for (const auto& [name, value] : result.counters) {
+                out << " " << name << "=" << std::setprecision(3) << value;
+            }
+            if (!result.label.empty()) out << " " << result.label;
+            out << std::endl;
+        }
+    }
+
+    current.reset();
+    std::error_code ignored;
+    std::filesystem::remove_all(benchRoot(), ignored);
+    flushLog();
+
+    if (format == "json") {
+        out << report.dump(2) << std::endl;
+    }
+    if (!outFile.empty()) {
+        std::ofstream file(outFile);
+        if (!file) {
+            err << "Could not write " << outFile << std::endl;
+            return 1;
+        }
+        file << report.dump(2) << std::endl;
+    }
+    return failures > 0 ? 1 : 0;
+}
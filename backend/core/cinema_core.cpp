@@ -0,0 +1,6130 @@
+#include "cinema_core.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <mutex>
+#include <memory>
+#include <ctime>
+#include <random>
+#include <unordered_set>
+#include <chrono>
+#include <iomanip>
+#include <nlohmann/json.hpp>
+#include <filesystem> // Include filesystem for path resolution
+#include <queue>
+#include <map>
+#include <set>
+#include <list>
+#include <unordered_map>
+#include <functional>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <array>
+#include <bitset>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <shared_mutex>
+#include <exception>
+#include <limits>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <direct.h>
+#include <windows.h>
+#include <intrin.h>
+#else
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Function to generate unique IDs
+std::string generate_uuid() {
+    static std::random_device rd;
+    static std::mt19937 gen(rd());
+    static std::uniform_int_distribution<> dis(0, 15);
+    static std::uniform_int_distribution<> dis2(8, 11);
+#ifndef _WIN32
+    // A forked worker inherits the generator state; reseed so workers sharing
+    // a seat inventory do not hand out the same ids
+    static pid_t seededBy = getpid();
+    if (getpid() != seededBy) {
+        seededBy = getpid();
+        gen.seed(rd() ^ static_cast<unsigned>(seededBy));
+    }
+#endif
+
+    std::stringstream ss;
+    ss << std::hex;
+
+    for (int i = 0; i < 8; i++) {
+        ss << dis(gen);
+    }
+    ss << "-";
+    for (int i = 0; i < 4; i++) {
+        ss << dis(gen);
+    }
+    ss << "-4";
+    for (int i = 3; i > 0; i--) {
+        ss << dis(gen);
+    }
+    ss << "-";
+    ss << dis2(gen);
+    for (int i = 0; i < 3; i++) {
+        ss << dis(gen);
+    }
+    ss << "-";
+    for (int i = 0; i < 12; i++) {
+        ss << dis(gen);
+    };
+    return ss.str();
+}
+
+// Function to get current date as string
+std::string get_current_date() {
+    auto now = std::chrono::system_clock::now();
+    auto in_time_t = std::chrono::system_clock::to_time_t(now);
+
+    std::stringstream ss;
+    ss << std::put_time(std::localtime(&in_time_t), "%Y-%m-%d");
+    return ss.str();
+}
+
+// Current wall-clock time in seconds since the epoch
+double now_seconds() {
+    return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Monotonic seconds for rates, deadlines and TTLs, which must not jump with
+// the wall clock
+double steady_seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date (Howard Hinnant's algorithm)
+long long days_from_civil(int y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const long long era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<long long>(doe) - 719468;
+}
+
+// Inverse of days_from_civil, formatted as YYYY-MM-DD
+std::string civil_from_days(long long z) {
+    z += 719468;
+    const long long era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+    const long long y = static_cast<long long>(yoe) + era * 400 + (m <= 2);
+    
+    // Sized for the widest long long year so the output is never truncated
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%04lld-%02u-%02u", y, m, d);
+    return buffer;
+}
+
+// Parse "YYYY-MM-DD" into days since epoch; returns false if malformed
+bool parse_date(const std::string& date, long long& days) {
+    int y = 0;
+    unsigned m = 0, d = 0;
+    if (std::sscanf(date.c_str(), "%d-%u-%u", &y, &m, &d) != 3 || m < 1 || m > 12 || d < 1 || d > 31) {
+        return false;
+    }
+    days = days_from_civil(y, m, d);
+    return true;
+}
+
+// Parse "10:30 AM" or "19:30" into the hour of day; returns -1 if malformed
+int parse_hour(const std::string& time) {
+    int hour = 0, minute = 0;
+    char suffix[3] = {0};
+    int fields = std::sscanf(time.c_str(), "%d:%d %2s", &hour, &minute, suffix);
+    if (fields < 2 || hour < 0 || hour > 23) {
+        return -1;
+    }
+    if (fields == 3) {
+        bool pm = (suffix[0] == 'P' || suffix[0] == 'p');
+        if (hour < 1 || hour > 12) return -1;
+        hour = (hour % 12) + (pm ? 12 : 0);
+    }
+    return hour;
+}
+
+// Helper function to trim whitespace from a string
+std::string trim(const std::string& str) {
+    size_t first = str.find_first_not_of(" \t\n\r");
+    if (first == std::string::npos)
+        return "";
+    size_t last = str.find_last_not_of(" \t\n\r");
+    return str.substr(first, last - first + 1);
+}
+
+// Mix a 64-bit value so that nearby inputs spread over all bits (splitmix64 finalizer)
+inline uint64_t mix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+inline uint64_t hash64(const std::string& value) {
+    return mix64(std::hash<std::string>{}(value));
+}
+
+inline uint64_t hash64(int value) {
+    return mix64(static_cast<uint64_t>(static_cast<uint32_t>(value)));
+}
+
+// Number of leading zero bits; x must be non-zero
+inline int countLeadingZeros64(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return 63 - static_cast<int>(index);
+#else
+    return __builtin_clzll(x);
+#endif
+}
+
+// Number of trailing zero bits; x must be non-zero
+inline int countTrailingZeros64(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+// Spin-wait hint for busy loops
+inline void cpuRelax() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Standard base64 with padding
+std::string base64_encode(const std::vector<uint8_t>& data) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((data.size() + 2) / 3 * 4);
+    for (size_t i = 0; i < data.size(); i += 3) {
+        uint32_t chunk = uint32_t(data[i]) << 16;
+        if (i + 1 < data.size()) chunk |= uint32_t(data[i + 1]) << 8;
+        if (i + 2 < data.size()) chunk |= data[i + 2];
+        out += alphabet[(chunk >> 18) & 63];
+        out += alphabet[(chunk >> 12) & 63];
+        out += i + 1 < data.size() ? alphabet[(chunk >> 6) & 63] : '=';
+        out += i + 2 < data.size() ? alphabet[chunk & 63] : '=';
+    }
+    return out;
+}
+
+// Seat labels are a row letter followed by a 1-based seat number ("G12")
+bool parse_seat_label(const std::string& label, int& row, int& column) {
+    if (label.size() < 2 || label[0] < 'A' || label[0] > 'Z') return false;
+    int number = 0;
+    for (size_t i = 1; i < label.size(); i++) {
+        if (label[i] < '0' || label[i] > '9' || number > 9999) return false;
+        number = number * 10 + (label[i] - '0');
+    }
+    if (number < 1) return false;
+    row = label[0] - 'A';
+    column = number - 1;
+    return true;
+}
+
+std::string seat_label(int row, int column) {
+    return std::string(1, static_cast<char>('A' + row)) + std::to_string(column + 1);
+}
+
+// Split [0, count) into one contiguous chunk per thread, fold each chunk into a
+// thread-local partial and merge the partials in chunk order, so results do not
+// depend on scheduling. Uses OpenMP when built with it, std::thread otherwise.
+// An exception thrown by `fold` is carried out of the worker and rethrown once
+// every chunk has finished (the lowest-numbered failing chunk wins).
+template <typename Partial, typename Fold, typename Merge>
+Partial parallel_reduce(size_t count, Fold fold, Merge merge, size_t minChunk = 4096) {
+#ifdef _OPENMP
+    size_t maxThreads = static_cast<size_t>(omp_get_max_threads());
+#else
+    size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+#endif
+    size_t threads = std::max<size_t>(1, std::min(maxThreads, count / minChunk));
+    std::vector<Partial> partials(threads);
+    std::vector<std::exception_ptr> errors(threads);
+    
+    auto foldChunk = [&](size_t t) {
+        size_t begin = count * t / threads;
+        size_t end = count * (t + 1) / threads;
+        try {
+            for (size_t i = begin; i < end; i++) {
+                fold(partials[t], i);
+            }
+        } catch (...) {
+            errors[t] = std::current_exception();
+        }
+    };
+    
+    if (threads == 1) {
+        foldChunk(0);
+    } else {
+#ifdef _OPENMP
+        #pragma omp parallel for num_threads(static_cast<int>(threads)) schedule(static, 1)
+        for (long long t = 0; t < static_cast<long long>(threads); t++) {
+            foldChunk(static_cast<size_t>(t));
+        }
+#else
+        std::vector<std::thread> workers;
+        for (size_t t = 1; t < threads; t++) {
+            workers.emplace_back(foldChunk, t);
+        }
+        foldChunk(0);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+#endif
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    
+    Partial result = std::move(partials[0]);
+    for (size_t t = 1; t < threads; t++) {
+        merge(result, partials[t]);
+    }
+    return result;
+}
+
+// Small stable number for the calling thread, for log lines and traces
+inline uint32_t threadNumber() {
+    static std::atomic<uint32_t> next{1};
+    thread_local uint32_t number = next.fetch_add(1, std::memory_order_relaxed);
+    return number;
+}
+
+// Request ID of the trace open on this thread, if any (see Tracer)
+const std::string* currentRequestId();
+
+// Engine logger. Callers format nothing: a record (level, time, thread,
+// request ID, message, JSON fields) is moved into a bounded lock-free ring and a
+// background thread formats and writes it - info and debug to stdout, warn
+// and error to stderr - flushing once per batch. When the ring is full the
+// record is dropped and counted instead of blocking the caller.
+class Logger {
+public:
+    static Logger& instance() {
+        static Logger logger;
+        return logger;
+    }
+    
+    bool enabled(LogLevel level) const {
+        return static_cast<int>(level) >= level_.load(std::memory_order_relaxed);
+    }
+    void setLevel(LogLevel level) { level_.store(static_cast<int>(level), std::memory_order_relaxed); }
+    LogLevel level() const { return static_cast<LogLevel>(level_.load(std::memory_order_relaxed)); }
+    void setFormat(LogFormat format) { format_.store(static_cast<int>(format), std::memory_order_relaxed); }
+    
+    void write(LogLevel level, std::string message, json fields = json::object()) {
+        // Off is a threshold, not a record level; format() has no name for it
+        if (level == LogLevel::Off) return;
+        // Multi-producer enqueue on a ring of sequenced slots (Vyukov)
+        size_t position = tail_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[position & (kCapacity - 1)];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            } else {
+                position = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->record.level = level;
+        slot->record.time = std::chrono::system_clock::now();
+        slot->record.thread = threadNumber();
+        const std::string* requestId = currentRequestId();
+        slot->record.requestId = requestId ? *requestId : std::string();
+        slot->record.message = std::move(message);
+        slot->record.fields = std::move(fields);
+        slot->sequence.store(position + 1, std::memory_order_release);
+        if (idle_.load(std::memory_order_relaxed)) wake_.notify_one();
+    }
+    
+    // Wait until everything logged so far has been written and flushed
+    void flush() {
+        size_t target = tail_.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.notify_one();
+        flushed_.wait(lock, [&] { return written_ >= target || stopping_; });
+    }
+    
+private:
+    static constexpr size_t kCapacity = 8192;
+    
+    struct Record {
+        LogLevel level = LogLevel::Info;
+        std::chrono::system_clock::time_point time;
+        uint32_t thread = 0;
+        std::string requestId;
+        std::string message;
+        json fields;
+    };
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        Record record;
+    };
+    
+    Logger() : slots_(kCapacity) {
+        for (size_t i = 0; i < kCapacity; i++) slots_[i].sequence.store(i, std::memory_order_relaxed);
+        writer_ = std::thread([this] { run(); });
+    }
+    
+    ~Logger() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        writer_.join();
+    }
+    
+    // Single consumer: take the next published record, if any
+    bool pop(Record& record) {
+        Slot& slot = slots_[head_ & (kCapacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != head_ + 1) return false;
+        record = std::move(slot.record);
+        slot.sequence.store(head_ + kCapacity, std::memory_order_release);
+        head_++;
+        return true;
+    }
+    
+    void run() {
+        std::string out, err;
+        Record record;
+        for (;;) {
+            size_t count = 0;
+            while (count < kCapacity && pop(record)) {
+                format(record, record.level >= LogLevel::Warn ? err : out);
+                count++;
+            }
+            uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+            if (dropped > 0) {
+                Record note;
+                note.level = LogLevel::Warn;
+                note.time = std::chrono::system_clock::now();
+                note.message = "Log lines dropped, ring buffer full";
+                note.fields = {{"dropped", dropped}};
+                format(note, err);
+            }
+            if (!out.empty()) {
+                std::cout << out << std::flush;
+                out.clear();
+            }
+            if (!err.empty()) {
+                std::cerr << err << std::flush;
+                err.clear();
+            }
+            
+            std::unique_lock<std::mutex> lock(mutex_);
+            written_ = head_;
+            flushed_.notify_all();
+            if (count == 0 && dropped == 0) {
+                if (stopping_) return;
+                // Producers only notify while idle_ is set; the timeout covers
+                // a notify that lands just before the wait
+                idle_.store(true, std::memory_order_relaxed);
+                wake_.wait_for(lock, std::chrono::milliseconds(50));
+                idle_.store(false, std::memory_order_relaxed);
+            }
+        }
+    }
+    
+    void format(const Record& record, std::string& out) const {
+        static const char* const kLevelNames[] = {"debug", "info", "warn", "error"};
+        const char* level = kLevelNames[static_cast<int>(record.level)];
+        
+        auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(record.time.time_since_epoch()).count();
+        std::time_t seconds = static_cast<std::time_t>(millis / 1000);
+        std::tm utc{};
+#ifdef _WIN32
+        gmtime_s(&utc, &seconds);
+#else
+        gmtime_r(&seconds, &utc);
+#endif
+        // Sized for any int tm_year so the timestamp is never truncated
+        char time[64];
+        std::snprintf(time, sizeof(time), "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ", utc.tm_year + 1900,
+                      utc.tm_mon + 1, utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec,
+                      static_cast<int>(millis % 1000));
+        
+        if (static_cast<LogFormat>(format_.load(std::memory_order_relaxed)) == LogFormat::Json) {
+            // Written by hand so the common keys lead each line
+            out += "{\"time\":\"";
+            out += time;
+            out += "\",\"level\":\"";
+            out += level;
+            out += "\",\"thread\":" + std::to_string(record.thread);
+            if (!record.requestId.empty()) {
+                out += ",\"requestId\":";
+                out += json(record.requestId).dump(-1, ' ', false, json::error_handler_t::replace);
+            }
+            out += ",\"message\":";
+            out += json(record.message).dump(-1, ' ', false, json::error_handler_t::replace);
+            if (record.fields.is_object()) {
+                for (const auto& [key, value] : record.fields.items()) {
+                    out += ',';
+                    out += json(key).dump();
+                    out += ':';
+                    out += value.dump(-1, ' ', false, json::error_handler_t::replace);
+                }
+            }
+            out += "}\n";
+            return;
+        }
+        
+        // 2025-04-01T18:30:00.125Z INFO  [3 7f3c...] Created booking bookingId=... seats=2
+        out += time;
+        out += ' ';
+        for (const char* c = level; *c; c++) out += static_cast<char>(std::toupper(static_cast<unsigned char>(*c)));
+        out.append(6 - std::strlen(level), ' ');
+        out += '[' + std::to_string(record.thread);
+        if (!record.requestId.empty()) out += ' ' + record.requestId;
+        out += "] ";
+        out += record.message;
+        if (record.fields.is_object()) {
+            for (const auto& [key, value] : record.fields.items()) {
+                out += ' ';
+                out += key;
+                out += '=';
+                if (value.is_string()) {
+                    const std::string& text = value.get_ref<const std::string&>();
+                    bool bare = !text.empty() && text.find_first_of(" \"=") == std::string::npos;
+                    out += bare ? text : value.dump(-1, ' ', false, json::error_handler_t::replace);
+                } else {
+                    out += value.dump(-1, ' ', false, json::error_handler_t::replace);
+                }
+            }
+        }
+        out += '\n';
+    }
+    
+    std::vector<Slot> slots_;
+    std::atomic<size_t> tail_{0};
+    size_t head_ = 0;                       // Writer thread only
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<int> level_{static_cast<int>(LogLevel::Info)};
+    std::atomic<int> format_{static_cast<int>(LogFormat::Text)};
+    std::atomic<bool> idle_{false};
+    
+    std::mutex mutex_;                      // Guards written_ and stopping_
+    std::condition_variable wake_;
+    std::condition_variable flushed_;
+    size_t written_ = 0;
+    bool stopping_ = false;
+    std::thread writer_;
+};
+
+// ENGINE_LOG(LogLevel::Info, "Loaded movies", {{"count", n}, {"file", name}});
+// The message and fields are not evaluated unless the level is enabled.
+#define ENGINE_LOG(level, ...)                                   \
+    do {                                                         \
+        if (Logger::instance().enabled(level)) {                 \
+            Logger::instance().write(level, __VA_ARGS__);        \
+        }                                                        \
+    } while (0)
+
+void setLogLevel(LogLevel level) { Logger::instance().setLevel(level); }
+LogLevel getLogLevel() { return Logger::instance().level(); }
+void setLogFormat(LogFormat format) { Logger::instance().setFormat(format); }
+bool logEnabled(LogLevel level) { return Logger::instance().enabled(level); }
+void flushLog() { Logger::instance().flush(); }
+
+void logEvent(LogLevel level, const std::string& message, const json& fields) {
+    ENGINE_LOG(level, message, fields);
+}
+
+bool parse_log_level(const std::string& name, LogLevel& level) {
+    static const std::pair<const char*, LogLevel> kLevels[] = {
+        {"debug", LogLevel::Debug}, {"info", LogLevel::Info}, {"warn", LogLevel::Warn},
+        {"warning", LogLevel::Warn}, {"error", LogLevel::Error}, {"off", LogLevel::Off}
+    };
+    std::string lower = trim(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+    for (const auto& [label, value] : kLevels) {
+        if (lower == label) {
+            level = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Trace spans. A trace is one request on one thread: a root span - begun by
+// the Python layer with its request ID, or by the first public call on a
+// thread with no trace open - and every span opened on that thread until the
+// root closes. Spans collect in a thread-local buffer without locking; the
+// finished trace is moved into a ring of recent traces. Tracing is off by
+// default, and a span opened while it is off is a single relaxed load.
+struct TraceSpanRecord {
+    const char* name;       // Null for the root, which is named by the trace
+    uint64_t startNs;
+    uint64_t durationNs;
+    int parent;
+    int depth;
+};
+
+struct TraceRecord {
+    std::string requestId;
+    std::string name;
+    uint32_t thread = 0;
+    int64_t startUnixUs = 0;
+    uint64_t startNs = 0;
+    uint64_t durationNs = 0;
+    uint32_t droppedSpans = 0;
+    std::vector<TraceSpanRecord> spans;     // spans[0] is the root
+    
+    json to_json() const {
+        json spansJson = json::array();
+        for (const auto& span : spans) {
+            spansJson.push_back({
+                {"name", span.name ? span.name : name},
+                {"parent", span.parent},
+                {"depth", span.depth},
+                {"startUs", (span.startNs - startNs) / 1e3},
+                {"durationUs", span.durationNs / 1e3}
+            });
+        }
+        return {
+            {"requestId", requestId},
+            {"name", name},
+            {"thread", thread},
+            {"start", startUnixUs / 1e6},
+            {"durationUs", durationNs / 1e3},
+            {"droppedSpans", droppedSpans},
+            {"spans", spansJson}
+        };
+    }
+};
+
+class Tracer {
+public:
+    static constexpr size_t kMaxSpans = 1024;   // Per trace; further spans are counted, not kept
+    
+    static Tracer& instance() {
+        static Tracer tracer;
+        return tracer;
+    }
+    
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+    
+    void setEnabled(bool enabled, size_t capacity) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = std::max<size_t>(capacity, 1);
+        while (traces_.size() > capacity_) traces_.pop_front();
+        enabled_.store(enabled, std::memory_order_relaxed);
+    }
+    
+    uint64_t nowNs() const {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch_).count());
+    }
+    
+    // Wall-clock microseconds of a tracer timestamp
+    int64_t unixMicros(uint64_t ns) const { return epochUnixUs_ + static_cast<int64_t>(ns / 1000); }
+    
+    std::string nextRequestId() {
+        std::ostringstream id;
+        id << "engine-" << processId() << "-" << nextId_.fetch_add(1, std::memory_order_relaxed);
+        return id.str();
+    }
+    
+    void store(TraceRecord&& trace) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        traces_.push_back(std::move(trace));
+        while (traces_.size() > capacity_) traces_.pop_front();
+    }
+    
+    // Newest first, at most `limit`, only traces at least `minDurationMs` long
+    json recent(size_t limit, double minDurationMs) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        json result = json::array();
+        for (auto it = traces_.rbegin(); it != traces_.rend() && result.size() < limit; ++it) {
+            if (it->durationNs / 1e6 >= minDurationMs) result.push_back(it->to_json());
+        }
+        return result;
+    }
+    
+    json find(const std::string& requestId) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = traces_.rbegin(); it != traces_.rend(); ++it) {
+            if (it->requestId == requestId) return it->to_json();
+        }
+        return nullptr;
+    }
+    
+    // Chrome trace-event format: one complete ("X") event per span, loadable
+    // in chrome://tracing or Perfetto. An empty requestId exports every trace.
+    json chrome(const std::string& requestId) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        json events = json::array();
+        int pid = processId();
+        for (const auto& trace : traces_) {
+            if (!requestId.empty() && trace.requestId != requestId) continue;
+            for (const auto& span : trace.spans) {
+                json event = {
+                    {"name", span.name ? span.name : trace.name},
+                    {"cat", "engine"},
+                    {"ph", "X"},
+                    {"ts", trace.startUnixUs + (span.startNs - trace.startNs) / 1e3},
+                    {"dur", span.durationNs / 1e3},
+                    {"pid", pid},
+                    {"tid", trace.thread},
+                    {"args", {{"requestId", trace.requestId}}}
+                };
+                if (!span.name && trace.droppedSpans > 0) event["args"]["droppedSpans"] = trace.droppedSpans;
+                events.push_back(std::move(event));
+            }
+        }
+        return {{"traceEvents", events}, {"displayTimeUnit", "ms"}};
+    }
+    
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        traces_.clear();
+    }
+    
+private:
+    Tracer()
+        : epoch_(std::chrono::steady_clock::now()),
+          epochUnixUs_(std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::system_clock::now().time_since_epoch()).count()) {}
+    
+    static int processId() {
+#ifdef _WIN32
+        return static_cast<int>(GetCurrentProcessId());
+#else
+        return static_cast<int>(getpid());
+#endif
+    }
+    
+    const std::chrono::steady_clock::time_point epoch_;
+    const int64_t epochUnixUs_;
+    std::atomic<bool> enabled_{false};
+    std::atomic<uint64_t> nextId_{1};
+    mutable std::mutex mutex_;
+    std::deque<TraceRecord> traces_;
+    size_t capacity_ = 256;
+};
+
+// The trace being recorded on this thread
+struct ThreadTrace {
+    bool active = false;
+    uint64_t generation = 0;    // Bumped per trace; spans of an earlier trace leave this one alone
+    TraceRecord trace;
+    std::vector<int> open;      // Indexes of open spans, innermost last
+    
+    static ThreadTrace& current() {
+        thread_local ThreadTrace threadTrace;
+        return threadTrace;
+    }
+    
+    void begin(std::string requestId, std::string name) {
+        Tracer& tracer = Tracer::instance();
+        uint64_t now = tracer.nowNs();
+        trace = TraceRecord{};
+        trace.requestId = std::move(requestId);
+        trace.name = std::move(name);
+        trace.thread = threadNumber();
+        trace.startNs = now;
+        trace.startUnixUs = tracer.unixMicros(now);
+        trace.spans.reserve(16);
+        trace.spans.push_back({nullptr, now, 0, -1, 0});
+        open.assign(1, 0);
+        generation++;
+        active = true;
+    }
+    
+    // Close whatever is still open and hand the trace to the store
+    void finish() {
+        uint64_t now = Tracer::instance().nowNs();
+        for (int index : open) {
+            trace.spans[index].durationNs = now - trace.spans[index].startNs;
+        }
+        trace.durationNs = trace.spans[0].durationNs;
+        open.clear();
+        active = false;
+        Tracer::instance().store(std::move(trace));
+    }
+};
+
+const std::string* currentRequestId() {
+    ThreadTrace& threadTrace = ThreadTrace::current();
+    return threadTrace.active ? &threadTrace.trace.requestId : nullptr;
+}
+
+TraceSpan::TraceSpan(const char* name) {
+    Tracer& tracer = Tracer::instance();
+    if (!tracer.enabled()) return;
+    ThreadTrace& threadTrace = ThreadTrace::current();
+    if (!threadTrace.active) {
+        threadTrace.begin(tracer.nextRequestId(), name);
+        index_ = 0;
+        root_ = true;
+        generation_ = threadTrace.generation;
+        return;
+    }
+    generation_ = threadTrace.generation;
+    TraceRecord& trace = threadTrace.trace;
+    if (trace.spans.size() >= Tracer::kMaxSpans) {
+        trace.droppedSpans++;
+        return;
+    }
+    index_ = static_cast<int>(trace.spans.size());
+    trace.spans.push_back({name, tracer.nowNs(), 0, threadTrace.open.back(),
+                           static_cast<int>(threadTrace.open.size())});
+    threadTrace.open.push_back(index_);
+}
+
+TraceSpan::~TraceSpan() {
+    if (index_ < 0) return;
+    ThreadTrace& threadTrace = ThreadTrace::current();
+    // beginTrace() may have replaced the trace this span was opened in
+    if (!threadTrace.active || threadTrace.generation != generation_) return;
+    if (root_) {
+        threadTrace.finish();
+        return;
+    }
+    TraceSpanRecord& span = threadTrace.trace.spans[index_];
+    span.durationNs = Tracer::instance().nowNs() - span.startNs;
+    if (!threadTrace.open.empty() && threadTrace.open.back() == index_) threadTrace.open.pop_back();
+}
+
+void setTracing(bool enabled, size_t capacity) { Tracer::instance().setEnabled(enabled, capacity); }
+bool tracingEnabled() { return Tracer::instance().enabled(); }
+
+void beginTrace(const std::string& requestId, const std::string& name) {
+    Tracer& tracer = Tracer::instance();
+    if (!tracer.enabled()) return;
+    ThreadTrace& threadTrace = ThreadTrace::current();
+    if (threadTrace.active) threadTrace.finish();  // A request that never ended
+    threadTrace.begin(requestId.empty() ? tracer.nextRequestId() : requestId, name);
+}
+
+void endTrace() {
+    ThreadTrace& threadTrace = ThreadTrace::current();
+    if (threadTrace.active) threadTrace.finish();
+}
+
+json recentTraces(size_t limit, double minDurationMs) { return Tracer::instance().recent(limit, minDurationMs); }
+json findTrace(const std::string& requestId) { return Tracer::instance().find(requestId); }
+json chromeTrace(const std::string& requestId) { return Tracer::instance().chrome(requestId); }
+void clearTraces() { Tracer::instance().clear(); }
+
+// Custom binary search tree node for movies - moved after Movie class
+struct MovieNode {
+    Movie movie;
+    MovieNode* left;
+    MovieNode* right;
+    
+    MovieNode(const Movie& m) : movie(m), left(nullptr), right(nullptr) {}
+};
+
+// HyperLogLog distinct counter - 2^precision one-byte registers, ~1.04/sqrt(2^precision) error
+class HyperLogLog {
+public:
+    explicit HyperLogLog(int precision = 12)
+        : precision_(precision), registers_(size_t(1) << precision, 0) {
+        rankCounts_.fill(0);
+        rankCounts_[0] = static_cast<uint32_t>(registers_.size());
+    }
+    
+    void add(uint64_t hash) {
+        size_t index = static_cast<size_t>(hash >> (64 - precision_));
+        // Guard bit keeps the rank bounded when the remaining bits are all zero
+        uint64_t rest = (hash << precision_) | (uint64_t(1) << (precision_ - 1));
+        uint8_t rank = static_cast<uint8_t>(countLeadingZeros64(rest) + 1);
+        raise(index, rank);
+    }
+    
+    // O(ranks) rather than O(registers): registers are tallied by rank as they
+    // change, and the result is kept until one does
+    double estimate() const {
+        if (cachedEstimate_ >= 0.0) {
+            return cachedEstimate_;
+        }
+        double m = static_cast<double>(registers_.size());
+        double sum = 0.0;
+        for (size_t r = 0; r < rankCounts_.size(); r++) {
+            sum += std::ldexp(static_cast<double>(rankCounts_[r]), -static_cast<int>(r));
+        }
+        uint32_t zeros = rankCounts_[0];
+        double alpha = 0.7213 / (1.0 + 1.079 / m);
+        double estimate = alpha * m * m / sum;
+        // Small-range correction (linear counting)
+        if (estimate <= 2.5 * m && zeros > 0) {
+            estimate = m * std::log(m / zeros);
+        }
+        cachedEstimate_ = estimate;
+        return estimate;
+    }
+    
+    // Union: register-wise maximum (both sketches must share a precision)
+    void merge(const HyperLogLog& other) {
+        for (size_t i = 0; i < registers_.size(); i++) {
+            raise(i, other.registers_[i]);
+        }
+    }
+    
+private:
+    int precision_;
+    std::vector<uint8_t> registers_;
+    std::array<uint32_t, 65> rankCounts_;  // Registers holding each rank
+    mutable double cachedEstimate_ = -1.0;
+    
+    void raise(size_t index, uint8_t rank) {
+        if (rank > registers_[index]) {
+            cachedEstimate_ = -1.0;
+            rankCounts_[registers_[index]]--;
+            rankCounts_[rank]++;
+            registers_[index] = rank;
+        }
+    }
+};
+
+// Count-Min sketch with signed counters so cancellations can be subtracted
+class CountMinSketch {
+public:
+    CountMinSketch(size_t width = 2048, size_t depth = 4)
+        : width_(width), depth_(depth), counters_(width * depth, 0) {}
+    
+    void add(uint64_t hash, long long delta) {
+        for (size_t row = 0; row < depth_; row++) {
+            counters_[row * width_ + bucket(hash, row)] += delta;
+        }
+    }
+    
+    long long estimate(uint64_t hash) const {
+        long long result = counters_[bucket(hash, 0)];
+        for (size_t row = 1; row < depth_; row++) {
+            result = std::min(result, counters_[row * width_ + bucket(hash, row)]);
+        }
+        return std::max(result, 0LL);
+    }
+    
+    void merge(const CountMinSketch& other) {
+        for (size_t i = 0; i < counters_.size(); i++) {
+            counters_[i] += other.counters_[i];
+        }
+    }
+    
+private:
+    size_t width_;
+    size_t depth_;
+    std::vector<long long> counters_;
+    
+    // Kirsch-Mitzenmacher double hashing derives the row hashes from one 64-bit hash
+    size_t bucket(uint64_t hash, size_t row) const {
+        uint64_t h1 = hash & 0xffffffffULL;
+        uint64_t h2 = (hash >> 32) | 1;
+        return static_cast<size_t>((h1 + row * h2) % width_);
+    }
+};
+
+// Space-Saving heavy hitters - tracks at most `capacity` keys with bounded overestimate
+template <typename Key>
+class SpaceSaving {
+public:
+    struct Entry {
+        Key key;
+        long long count;
+        long long error;
+    };
+    
+    explicit SpaceSaving(size_t capacity = 64) : capacity_(capacity) {}
+    
+    void add(const Key& key, long long delta) {
+        auto it = counts_.find(key);
+        if (it != counts_.end()) {
+            order_.erase({it->second.count, key});
+            it->second.count = std::max(it->second.count + delta, it->second.error);
+            order_.insert({it->second.count, key});
+            return;
+        }
+        if (delta <= 0) {
+            return;  // Untracked keys cannot be decremented
+        }
+        if (counts_.size() < capacity_) {
+            counts_[key] = {delta, 0};
+            order_.insert({delta, key});
+            return;
+        }
+        // Replace the minimum: the newcomer inherits its count as error
+        auto minIt = order_.begin();
+        long long minCount = minIt->first;
+        counts_.erase(minIt->second);
+        order_.erase(minIt);
+        counts_[key] = {minCount + delta, minCount};
+        order_.insert({minCount + delta, key});
+    }
+    
+    // Fold another summary in; its per-key errors carry over
+    void merge(const SpaceSaving& other) {
+        for (const auto& [key, counter] : other.counts_) {
+            add(key, counter.count);
+            auto it = counts_.find(key);
+            if (it != counts_.end()) {
+                it->second.error += counter.error;
+            }
+        }
+    }
+    
+    std::vector<Entry> top(size_t k) const {
+        std::vector<Entry> result;
+        for (auto it = order_.rbegin(); it != order_.rend() && result.size() < k; ++it) {
+            const auto& counter = counts_.at(it->second);
+            result.push_back({it->second, counter.count, counter.error});
+        }
+        return result;
+    }
+    
+private:
+    struct Counter {
+        long long count;
+        long long error;
+    };
+    
+    size_t capacity_;
+    std::unordered_map<Key, Counter> counts_;
+    std::set<std::pair<long long, Key>> order_;
+};
+
+// Running analytics aggregates, updated in O(1) on every booking state change.
+// Revenue is kept in integer cents so cancel/restore reverse it exactly.
+struct AnalyticsAggregates {
+    long long activeBookings = 0;
+    long long cancelledBookings = 0;
+    long long revenueCents = 0;
+    long long uniqueUsers = 0;  // activeBookingsByUser.size(), readable without copying the map
+    std::unordered_map<std::string, int> activeBookingsByUser;
+    std::map<std::string, std::pair<int, long long>> dailyRevenue;  // day -> (bookings, cents)
+    std::map<int, int> movieBookings;
+    std::map<std::string, int> screenTypeBookings;
+    
+    static long long toCents(double amount) {
+        return std::llround(amount * 100.0);
+    }
+    
+    // Add (sign = +1) or remove (sign = -1) an active booking. perUser = false
+    // (sketch mode) leaves the exact per-user counts alone.
+    void apply(const Booking& booking, int sign, bool perUser = true) {
+        activeBookings += sign;
+        revenueCents += sign * toCents(booking.getTotalPrice());
+        if (perUser) {
+            adjust(activeBookingsByUser, booking.getUserId(), sign);
+            uniqueUsers = static_cast<long long>(activeBookingsByUser.size());
+        }
+        
+        auto& day = dailyRevenue[booking.getBookingDate()];
+        day.first += sign;
+        day.second += sign * toCents(booking.getTotalPrice());
+        if (day.first <= 0) {
+            dailyRevenue.erase(booking.getBookingDate());
+        }
+        
+        adjust(movieBookings, booking.getMovieId(), sign);
+        adjust(screenTypeBookings, booking.getScreenType(), sign);
+    }
+    
+    void clear() {
+        *this = AnalyticsAggregates();
+    }
+    
+    void merge(const AnalyticsAggregates& other) {
+        activeBookings += other.activeBookings;
+        cancelledBookings += other.cancelledBookings;
+        revenueCents += other.revenueCents;
+        for (const auto& [user, count] : other.activeBookingsByUser) activeBookingsByUser[user] += count;
+        uniqueUsers = static_cast<long long>(activeBookingsByUser.size());
+        for (const auto& [day, entry] : other.dailyRevenue) {
+            dailyRevenue[day].first += entry.first;
+            dailyRevenue[day].second += entry.second;
+        }
+        for (const auto& [movieId, count] : other.movieBookings) movieBookings[movieId] += count;
+        for (const auto& [screenType, count] : other.screenTypeBookings) screenTypeBookings[screenType] += count;
+    }
+    
+private:
+    template <typename Map, typename Key>
+    static void adjust(Map& counts, const Key& key, int sign) {
+        auto& count = counts[key];
+        count += sign;
+        if (count <= 0) {
+            counts.erase(key);
+        }
+    }
+};
+
+// Movie popularity maintained on the booking path. Booking counts live in
+// sorted counter buckets (O(1) increment/decrement, O(k) top-k walk); trending
+// scores use forward exponential decay in an indexed max-heap, so a score never
+// needs touching as time passes - only when one of its bookings changes.
+class MovieRanking {
+public:
+    explicit MovieRanking(double halfLifeHours = 24.0) {
+        setHalfLife(halfLifeHours);
+    }
+    
+    void setHalfLife(double halfLifeHours) {
+        decaySeconds_ = std::max(halfLifeHours, 1e-3) * 3600.0 / std::log(2.0);
+        clearTrending();
+    }
+    
+    // Change a movie's active booking count by +1 or -1
+    void add(int movieId, int delta) {
+        auto found = entries_.find(movieId);
+        if (found == entries_.end()) {
+            if (delta <= 0) return;
+            auto bucket = buckets_.begin();
+            if (bucket == buckets_.end() || bucket->count != 1) {
+                bucket = buckets_.insert(buckets_.begin(), Bucket{1, {}});
+            }
+            bucket->movies.push_back(movieId);
+            entries_[movieId] = {bucket, std::prev(bucket->movies.end())};
+            return;
+        }
+        
+        Entry& entry = found->second;
+        auto bucket = entry.bucket;
+        long long target = bucket->count + delta;
+        bucket->movies.erase(entry.position);
+        
+        if (target <= 0) {
+            if (bucket->movies.empty()) buckets_.erase(bucket);
+            entries_.erase(found);
+            return;
+        }
+        
+        // Neighbouring bucket holds count +/- 1 if it exists; otherwise create it
+        auto next = delta > 0 ? std::next(bucket) : bucket;
+        if (delta > 0) {
+            if (next == buckets_.end() || next->count != target) {
+                next = buckets_.insert(next, Bucket{target, {}});
+            }
+        } else if (bucket == buckets_.begin() || std::prev(bucket)->count != target) {
+            next = buckets_.insert(bucket, Bucket{target, {}});
+        } else {
+            next = std::prev(bucket);
+        }
+        next->movies.push_back(movieId);
+        entry = {next, std::prev(next->movies.end())};
+        if (bucket->movies.empty()) buckets_.erase(bucket);
+    }
+    
+    // Visit movies from most to least booked until fn returns false
+    template <typename Fn>
+    void forEachTop(Fn fn) const {
+        for (auto bucket = buckets_.rbegin(); bucket != buckets_.rend(); ++bucket) {
+            for (int movieId : bucket->movies) {
+                if (!fn(movieId, bucket->count)) return;
+            }
+        }
+    }
+    
+    // Add (sign = +1) or remove (sign = -1) a booking made at eventTime (epoch seconds)
+    void addTrending(int movieId, double eventTime, int sign) {
+        if (eventTime > landmark_ + kRebaseAfter * decaySeconds_) {
+            rebase(eventTime);
+        }
+        double weight = std::exp((eventTime - landmark_) / decaySeconds_);
+        auto found = heapIndex_.find(movieId);
+        if (found == heapIndex_.end()) {
+            if (sign <= 0) return;
+            heap_.push_back({movieId, 0.0, 0});
+            found = heapIndex_.emplace(movieId, heap_.size() - 1).first;
+        }
+        size_t index = found->second;
+        HeapNode& node = heap_[index];
+        node.bookings += sign;
+        node.score = node.bookings > 0 ? std::max(0.0, node.score + sign * weight) : 0.0;
+        
+        if (node.bookings <= 0) {
+            removeAt(index);
+        } else if (sign > 0) {
+            siftUp(index);
+        } else {
+            siftDown(index);
+        }
+    }
+    
+    // Highest decayed scores at time `now`, best-first over the heap in O(k log k)
+    std::vector<std::pair<int, double>> topTrending(size_t k, double now) const {
+        std::vector<std::pair<int, double>> result;
+        double decay = std::exp((landmark_ - now) / decaySeconds_);
+        std::priority_queue<std::pair<double, size_t>> frontier;
+        if (!heap_.empty()) frontier.push({heap_[0].score, 0});
+        while (!frontier.empty() && result.size() < k) {
+            size_t index = frontier.top().second;
+            frontier.pop();
+            result.push_back({heap_[index].movieId, heap_[index].score * decay});
+            for (size_t child = 2 * index + 1; child <= 2 * index + 2 && child < heap_.size(); child++) {
+                frontier.push({heap_[child].score, child});
+            }
+        }
+        return result;
+    }
+    
+    void clear() {
+        buckets_.clear();
+        entries_.clear();
+        clearTrending();
+    }
+    
+    void clearTrending() {
+        heap_.clear();
+        heapIndex_.clear();
+        landmark_ = 0.0;
+    }
+    
+private:
+    struct Bucket {
+        long long count;
+        std::list<int> movies;
+    };
+    struct Entry {
+        std::list<Bucket>::iterator bucket;
+        std::list<int>::iterator position;
+    };
+    struct HeapNode {
+        int movieId;
+        double score;
+        long long bookings;
+    };
+    
+    // Rebase before exp() gets anywhere near overflow
+    static constexpr double kRebaseAfter = 200.0;
+    
+    std::list<Bucket> buckets_;  // Ascending by count
+    std::unordered_map<int, Entry> entries_;
+    
+    double decaySeconds_ = 0.0;
+    double landmark_ = 0.0;
+    std::vector<HeapNode> heap_;
+    std::unordered_map<int, size_t> heapIndex_;
+    
+    // Move the landmark forward, scaling every score by the same factor (order is preserved)
+    void rebase(double newLandmark) {
+        double factor = std::exp((landmark_ - newLandmark) / decaySeconds_);
+        for (auto& node : heap_) {
+            node.score *= factor;
+        }
+        landmark_ = newLandmark;
+    }
+    
+    void swapNodes(size_t a, size_t b) {
+        std::swap(heap_[a], heap_[b]);
+        heapIndex_[heap_[a].movieId] = a;
+        heapIndex_[heap_[b].movieId] = b;
+    }
+    
+    void siftUp(size_t index) {
+        while (index > 0) {
+            size_t parent = (index - 1) / 2;
+            if (heap_[parent].score >= heap_[index].score) break;
+            swapNodes(parent, index);
+            index = parent;
+        }
+    }
+    
+    void siftDown(size_t index) {
+        while (true) {
+            size_t largest = index;
+            for (size_t child = 2 * index + 1; child <= 2 * index + 2 && child < heap_.size(); child++) {
+                if (heap_[child].score > heap_[largest].score) largest = child;
+            }
+            if (largest == index) break;
+            swapNodes(largest, index);
+            index = largest;
+        }
+    }
+    
+    void removeAt(size_t index) {
+        heapIndex_.erase(heap_[index].movieId);
+        if (index != heap_.size() - 1) {
+            heap_[index] = heap_.back();
+            heapIndex_[heap_[index].movieId] = index;
+            heap_.pop_back();
+            siftDown(index);
+            siftUp(index);
+        } else {
+            heap_.pop_back();
+        }
+    }
+};
+
+// Bounded-memory sketches backing the approximate analytics mode.
+// Distinct counts only ever grow; frequency sketches subtract cancellations.
+struct AnalyticsSketches {
+    static constexpr int kGlobalPrecision = 14;
+    static constexpr int kKeyedPrecision = 10;
+    
+    HyperLogLog users{kGlobalPrecision};
+    std::map<std::string, HyperLogLog> usersByDay;
+    std::unordered_map<int, HyperLogLog> usersByMovie;
+    std::unordered_map<int, HyperLogLog> usersByCinema;
+    CountMinSketch movieCounts;
+    CountMinSketch userCounts;
+    SpaceSaving<int> topMovies;
+    SpaceSaving<std::string> topUsers;
+    
+    void apply(const Booking& booking, int sign) {
+        uint64_t userHash = hash64(booking.getUserId());
+        if (sign > 0) {
+            users.add(userHash);
+            keyed(usersByDay, booking.getBookingDate()).add(userHash);
+            keyed(usersByMovie, booking.getMovieId()).add(userHash);
+            keyed(usersByCinema, booking.getCinemaId()).add(userHash);
+        }
+        movieCounts.add(hash64(booking.getMovieId()), sign);
+        userCounts.add(userHash, sign);
+        topMovies.add(booking.getMovieId(), sign);
+        topUsers.add(booking.getUserId(), sign);
+    }
+    
+    void clear() {
+        *this = AnalyticsSketches();
+    }
+    
+    void merge(const AnalyticsSketches& other) {
+        users.merge(other.users);
+        for (const auto& [day, sketch] : other.usersByDay) keyed(usersByDay, day).merge(sketch);
+        for (const auto& [movieId, sketch] : other.usersByMovie) keyed(usersByMovie, movieId).merge(sketch);
+        for (const auto& [cinemaId, sketch] : other.usersByCinema) keyed(usersByCinema, cinemaId).merge(sketch);
+        movieCounts.merge(other.movieCounts);
+        userCounts.merge(other.userCounts);
+        topMovies.merge(other.topMovies);
+        topUsers.merge(other.topUsers);
+    }
+    
+private:
+    template <typename Map, typename Key>
+    static HyperLogLog& keyed(Map& sketches, const Key& key) {
+        auto it = sketches.find(key);
+        if (it == sketches.end()) {
+            it = sketches.emplace(key, HyperLogLog(kKeyedPrecision)).first;
+        }
+        return it->second;
+    }
+};
+
+// Hourly, daily and weekly rollups of booking activity keyed by showtime start,
+// so range queries cost O(buckets in range) instead of O(bookings)
+class RollupEngine {
+public:
+    enum Granularity { Hourly = 0, Daily = 1, Weekly = 2 };
+    enum Dimension { Total = 0, ByMovie = 1, ByCinema = 2, ByScreenType = 3 };
+    
+    struct Metrics {
+        long long revenueCents = 0;
+        long long tickets = 0;
+        long long bookings = 0;
+        long long cancellations = 0;
+        long long capacity = 0;  // Seats offered by showtimes in the bucket
+        
+        void merge(const Metrics& other) {
+            revenueCents += other.revenueCents;
+            tickets += other.tickets;
+            bookings += other.bookings;
+            cancellations += other.cancellations;
+            capacity += other.capacity;
+        }
+    };
+    
+    using Groups = std::map<std::string, Metrics>;
+    
+    // Active booking added (sign = +1) or removed (sign = -1)
+    void recordBooking(const Booking& booking, int sign) {
+        Metrics delta;
+        delta.revenueCents = sign * AnalyticsAggregates::toCents(booking.getTotalPrice());
+        delta.tickets = sign * static_cast<long long>(booking.getSeats().size());
+        delta.bookings = sign;
+        update(bookingHour(booking), booking.getMovieId(), booking.getCinemaId(), booking.getScreenType(), delta);
+    }
+    
+    // Booking moved into (sign = +1) or out of (sign = -1) the cancelled state
+    void recordCancellation(const Booking& booking, int sign) {
+        Metrics delta;
+        delta.cancellations = sign;
+        update(bookingHour(booking), booking.getMovieId(), booking.getCinemaId(), booking.getScreenType(), delta);
+    }
+    
+    void addCapacity(const Showtime& showtime, long long seats) {
+        long long hour = toHour(showtime.getDate(), showtime.getTime());
+        if (hour < 0 || seats <= 0) return;
+        Metrics delta;
+        delta.capacity = seats;
+        update(hour, showtime.getMovieId(), showtime.getCinemaId(), showtime.getScreenType(), delta);
+    }
+    
+    void clearBookings() {
+        forEachMetrics([](Metrics& m) { long long capacity = m.capacity; m = Metrics(); m.capacity = capacity; });
+    }
+    
+    void clearCapacity() {
+        forEachMetrics([](Metrics& m) { m.capacity = 0; });
+    }
+    
+    void merge(const RollupEngine& other) {
+        for (size_t d = 0; d < undated_.size(); d++) {
+            for (const auto& [key, metrics] : other.undated_[d]) {
+                undated_[d][key].merge(metrics);
+            }
+        }
+        for (int g = Hourly; g <= Weekly; g++) {
+            for (const auto& [bucket, groups] : other.buckets_[g]) {
+                auto& target = buckets_[g][bucket];
+                for (size_t d = 0; d < groups.size(); d++) {
+                    for (const auto& [key, metrics] : groups[d]) {
+                        target[d][key].merge(metrics);
+                    }
+                }
+            }
+        }
+    }
+    
+    // Aggregate [fromHour, toHour] per group; optionally emit the per-bucket series
+    Groups query(long long fromHour, long long toHour, Granularity granularity, Dimension dimension,
+                 std::vector<std::pair<long long, Groups>>* series) const {
+        Groups totals;
+        const auto& buckets = buckets_[granularity];
+        auto it = buckets.lower_bound(bucketIndex(fromHour, granularity));
+        auto end = buckets.upper_bound(bucketIndex(toHour, granularity));
+        for (; it != end; ++it) {
+            const auto& groups = it->second[dimension];
+            if (series) {
+                series->emplace_back(bucketStartHour(it->first, granularity),
+                                     Groups(groups.begin(), groups.end()));
+            }
+            for (const auto& [key, metrics] : groups) {
+                totals[key].merge(metrics);
+            }
+        }
+        return totals;
+    }
+    
+    // Bookings whose showtime and booking dates both fail to parse; they sit
+    // outside every range, so range totals plus these reconcile with getAnalytics
+    Groups undated(Dimension dimension) const {
+        return Groups(undated_[dimension].begin(), undated_[dimension].end());
+    }
+    
+    // Hours since epoch for a date and clock time; -1 if the date is malformed
+    static long long toHour(const std::string& date, const std::string& time) {
+        long long days = 0;
+        if (!parse_date(date, days)) return -1;
+        int hour = parse_hour(time);
+        return days * 24 + (hour < 0 ? 0 : hour);
+    }
+    
+    static long long bucketIndex(long long hour, Granularity granularity) {
+        switch (granularity) {
+            case Hourly: return hour;
+            case Daily: return floorDiv(hour, 24);
+            // 1970-01-01 was a Thursday; shift so weeks start on Monday
+            default: return floorDiv(floorDiv(hour, 24) + 3, 7);
+        }
+    }
+    
+    static long long bucketStartHour(long long bucket, Granularity granularity) {
+        switch (granularity) {
+            case Hourly: return bucket;
+            case Daily: return bucket * 24;
+            default: return (bucket * 7 - 3) * 24;
+        }
+    }
+    
+private:
+    using DimensionGroups = std::array<std::unordered_map<std::string, Metrics>, 4>;
+    std::map<long long, DimensionGroups> buckets_[3];
+    DimensionGroups undated_;
+    
+    static long long floorDiv(long long a, long long b) {
+        return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
+    }
+    
+    // Showtime start if the booking carries it, otherwise midnight of the booking date
+    static long long bookingHour(const Booking& booking) {
+        long long hour = toHour(booking.getShowtimeDate(), booking.getShowtimeTime());
+        return hour >= 0 ? hour : toHour(booking.getBookingDate(), "");
+    }
+    
+    void update(long long hour, int movieId, int cinemaId, const std::string& screenType, const Metrics& delta) {
+        if (hour < 0) {
+            add(undated_, movieId, cinemaId, screenType, delta);
+            return;
+        }
+        for (int g = Hourly; g <= Weekly; g++) {
+            add(buckets_[g][bucketIndex(hour, static_cast<Granularity>(g))], movieId, cinemaId, screenType, delta);
+        }
+    }
+    
+    static void add(DimensionGroups& groups, int movieId, int cinemaId, const std::string& screenType,
+                    const Metrics& delta) {
+        groups[Total]["total"].merge(delta);
+        groups[ByMovie][std::to_string(movieId)].merge(delta);
+        groups[ByCinema][std::to_string(cinemaId)].merge(delta);
+        groups[ByScreenType][screenType].merge(delta);
+    }
+    
+    template <typename Fn>
+    void forEachMetrics(Fn fn) {
+        for (auto& group : undated_) {
+            for (auto& [key, metrics] : group) {
+                fn(metrics);
+            }
+        }
+        for (auto& buckets : buckets_) {
+            for (auto& [bucket, groups] : buckets) {
+                for (auto& group : groups) {
+                    for (auto& [key, metrics] : group) {
+                        fn(metrics);
+                    }
+                }
+            }
+        }
+    }
+};
+
+// Hierarchical timer wheel: a 256-slot root wheel plus three 64-slot wheels,
+// each slot spanning the whole previous wheel. Scheduling, cancelling and
+// expiring a timer are O(1); timers move down a level at most three times.
+template <typename Payload>
+class TimerWheel {
+public:
+    using TimerId = uint64_t;
+    
+    explicit TimerWheel(uint64_t startTick = 0) : currentTick_(startTick) {
+        slots_[0].resize(kRootSlots);
+        for (int level = 1; level < kLevels; level++) {
+            slots_[level].resize(kLevelSlots);
+        }
+    }
+    
+    // Fire at expiryTick (or on the next tick if that is already past)
+    TimerId schedule(uint64_t expiryTick, Payload payload) {
+        TimerId id = nextId_++;
+        Timer& timer = timers_[id];
+        timer.expiry = std::max(expiryTick, currentTick_ + 1);
+        timer.payload = std::move(payload);
+        place(id, timer);
+        return id;
+    }
+    
+    bool cancel(TimerId id) {
+        auto it = timers_.find(id);
+        if (it == timers_.end()) return false;
+        slots_[it->second.level][it->second.slot].erase(it->second.position);
+        timers_.erase(it);
+        return true;
+    }
+    
+    // Process every tick up to nowTick, passing the payload of each due timer to onExpire
+    template <typename Fn>
+    void advance(uint64_t nowTick, Fn onExpire) {
+        while (currentTick_ < nowTick) {
+            if (timers_.empty()) {
+                currentTick_ = nowTick;
+                return;
+            }
+            currentTick_++;
+            size_t index = currentTick_ & (kRootSlots - 1);
+            if (index == 0) {
+                // Refill the root wheel from the coarser wheels, lowest first
+                for (int level = 1; level < kLevels && cascade(level) == 0; level++) {}
+            }
+            
+            std::list<TimerId> due;
+            due.swap(slots_[0][index]);
+            for (TimerId id : due) {
+                auto it = timers_.find(id);
+                Payload payload = std::move(it->second.payload);
+                timers_.erase(it);
+                onExpire(payload);
+            }
+        }
+    }
+    
+    size_t size() const { return timers_.size(); }
+    uint64_t currentTick() const { return currentTick_; }
+    
+private:
+    static constexpr int kLevels = 4;
+    static constexpr int kRootBits = 8;
+    static constexpr int kLevelBits = 6;
+    static constexpr size_t kRootSlots = size_t(1) << kRootBits;
+    static constexpr size_t kLevelSlots = size_t(1) << kLevelBits;
+    
+    struct Timer {
+        uint64_t expiry = 0;
+        int level = 0;
+        size_t slot = 0;
+        typename std::list<TimerId>::iterator position;
+        Payload payload;
+    };
+    
+    std::vector<std::list<TimerId>> slots_[kLevels];
+    std::unordered_map<TimerId, Timer> timers_;
+    uint64_t currentTick_;
+    TimerId nextId_ = 1;
+    
+    static int shiftFor(int level) {
+        return kRootBits + kLevelBits * (level - 1);
+    }
+    
+    void place(TimerId id, Timer& timer) {
+        uint64_t delta = timer.expiry > currentTick_ ? timer.expiry - currentTick_ : 0;
+        if (delta < kRootSlots) {
+            timer.level = 0;
+            timer.slot = timer.expiry & (kRootSlots - 1);
+        } else {
+            timer.level = kLevels - 1;
+            uint64_t expiry = timer.expiry;
+            for (int level = 1; level < kLevels; level++) {
+                if (delta < (uint64_t(1) << (shiftFor(level) + kLevelBits))) {
+                    timer.level = level;
+                    break;
+                }
+            }
+            if (timer.level == kLevels - 1 && delta >= (uint64_t(1) << (shiftFor(kLevels - 1) + kLevelBits))) {
+                // Beyond the outermost wheel: park in its furthest slot and re-place on cascade
+                expiry = currentTick_ + (uint64_t(1) << (shiftFor(kLevels - 1) + kLevelBits)) - 1;
+            }
+            timer.slot = (expiry >> shiftFor(timer.level)) & (kLevelSlots - 1);
+        }
+        auto& slot = slots_[timer.level][timer.slot];
+        timer.position = slot.insert(slot.end(), id);
+    }
+    
+    // Re-place the timers of the current slot of `level`; returns that slot index
+    size_t cascade(int level) {
+        size_t index = (currentTick_ >> shiftFor(level)) & (kLevelSlots - 1);
+        std::list<TimerId> pending;
+        pending.swap(slots_[level][index]);
+        for (TimerId id : pending) {
+            place(id, timers_[id]);
+        }
+        return index;
+    }
+};
+
+// Results of recent keyed requests, so a retried request returns the original
+// result instead of running again. Entries expire after a fixed TTL and the
+// table holds at most `capacity` keys; since every entry lives equally long,
+// insertion order is also expiry order and both limits evict from the front.
+template <typename Value>
+class IdempotencyTable {
+public:
+    IdempotencyTable(size_t capacity = 10000, double ttlSeconds = 24 * 3600.0)
+        : capacity_(capacity), ttlSeconds_(ttlSeconds) {}
+    
+    // Stored value for key, or nullptr. Throws if the key was used for a different request.
+    const Value* find(const std::string& key, uint64_t fingerprint, double now) {
+        evictExpired(now);
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return nullptr;
+        }
+        if (it->second->fingerprint != fingerprint) {
+            throw std::runtime_error("Idempotency key " + key + " was already used for a different request");
+        }
+        return &it->second->value;
+    }
+    
+    void insert(const std::string& key, uint64_t fingerprint, Value value, double now) {
+        evictExpired(now);
+        if (index_.count(key)) {
+            return;
+        }
+        while (!entries_.empty() && entries_.size() >= capacity_) {
+            index_.erase(entries_.front().key);
+            entries_.pop_front();
+        }
+        entries_.push_back({key, fingerprint, now + ttlSeconds_, std::move(value)});
+        index_[key] = std::prev(entries_.end());
+    }
+    
+    size_t size() const { return entries_.size(); }
+    
+private:
+    struct Entry {
+        std::string key;
+        uint64_t fingerprint;
+        double expiresAt;
+        Value value;
+    };
+    
+    size_t capacity_;
+    double ttlSeconds_;
+    std::list<Entry> entries_;
+    std::unordered_map<std::string, typename std::list<Entry>::iterator> index_;
+    
+    void evictExpired(double now) {
+        while (!entries_.empty() && entries_.front().expiresAt <= now) {
+            index_.erase(entries_.front().key);
+            entries_.pop_front();
+        }
+    }
+};
+
+// Classic token bucket: `rate` tokens per second up to `burst`
+struct TokenBucket {
+    double tokens = 0.0;
+    double last = 0.0;
+    
+    bool take(double rate, double burst, double now) {
+        if (last == 0.0) {
+            tokens = burst;
+        } else {
+            tokens = std::min(burst, tokens + (now - last) * rate);
+        }
+        last = now;
+        if (tokens < 1.0) {
+            return false;
+        }
+        tokens -= 1.0;
+        return true;
+    }
+    
+    bool full(double rate, double burst, double now) const {
+        return tokens + (now - last) * rate >= burst;
+    }
+};
+
+// Per-showtime waiting room in front of the booking path. Requests take a FIFO
+// ticket and at most maxConcurrent requests for a showtime are inside at once,
+// admitted in ticket order, so a hot showtime queues in order instead of
+// piling onto the engine lock. Token buckets per user and per showtime reject
+// floods before they queue. Waiting-room tickets taken ahead of time keep
+// their place while the client polls its position.
+class AdmissionController {
+public:
+    // Releases the slot when destroyed
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(AdmissionController* owner, std::string showtimeId)
+            : owner_(owner), showtimeId_(std::move(showtimeId)) {}
+        Lease(Lease&& other) noexcept : owner_(other.owner_), showtimeId_(std::move(other.showtimeId_)) {
+            other.owner_ = nullptr;
+        }
+        Lease& operator=(Lease&& other) noexcept {
+            if (this != &other) {
+                release();
+                owner_ = other.owner_;
+                showtimeId_ = std::move(other.showtimeId_);
+                other.owner_ = nullptr;
+            }
+            return *this;
+        }
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease() { release(); }
+        
+    private:
+        AdmissionController* owner_ = nullptr;
+        std::string showtimeId_;
+        
+        void release() {
+            if (owner_) {
+                owner_->release(showtimeId_);
+                owner_ = nullptr;
+            }
+        }
+    };
+    
+    void configure(const AdmissionConfig& config) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        config_ = config;
+        changed_.notify_all();
+    }
+    
+    AdmissionConfig config() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return config_;
+    }
+    
+    // Take a waiting-room ticket ahead of booking; counts against the rate limits
+    uint64_t enter(const std::string& showtimeId, const std::string& userId) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        double now = steady_seconds();
+        checkRates(showtimeId, userId, now);
+        Room& room = rooms_[showtimeId];
+        uint64_t ticket = ++room.nextTicket;
+        room.queue.push_back({ticket, userId, now + config_.ticketTtlSeconds, now, false});
+        return ticket;
+    }
+    
+    // 0-based place in line (0 means next in), or -1 for an unknown or expired ticket.
+    // Polling keeps a waiting-room ticket alive.
+    int position(const std::string& showtimeId, uint64_t ticket) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto room = rooms_.find(showtimeId);
+        if (room == rooms_.end()) {
+            return -1;
+        }
+        double now = steady_seconds();
+        purge(room->second, now);
+        int place = 0;
+        for (auto& waiter : room->second.queue) {
+            if (waiter.ticket == ticket) {
+                waiter.lastSeen = now;
+                return place;
+            }
+            place++;
+        }
+        return -1;
+    }
+    
+    // Wait for a slot for showtimeId. A ticket from enter() keeps its place in
+    // line; ticket 0 joins the back. Throws AdmissionError when rate limited or
+    // on timeout. Callers holding an interpreter lock must drop it first.
+    Lease acquire(const std::string& showtimeId, const std::string& userId, uint64_t ticket = 0) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!config_.enabled) {
+            return Lease();
+        }
+        double now = steady_seconds();
+        Room& room = rooms_[showtimeId];
+        purge(room, now);
+        
+        double deadline = now + config_.queueTimeoutSeconds;
+        auto waiter = ticket != 0 ? find(room, ticket) : room.queue.end();
+        if (waiter == room.queue.end() || waiter->userId != userId) {
+            checkRates(showtimeId, userId, now);
+            ticket = ++room.nextTicket;
+            room.queue.push_back({ticket, userId, deadline, now, true});
+        } else {
+            waiter->waiting = true;
+        }
+        
+        while (!ready(room, ticket)) {
+            now = steady_seconds();
+            if (now >= deadline) {
+                room.queue.erase(find(room, ticket));
+                changed_.notify_all();
+                throw AdmissionError("Timed out waiting for admission to showtime " + showtimeId);
+            }
+            changed_.wait_for(lock, std::chrono::duration<double>(deadline - now));
+            purge(room, steady_seconds());
+        }
+        
+        room.queue.erase(find(room, ticket));
+        room.active++;
+        changed_.notify_all();
+        return Lease(this, showtimeId);
+    }
+    
+    json stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        json result = json::object();
+        for (const auto& [showtimeId, room] : rooms_) {
+            if (room.active == 0 && room.queue.empty()) continue;
+            json item;
+            item["active"] = room.active;
+            item["queued"] = room.queue.size();
+            result[showtimeId] = item;
+        }
+        return result;
+    }
+    
+private:
+    struct Waiter {
+        uint64_t ticket;
+        std::string userId;
+        double deadline;
+        double lastSeen;
+        bool waiting;  // a request is blocked in acquire() on this ticket
+    };
+    
+    struct Room {
+        std::deque<Waiter> queue;
+        int active = 0;
+        uint64_t nextTicket = 0;
+        TokenBucket bucket;
+    };
+    
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    AdmissionConfig config_;
+    std::unordered_map<std::string, Room> rooms_;
+    std::unordered_map<std::string, TokenBucket> userBuckets_;
+    
+    void checkRates(const std::string& showtimeId, const std::string& userId, double now) {
+        if (!userBuckets_[userId].take(config_.userRate, config_.userBurst, now)) {
+            throw AdmissionError("Rate limit exceeded for user " + userId);
+        }
+        if (!rooms_[showtimeId].bucket.take(config_.showtimeRate, config_.showtimeBurst, now)) {
+            throw AdmissionError("Rate limit exceeded for showtime " + showtimeId);
+        }
+        // Refilled buckets carry no state worth keeping
+        if (userBuckets_.size() > 10000) {
+            for (auto it = userBuckets_.begin(); it != userBuckets_.end();) {
+                it = it->second.full(config_.userRate, config_.userBurst, now) ? userBuckets_.erase(it) : std::next(it);
+            }
+        }
+    }
+    
+    // A blocked request goes in once fewer requests are blocked ahead of it
+    // than there are free slots. Waiting-room tickets whose holder is not
+    // booking yet keep their place in line but hold nobody up.
+    bool ready(const Room& room, uint64_t ticket) const {
+        int ahead = 0;
+        for (const auto& waiter : room.queue) {
+            if (waiter.ticket == ticket) {
+                return ahead < config_.maxConcurrent - room.active;
+            }
+            ahead += waiter.waiting ? 1 : 0;
+        }
+        return false;
+    }
+    
+    std::deque<Waiter>::iterator find(Room& room, uint64_t ticket) {
+        return std::find_if(room.queue.begin(), room.queue.end(),
+                            [ticket](const Waiter& waiter) { return waiter.ticket == ticket; });
+    }
+    
+    // Drop abandoned waiting-room tickets; blocked requests time themselves out
+    void purge(Room& room, double now) {
+        auto abandoned = std::remove_if(room.queue.begin(), room.queue.end(), [&](const Waiter& waiter) {
+            return !waiter.waiting && (waiter.deadline <= now || waiter.lastSeen + config_.pollGraceSeconds <= now);
+        });
+        if (abandoned != room.queue.end()) {
+            room.queue.erase(abandoned, room.queue.end());
+            changed_.notify_all();
+        }
+    }
+    
+    void release(const std::string& showtimeId) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rooms_[showtimeId].active--;
+        changed_.notify_all();
+    }
+};
+
+// Fixed-capacity FIFO that overwrites its oldest element when full
+template <typename T>
+class RingBuffer {
+public:
+    explicit RingBuffer(size_t capacity) : items_(std::max<size_t>(capacity, 1)) {}
+    
+    void push(T item) {
+        items_[(start_ + size_) % items_.size()] = std::move(item);
+        if (size_ < items_.size()) {
+            size_++;
+        } else {
+            start_ = (start_ + 1) % items_.size();
+        }
+    }
+    
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    
+    // 0 is the oldest element
+    const T& operator[](size_t i) const { return items_[(start_ + i) % items_.size()]; }
+    
+private:
+    std::vector<T> items_;
+    size_t start_ = 0;
+    size_t size_ = 0;
+};
+
+// Seat bits grouped into (word index, mask) pairs, in ascending word order
+std::vector<std::pair<size_t, uint64_t>> groupSeatBits(const std::vector<size_t>& bits) {
+    std::map<size_t, uint64_t> masks;
+    for (size_t bit : bits) {
+        masks[bit >> 6] |= uint64_t(1) << (bit & 63);
+    }
+    return std::vector<std::pair<size_t, uint64_t>>(masks.begin(), masks.end());
+}
+
+// Lock-free seat claims for one showtime, one atomic word per 64 seats of a
+// row (SeatBitmap's layout). A set bit means booked, held, or claimed by a
+// booking on its way to the engine lock. createBooking claims here first, so
+// buyers of disjoint seats never wait on each other for seats and a buyer who
+// lost a seat is turned away without queueing on the lock. The engine
+// re-checks under the lock and releases the claim if the booking fails.
+class SeatClaims {
+public:
+    // Exponential backoff between retries: spin, then yield the CPU
+    class Backoff {
+    public:
+        void pause() {
+            if (spins_ <= kMaxSpins) {
+                for (int i = 0; i < spins_; i++) cpuRelax();
+                spins_ *= 2;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        
+    private:
+        static constexpr int kMaxSpins = 1024;
+        int spins_ = 4;
+    };
+    
+    // A conflicting claim may still be rolled back, so a conflict is retried
+    // this many times, backing off in between, before it is reported
+    static constexpr int kConflictRetries = 8;
+    
+    SeatClaims(std::shared_ptr<const SeatLayout> layout, const SeatBitmap& taken)
+        : layout_(std::move(layout)), wordsPerRow_(taken.wordsPerRow()),
+          words_(new std::atomic<uint64_t>[taken.wordCount()]),
+          holders_(new std::atomic<uint64_t>[taken.wordCount() * 64]) {
+        for (int r = 0; r < taken.rows(); r++) {
+            for (int w = 0; w < wordsPerRow_; w++) {
+                words_[static_cast<size_t>(r) * wordsPerRow_ + w].store(taken.row(r)[w], std::memory_order_relaxed);
+            }
+        }
+        for (size_t i = 0; i < taken.wordCount() * 64; i++) {
+            holders_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+    
+    const std::shared_ptr<const SeatLayout>& layout() const { return layout_; }
+    
+    size_t bit(int row, int column) const {
+        return static_cast<size_t>(row) * wordsPerRow_ * 64 + column;
+    }
+    
+    // Bits for seat labels; false if a label is not a seat of the layout
+    bool bitsFor(const std::vector<std::string>& seats, std::vector<size_t>& bits) const {
+        bits.clear();
+        for (const auto& seat : seats) {
+            int row, column;
+            if (!layout_->locate(seat, row, column)) {
+                return false;
+            }
+            bits.push_back(bit(row, column));
+        }
+        return true;
+    }
+    
+    // Claim every bit or none. Words are claimed in ascending order and a
+    // conflict rolls back the words already claimed. A CAS lost to a
+    // neighbouring seat of the same word is retried with backoff.
+    bool claim(const std::vector<size_t>& bits) {
+        std::vector<std::pair<size_t, uint64_t>> masks = groupSeatBits(bits);
+        Backoff backoff;
+        for (int attempt = 0;; attempt++) {
+            if (claimWords(masks) == masks.size()) {
+                return true;
+            }
+            if (attempt == kConflictRetries) {
+                return false;
+            }
+            backoff.pause();
+        }
+    }
+    
+    void release(const std::vector<size_t>& bits) {
+        for (const auto& [index, mask] : groupSeatBits(bits)) {
+            words_[index].fetch_and(~mask, std::memory_order_acq_rel);
+        }
+    }
+    
+    void set(size_t bit, bool value) {
+        uint64_t mask = uint64_t(1) << (bit & 63);
+        if (value) {
+            words_[bit >> 6].fetch_or(mask, std::memory_order_acq_rel);
+        } else {
+            words_[bit >> 6].fetch_and(~mask, std::memory_order_acq_rel);
+        }
+    }
+    
+    // Hash of the user holding the seat, 0 if it is not held; kept exact under
+    // the engine lock so a buyer's own hold is not mistaken for a conflict
+    void setHolder(size_t bit, uint64_t userHash) {
+        holders_[bit].store(userHash, std::memory_order_release);
+    }
+    
+    uint64_t holder(size_t bit) const {
+        return holders_[bit].load(std::memory_order_acquire);
+    }
+    
+private:
+    std::shared_ptr<const SeatLayout> layout_;
+    int wordsPerRow_;
+    std::unique_ptr<std::atomic<uint64_t>[]> words_;
+    std::unique_ptr<std::atomic<uint64_t>[]> holders_;  // Per bit, like words_
+    
+    // Claim the masks in order; returns masks.size() on success, otherwise the
+    // index of the conflicting mask after rolling back the earlier ones
+    size_t claimWords(const std::vector<std::pair<size_t, uint64_t>>& masks) {
+        for (size_t i = 0; i < masks.size(); i++) {
+            std::atomic<uint64_t>& word = words_[masks[i].first];
+            uint64_t old = word.load(std::memory_order_acquire);
+            Backoff backoff;
+            while (true) {
+                if (old & masks[i].second) {
+                    for (size_t j = 0; j < i; j++) {
+                        words_[masks[j].first].fetch_and(~masks[j].second, std::memory_order_acq_rel);
+                    }
+                    return i;
+                }
+                if (word.compare_exchange_weak(old, old | masks[i].second, std::memory_order_acq_rel,
+                                               std::memory_order_acquire)) {
+                    break;
+                }
+                backoff.pause();
+            }
+        }
+        return masks.size();
+    }
+};
+
+// Seat map ETag: state epoch and version
+inline std::string seat_etag(uint64_t epoch, uint64_t version) {
+    char buffer[48];
+    std::snprintf(buffer, sizeof(buffer), "%016llx-%llu", static_cast<unsigned long long>(epoch),
+                  static_cast<unsigned long long>(version));
+    return buffer;
+}
+
+// What a conditional seat map read needs to answer "not modified" without the
+// engine lock: the ETag inputs and the first hold tick at which an expiring
+// hold would change the map. Written under the engine lock.
+struct SeatMapStamp {
+    explicit SeatMapStamp(uint64_t stateEpoch) : epoch(stateEpoch) {}
+    
+    const uint64_t epoch;
+    std::atomic<uint64_t> version{0};
+    std::atomic<uint64_t> holdExpiryTick{std::numeric_limits<uint64_t>::max()};
+};
+
+// Live seat state of one showtime against its screen's shared layout. `taken`
+// starts as the layout's aisles and blocked seats and tracks booked and held
+// seats on top, so block searches only look at one bitmap.
+struct ShowtimeSeats {
+    static constexpr size_t kChangeLogSize = 256;
+    
+    ShowtimeSeats(std::string id, std::shared_ptr<const SeatLayout> seatLayout)
+        : showtimeId(std::move(id)), layout(std::move(seatLayout)), taken(layout->unavailable()),
+          claims(std::make_shared<SeatClaims>(layout, taken)), stamp(std::make_shared<SeatMapStamp>(epoch)) {}
+    
+    std::string showtimeId;
+    std::shared_ptr<const SeatLayout> layout;
+    std::unordered_set<std::string> booked;
+    std::unordered_map<std::string, std::string> held;  // seat -> hold token
+    SeatBitmap taken;
+    std::shared_ptr<SeatClaims> claims;  // kept a superset of `taken` under the engine lock
+    
+    // Bumped on every change; the last kChangeLogSize deltas are kept. The
+    // epoch tells versions of a rebuilt state (or another process) apart.
+    uint64_t epoch = std::random_device{}() | (uint64_t(std::random_device{}()) << 32);
+    uint64_t version = 0;
+    std::shared_ptr<SeatMapStamp> stamp;  // Published copy of epoch and version
+    
+    std::string etag() const {
+        return seat_etag(epoch, version);
+    }
+    RingBuffer<SeatChange> changes{kChangeLogSize};
+    
+    // Refresh the seat's bit after `booked` or `held` changed
+    void sync(const std::string& seat) {
+        int row, column;
+        if (!layout->locate(seat, row, column)) return;
+        bool value = booked.count(seat) || held.count(seat);
+        taken.set(row, column, value);
+        claims->set(claims->bit(row, column), value);
+        if (!held.count(seat)) {
+            claims->setHolder(claims->bit(row, column), 0);
+        }
+    }
+    
+    // Put the seat in hold `token` of the user with hash userHash
+    void hold(const std::string& seat, const std::string& token, uint64_t userHash) {
+        held[seat] = token;
+        sync(seat);
+        int row, column;
+        if (layout->locate(seat, row, column)) {
+            claims->setHolder(claims->bit(row, column), userHash);
+        }
+    }
+    
+    // Seats of the layout neither booked nor held
+    int available() const {
+        return layout->capacity() - static_cast<int>(taken.count() - layout->unavailable().count());
+    }
+};
+
+// Prices seats from the rules. Everything except the seat tier is the same for
+// the whole showtime, so a quote builds one price per tier and then prices the
+// seat set in a single pass of table lookups, summing in integer cents.
+class PricingEngine {
+public:
+    struct Quote {
+        long long totalCents = 0;
+        std::vector<long long> seatCents;
+        std::vector<int> seatTiers;
+        double showtimeMultiplier = 1.0;
+        double surgeMultiplier = 1.0;
+    };
+    
+    void setRules(PricingRules rules) {
+        std::sort(rules.surge.begin(), rules.surge.end(),
+                  [](const PricingRules::SurgeStep& a, const PricingRules::SurgeStep& b) {
+                      return a.occupancy < b.occupancy;
+                  });
+        rules_ = std::move(rules);
+    }
+    
+    const PricingRules& rules() const { return rules_; }
+    
+    // Throws if any seat is not on the layout
+    Quote quote(const Showtime& showtime, const SeatLayout& layout, double occupancy,
+                const std::vector<std::string>& seats) const {
+        Quote result;
+        result.showtimeMultiplier = showtimeMultiplier(showtime);
+        result.surgeMultiplier = surgeMultiplier(occupancy);
+        double base = showtime.getPrice() * result.showtimeMultiplier * result.surgeMultiplier;
+        
+        std::vector<long long> tierCents(layout.tiers().size());
+        for (size_t tier = 0; tier < tierCents.size(); tier++) {
+            tierCents[tier] = std::llround(base * lookup(rules_.tierMultipliers, layout.tiers()[tier]) * 100.0);
+        }
+        
+        result.seatCents.resize(seats.size());
+        result.seatTiers.resize(seats.size());
+        for (size_t i = 0; i < seats.size(); i++) {
+            int row, column;
+            if (!layout.locate(seats[i], row, column)) {
+                throw std::runtime_error("Seat " + seats[i] + " does not exist on this screen");
+            }
+            int tier = layout.tierIndex(row);
+            result.seatTiers[i] = tier;
+            result.seatCents[i] = tierCents[tier];
+            result.totalCents += tierCents[tier];
+        }
+        return result;
+    }
+    
+private:
+    PricingRules rules_;
+    
+    static double lookup(const std::map<std::string, double>& multipliers, const std::string& key) {
+        auto it = multipliers.find(key);
+        return it != multipliers.end() ? it->second : 1.0;
+    }
+    
+    // Screen type, weekday and time-of-day factors
+    double showtimeMultiplier(const Showtime& showtime) const {
+        double multiplier = lookup(rules_.screenTypeMultipliers, showtime.getScreenType());
+        long long days;
+        if (parse_date(showtime.getDate(), days)) {
+            multiplier *= rules_.weekdayMultipliers[((days % 7) + 11) % 7];  // 1970-01-01 was a Thursday
+        }
+        int hour = parse_hour(showtime.getTime());
+        for (const auto& band : rules_.timeBands) {
+            if (hour >= band.fromHour && hour < band.toHour) {
+                multiplier *= band.multiplier;
+                break;
+            }
+        }
+        return multiplier;
+    }
+    
+    double surgeMultiplier(double occupancy) const {
+        double multiplier = 1.0;
+        for (const auto& step : rules_.surge) {
+            if (occupancy + 1e-9 >= step.occupancy) {
+                multiplier = step.multiplier;
+            }
+        }
+        return multiplier;
+    }
+};
+
+// A contiguous block found by findBestSeats; lower scores are better
+struct SeatBlock {
+    int row = -1;
+    int firstColumn = -1;
+    double score = 0.0;
+    std::vector<std::string> seats;
+};
+
+// Seats reserved for a user until the hold is confirmed, released or expires
+struct SeatHold {
+    std::string token;
+    std::string showtimeId;
+    std::string userId;
+    std::vector<std::string> seats;
+    uint64_t expiresTick = 0;
+    TimerWheel<std::string>::TimerId timer = 0;
+};
+
+#ifndef _WIN32
+// Seat inventory shared by every engine process on the host through a POSIX
+// shared memory segment, for pre-forked servers where each worker has its own
+// BookingSystem. Each showtime gets a slot of seat words (same bit layout as
+// SeatBitmap) that processes claim and release with compare-and-swap, so two
+// workers can never take the same seat. A ring-buffer journal of booking
+// changes lets each worker replay what the others did into its own state.
+// A change larger than one journal entry spans consecutive entries and is
+// only read once all of them are written.
+class SharedSeatInventory {
+public:
+    static constexpr size_t kSlots = 4096;
+    static constexpr size_t kWordsPerSlot = 64;
+    static constexpr size_t kJournalEntries = 1024;
+    static constexpr size_t kJournalPayload = 2032;
+    static constexpr size_t kMaxParts = kJournalEntries / 4;
+    
+    // Batch carries a JSON array of bookings created together
+    enum class EntryKind : uint32_t { Booked = 1, Cancelled = 2, Restored = 3, Batch = 4 };
+    
+    struct Record {
+        EntryKind kind;
+        int pid;
+        std::string payload;
+    };
+    
+    // Open the named segment, creating it if needed; reset discards an existing one
+    SharedSeatInventory(const std::string& name, bool reset) : name_(name) {
+        static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared seat words need lock-free 64-bit atomics");
+        if (reset) {
+            shm_unlink(name.c_str());
+        }
+        
+        int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        created_ = fd >= 0;
+        if (created_) {
+            if (ftruncate(fd, sizeof(Segment)) != 0) {
+                close(fd);
+                shm_unlink(name.c_str());
+                throw std::runtime_error("Could not size shared seat inventory " + name);
+            }
+        } else {
+            fd = shm_open(name.c_str(), O_RDWR, 0600);
+            if (fd < 0) {
+                throw std::runtime_error("Could not open shared seat inventory " + name);
+            }
+            // The creator may not have sized the segment yet
+            struct stat info;
+            for (int attempt = 0; fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) < sizeof(Segment); attempt++) {
+                if (attempt == 500) {
+                    close(fd);
+                    throw std::runtime_error("Shared seat inventory " + name + " has an unexpected size");
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+        
+        void* memory = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED) {
+            throw std::runtime_error("Could not map shared seat inventory " + name);
+        }
+        segment_ = static_cast<Segment*>(memory);
+        
+        if (created_) {
+            // ftruncate zero-fills, so only the header needs writing
+            segment_->header.magic = kMagic;
+            segment_->header.format = kFormat;
+        } else {
+            for (int attempt = 0; segment_->header.ready.load(std::memory_order_acquire) == 0; attempt++) {
+                if (attempt == 500) {
+                    munmap(segment_, sizeof(Segment));
+                    throw std::runtime_error("Shared seat inventory " + name + " was never initialised");
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            if (segment_->header.magic != kMagic || segment_->header.format != kFormat) {
+                munmap(segment_, sizeof(Segment));
+                throw std::runtime_error("Shared seat inventory " + name + " has an incompatible format");
+            }
+        }
+    }
+    
+    ~SharedSeatInventory() {
+        munmap(segment_, sizeof(Segment));
+    }
+    
+    SharedSeatInventory(const SharedSeatInventory&) = delete;
+    SharedSeatInventory& operator=(const SharedSeatInventory&) = delete;
+    
+    // True for the process that created the segment; it seeds it, then calls markReady
+    bool created() const { return created_; }
+    
+    void markReady() {
+        segment_->header.ready.store(1, std::memory_order_release);
+    }
+    
+    const std::string& name() const { return name_; }
+    
+    static int processId() { return static_cast<int>(getpid()); }
+    
+    // Set every bit or none: words are claimed in ascending order and a
+    // conflict rolls back the words already claimed
+    bool claim(const std::string& showtimeId, const std::vector<size_t>& bits) {
+        Slot& slot = findSlot(showtimeId);
+        std::vector<std::pair<size_t, uint64_t>> masks = wordMasks(bits);
+        for (size_t i = 0; i < masks.size(); i++) {
+            std::atomic<uint64_t>& word = slot.words[masks[i].first];
+            uint64_t old = word.load(std::memory_order_acquire);
+            bool claimed = false;
+            while (!(old & masks[i].second)) {
+                if (word.compare_exchange_weak(old, old | masks[i].second, std::memory_order_acq_rel)) {
+                    claimed = true;
+                    break;
+                }
+            }
+            if (!claimed) {
+                for (size_t j = 0; j < i; j++) {
+                    slot.words[masks[j].first].fetch_and(~masks[j].second, std::memory_order_acq_rel);
+                }
+                return false;
+            }
+        }
+        slot.generation.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+    
+    void release(const std::string& showtimeId, const std::vector<size_t>& bits) {
+        Slot& slot = findSlot(showtimeId);
+        for (const auto& [index, mask] : wordMasks(bits)) {
+            slot.words[index].fetch_and(~mask, std::memory_order_acq_rel);
+        }
+        slot.generation.fetch_add(1, std::memory_order_release);
+    }
+    
+    // Current seat words of a showtime (all zero if it has no slot yet)
+    std::vector<uint64_t> snapshot(const std::string& showtimeId) {
+        std::vector<uint64_t> words(kWordsPerSlot, 0);
+        Slot& slot = findSlot(showtimeId);
+        for (size_t i = 0; i < kWordsPerSlot; i++) {
+            words[i] = slot.words[i].load(std::memory_order_acquire);
+        }
+        return words;
+    }
+    
+    // Changes on every claim or release of the showtime, by any process
+    uint64_t generation(const std::string& showtimeId) {
+        return findSlot(showtimeId).generation.load(std::memory_order_acquire);
+    }
+    
+    // Append one change, over as many consecutive entries as its payload needs
+    void append(EntryKind kind, const std::string& payload) {
+        size_t parts = std::max<size_t>(1, (payload.size() + kJournalPayload - 1) / kJournalPayload);
+        if (parts > kMaxParts) {
+            throw std::runtime_error("Journal entry too large for shared seat inventory");
+        }
+        uint64_t first = segment_->header.journalHead.fetch_add(parts, std::memory_order_acq_rel);
+        for (size_t part = 0; part < parts; part++) {
+            uint64_t index = first + part;
+            Entry& entry = segment_->journal[index % kJournalEntries];
+            // Seqlock-style publish: readers only trust the entry once its sequence is index + 1
+            entry.sequence.store(0, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            size_t offset = part * kJournalPayload;
+            size_t length = std::min(kJournalPayload, payload.size() - std::min(offset, payload.size()));
+            entry.kind = static_cast<uint32_t>(kind);
+            entry.pid = static_cast<int32_t>(getpid());
+            entry.part = static_cast<uint32_t>(part);
+            entry.parts = static_cast<uint32_t>(parts);
+            entry.length = static_cast<uint32_t>(length);
+            std::memcpy(entry.payload, payload.data() + offset, length);
+            entry.sequence.store(index + 1, std::memory_order_release);
+        }
+    }
+    
+    // Read complete changes from `cursor` on, advancing it. Returns false if
+    // the journal wrapped past the cursor; the cursor then skips to the oldest
+    // change still whole.
+    bool readSince(uint64_t& cursor, std::vector<Record>& records) const {
+        uint64_t head = segment_->header.journalHead.load(std::memory_order_acquire);
+        bool complete = true;
+        if (head > kJournalEntries && cursor < head - kJournalEntries) {
+            cursor = head - kJournalEntries;
+            complete = false;
+        }
+        while (cursor < head) {
+            Record record;
+            size_t parts = 1;
+            switch (readRecord(cursor, head, record, parts)) {
+                case Read::Pending:
+                    return complete;  // still being written; pick it up next time
+                case Read::Lost:
+                    complete = false;
+                    break;
+                case Read::Whole:
+                    records.push_back(std::move(record));
+                    break;
+            }
+            cursor += parts;
+        }
+        return complete;
+    }
+    
+private:
+    static constexpr uint32_t kMagic = 0x43565331;  // "CVS1"
+    static constexpr uint32_t kFormat = 2;
+    
+    struct Slot {
+        std::atomic<uint64_t> key;
+        std::atomic<uint64_t> generation;
+        std::atomic<uint64_t> words[kWordsPerSlot];
+    };
+    
+    struct Entry {
+        std::atomic<uint64_t> sequence;
+        uint32_t kind;
+        int32_t pid;
+        uint32_t part;   // Index of this entry within its change
+        uint32_t parts;  // Entries the change spans
+        uint32_t length;
+        char payload[kJournalPayload];
+    };
+    
+    struct Header {
+        uint32_t magic;
+        uint32_t format;
+        std::atomic<uint32_t> ready;
+        std::atomic<uint64_t> journalHead;
+    };
+    
+    struct Segment {
+        Header header;
+        Slot slots[kSlots];
+        Entry journal[kJournalEntries];
+    };
+    
+    std::string name_;
+    Segment* segment_ = nullptr;
+    bool created_ = false;
+    
+    enum class Read { Whole, Pending, Lost };
+    
+    // Read the change starting at `index` into record; parts is set to the
+    // entries to skip past it. Lost means it was overwritten, or index is the
+    // middle of a change whose start was.
+    Read readRecord(uint64_t index, uint64_t head, Record& record, size_t& parts) const {
+        parts = 1;
+        for (size_t part = 0; part < parts; part++) {
+            const Entry& entry = segment_->journal[(index + part) % kJournalEntries];
+            uint64_t expected = index + part + 1;
+            uint64_t before = entry.sequence.load(std::memory_order_acquire);
+            if (before != expected) {
+                return before > expected ? Read::Lost : Read::Pending;
+            }
+            uint32_t kind = entry.kind;
+            int32_t pid = entry.pid;
+            uint32_t entryPart = entry.part;
+            uint32_t entryParts = entry.parts;
+            std::string chunk(entry.payload, std::min<size_t>(entry.length, kJournalPayload));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (entry.sequence.load(std::memory_order_relaxed) != before || entryPart != part) {
+                return Read::Lost;
+            }
+            if (part == 0) {
+                if (entryParts == 0 || entryParts > kMaxParts || index + entryParts > head) {
+                    return Read::Lost;
+                }
+                parts = entryParts;
+                record.kind = static_cast<EntryKind>(kind);
+                record.pid = pid;
+            }
+            record.payload += chunk;
+        }
+        return Read::Whole;
+    }
+    
+    // Open addressing on the showtime id hash; a slot is taken by CAS on its key
+    Slot& findSlot(const std::string& showtimeId) {
+        uint64_t key = hash64(showtimeId) | 1;
+        for (size_t probe = 0; probe < kSlots; probe++) {
+            Slot& slot = segment_->slots[(key + probe) % kSlots];
+            uint64_t current = slot.key.load(std::memory_order_acquire);
+            if (current == 0 && slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+                return slot;
+            }
+            if (current == key) {
+                return slot;
+            }
+        }
+        throw std::runtime_error("Shared seat inventory is full");
+    }
+    
+    // Group seat bits by word, in ascending word order
+    static std::vector<std::pair<size_t, uint64_t>> wordMasks(const std::vector<size_t>& bits) {
+        for (size_t bit : bits) {
+            if (bit >= kWordsPerSlot * 64) {
+                throw std::runtime_error("Seat layout too large for the shared seat inventory");
+            }
+        }
+        return groupSeatBits(bits);
+    }
+};
+#else
+// POSIX shared memory is not available; enabling the shared inventory fails
+class SharedSeatInventory {
+public:
+    enum class EntryKind : uint32_t { Booked = 1, Cancelled = 2, Restored = 3, Batch = 4 };
+    struct Record {
+        EntryKind kind;
+        int pid;
+        std::string payload;
+    };
+    
+    SharedSeatInventory(const std::string&, bool) {
+        throw std::runtime_error("Shared seat inventory requires POSIX shared memory");
+    }
+    bool created() const { return false; }
+    void markReady() {}
+    const std::string& name() const { static const std::string empty; return empty; }
+    static int processId() { return 0; }
+    bool claim(const std::string&, const std::vector<size_t>&) { return false; }
+    void release(const std::string&, const std::vector<size_t>&) {}
+    std::vector<uint64_t> snapshot(const std::string&) { return {}; }
+    uint64_t generation(const std::string&) { return 0; }
+    void append(EntryKind, const std::string&) {}
+    bool readSince(uint64_t&, std::vector<Record>&) const { return true; }
+};
+#endif
+
+// Engine metrics - per-method call counts, errors and latency, plus mutex_
+// wait and persistence time. Every thread records into its own shard of
+// relaxed atomics, so a recording never takes a lock or shares a cache line
+// with another thread; readers sum the shards.
+
+// Log-linear latency histogram in nanoseconds, HDR style: each power of two is
+// split into 8 sub-buckets, so a value is known to within 12.5% from 8 ns up
+// to about 18 minutes in 312 counters. Written only by the owning shard's
+// thread, read concurrently by snapshots.
+class LatencyHistogram {
+public:
+    static constexpr int kSubBucketBits = 3;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kMaxExponent = 40;
+    static constexpr int kBuckets = (kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+    
+    static int bucketOf(uint64_t nanos) {
+        if (nanos < static_cast<uint64_t>(kSubBuckets)) return static_cast<int>(nanos);
+        int exponent = 63 - countLeadingZeros64(nanos);
+        if (exponent > kMaxExponent) return kBuckets - 1;
+        int shift = exponent - kSubBucketBits;
+        return (shift + 1) * kSubBuckets + static_cast<int>((nanos >> shift) & (kSubBuckets - 1));
+    }
+    static uint64_t lowerBound(int bucket) {
+        if (bucket < kSubBuckets) return static_cast<uint64_t>(bucket);
+        uint64_t mantissa = static_cast<uint64_t>(kSubBuckets + bucket % kSubBuckets);
+        return mantissa << (bucket / kSubBuckets - 1);
+    }
+    // Exclusive upper bound of a bucket
+    static uint64_t upperBound(int bucket) {
+        if (bucket < kSubBuckets) return static_cast<uint64_t>(bucket) + 1;
+        return lowerBound(bucket) + (uint64_t(1) << (bucket / kSubBuckets - 1));
+    }
+    
+    void record(uint64_t nanos) {
+        counts_[bucketOf(nanos)].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(nanos, std::memory_order_relaxed);
+        if (nanos > max_.load(std::memory_order_relaxed)) {
+            max_.store(nanos, std::memory_order_relaxed);
+        }
+    }
+    
+    void reset() {
+        for (auto& count : counts_) count.store(0, std::memory_order_relaxed);
+        sum_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+    
+private:
+    friend struct HistogramSnapshot;
+    std::array<std::atomic<uint64_t>, kBuckets> counts_{};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+// One histogram summed over every shard
+struct HistogramSnapshot {
+    std::array<uint64_t, LatencyHistogram::kBuckets> counts{};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    
+    void add(const LatencyHistogram& histogram) {
+        for (int b = 0; b < LatencyHistogram::kBuckets; b++) {
+            uint64_t n = histogram.counts_[b].load(std::memory_order_relaxed);
+            counts[b] += n;
+            count += n;
+        }
+        sum += histogram.sum_.load(std::memory_order_relaxed);
+        max = std::max(max, histogram.max_.load(std::memory_order_relaxed));
+    }
+    
+    // Midpoint of the bucket holding quantile q, never above the observed max
+    double quantileNanos(double q) const {
+        if (count == 0) return 0.0;
+        uint64_t rank = static_cast<uint64_t>(std::ceil(q * static_cast<double>(count)));
+        rank = std::max<uint64_t>(rank, 1);
+        uint64_t seen = 0;
+        for (int b = 0; b < LatencyHistogram::kBuckets; b++) {
+            seen += counts[b];
+            if (seen >= rank) {
+                double mid = (LatencyHistogram::lowerBound(b) + LatencyHistogram::upperBound(b) - 1) / 2.0;
+                return std::min(mid, static_cast<double>(max));
+            }
+        }
+        return static_cast<double>(max);
+    }
+    
+    // Observations in buckets that lie entirely at or below `nanos`
+    uint64_t countAtOrBelow(uint64_t nanos) const {
+        uint64_t total = 0;
+        for (int b = 0; b < LatencyHistogram::kBuckets; b++) {
+            if (LatencyHistogram::upperBound(b) - 1 > nanos) break;
+            total += counts[b];
+        }
+        return total;
+    }
+    
+    json to_json() const {
+        return {
+            {"count", count},
+            {"sumSeconds", sum / 1e9},
+            {"meanUs", count ? sum / 1e3 / count : 0.0},
+            {"p50Us", quantileNanos(0.50) / 1e3},
+            {"p90Us", quantileNanos(0.90) / 1e3},
+            {"p99Us", quantileNanos(0.99) / 1e3},
+            {"p999Us", quantileNanos(0.999) / 1e3},
+            {"maxUs", max / 1e3}
+        };
+    }
+};
+
+// Public BookingSystem methods, in declaration order
+enum class EngineOp {
+    LoadMovies, GetAllMovies, GetSortedMovies, GetPopularMovies, GetTrendingMovies, SetTrendingHalfLife,
+    GetMovieById, AddMovie, SaveMovies,
+    LoadCinemas, GetAllCinemas, GetCinemaById, AddCinema, SaveCinemas, AddShowtime, GetShowtimeById,
+    GetShowtimesByMovie, GetShowtimesByDate, GetShowtimesByMovieAndDate,
+    GetBookedSeatsForShowtime, GetSeatAvailability, GetSeatLayout, GetSeatMap, SeatChangesSince,
+    SubscribeSeatChanges, UnsubscribeSeatChanges,
+    Quote, SetPricingRules, GetPricingRules,
+    HoldSeats, ConfirmHold, ReleaseHold, FindBestSeats,
+    CreateBooking, CreateBookings, GetBookingById, CancelBooking, RestoreBooking, GetBookingsByUser,
+    GetAllBookings,
+    EnterWaitingRoom, GetQueuePosition, ConfigureAdmission, GetAdmissionConfig, GetAdmissionStats,
+    GetSeatClaimStats, EnableSharedInventory,
+    GetAnalytics, BookingReport, AnalyticsRange, SetSketchAnalytics,
+    SaveData, MarkShutdownInProgress,
+    Count
+};
+
+const char* const kEngineOpNames[] = {
+    "loadMovies", "getAllMovies", "getSortedMovies", "getPopularMovies", "getTrendingMovies", "setTrendingHalfLife",
+    "getMovieById", "addMovie", "saveMovies",
+    "loadCinemas", "getAllCinemas", "getCinemaById", "addCinema", "saveCinemas", "addShowtime", "getShowtimeById",
+    "getShowtimesByMovie", "getShowtimesByDate", "getShowtimesByMovieAndDate",
+    "getBookedSeatsForShowtime", "getSeatAvailability", "getSeatLayout", "getSeatMap", "seatChangesSince",
+    "subscribeSeatChanges", "unsubscribeSeatChanges",
+    "quote", "setPricingRules", "getPricingRules",
+    "holdSeats", "confirmHold", "releaseHold", "findBestSeats",
+    "createBooking", "createBookings", "getBookingById", "cancelBooking", "restoreBooking", "getBookingsByUser",
+    "getAllBookings",
+    "enterWaitingRoom", "getQueuePosition", "configureAdmission", "getAdmissionConfig", "getAdmissionStats",
+    "getSeatClaimStats", "enableSharedInventory",
+    "getAnalytics", "bookingReport", "analyticsRange", "setSketchAnalytics",
+    "saveData", "markShutdownInProgress"
+};
+static_assert(sizeof(kEngineOpNames) / sizeof(kEngineOpNames[0]) == static_cast<size_t>(EngineOp::Count),
+              "kEngineOpNames must name every EngineOp");
+
+// File reads and writes of the data directory
+enum class PersistOp { LoadMovies, SaveMovies, LoadCinemas, SaveCinemas, LoadBookings, SaveBookings, Count };
+
+const char* const kPersistOpNames[] = {
+    "loadMovies", "saveMovies", "loadCinemas", "saveCinemas", "loadBookings", "saveBookings"
+};
+static_assert(sizeof(kPersistOpNames) / sizeof(kPersistOpNames[0]) == static_cast<size_t>(PersistOp::Count),
+              "kPersistOpNames must name every PersistOp");
+
+// Everything one thread records
+struct MetricsShard {
+    struct Op {
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> errors{0};
+        LatencyHistogram latency;
+    };
+    std::array<Op, static_cast<size_t>(EngineOp::Count)> ops;
+    LatencyHistogram lockWait;                 // Every mutex_ acquisition, 0 when uncontended
+    std::atomic<uint64_t> lockContended{0};    // Acquisitions that had to block
+    std::array<LatencyHistogram, static_cast<size_t>(PersistOp::Count)> persistence;
+};
+
+class EngineMetrics {
+public:
+    EngineMetrics() : id_(nextInstanceId()), started_(std::chrono::steady_clock::now()) {}
+    
+    // The calling thread's shard, created on its first recording. The last
+    // instance used is cached per thread, so steady state is a TLS compare.
+    MetricsShard& shard() {
+        thread_local uint64_t cachedId = 0;
+        thread_local MetricsShard* cachedShard = nullptr;
+        if (cachedId == id_) return *cachedShard;
+        
+        std::lock_guard<std::mutex> lock(shardsMutex_);
+        auto& slot = shards_[std::this_thread::get_id()];
+        if (!slot) slot = std::make_unique<MetricsShard>();
+        cachedId = id_;
+        cachedShard = slot.get();
+        return *cachedShard;
+    }
+    
+    json snapshot() const {
+        std::vector<HistogramSnapshot> latency(static_cast<size_t>(EngineOp::Count));
+        std::vector<uint64_t> calls(latency.size(), 0), errors(latency.size(), 0);
+        HistogramSnapshot lockWait;
+        uint64_t contended = 0;
+        std::vector<HistogramSnapshot> persistence(static_cast<size_t>(PersistOp::Count));
+        size_t threads = collect(latency, calls, errors, lockWait, contended, persistence);
+        
+        json operations = json::object();
+        for (size_t i = 0; i < latency.size(); i++) {
+            if (calls[i] == 0) continue;
+            operations[kEngineOpNames[i]] = {
+                {"calls", calls[i]}, {"errors", errors[i]}, {"latency", latency[i].to_json()}
+            };
+        }
+        json lock = lockWait.to_json();
+        lock["contended"] = contended;
+        json files = json::object();
+        for (size_t i = 0; i < persistence.size(); i++) {
+            if (persistence[i].count == 0) continue;
+            files[kPersistOpNames[i]] = persistence[i].to_json();
+        }
+        return {
+            {"uptimeSeconds", uptimeSeconds()},
+            {"threads", threads},
+            {"operations", operations},
+            {"lockWait", lock},
+            {"persistence", files}
+        };
+    }
+    
+    // Prometheus text exposition format (version 0.0.4)
+    std::string prometheus() const {
+        std::vector<HistogramSnapshot> latency(static_cast<size_t>(EngineOp::Count));
+        std::vector<uint64_t> calls(latency.size(), 0), errors(latency.size(), 0);
+        HistogramSnapshot lockWait;
+        uint64_t contended = 0;
+        std::vector<HistogramSnapshot> persistence(static_cast<size_t>(PersistOp::Count));
+        collect(latency, calls, errors, lockWait, contended, persistence);
+        
+        std::ostringstream out;
+        out << std::setprecision(9);
+        out << "# HELP cinema_engine_calls_total Calls into each public BookingSystem method.\n"
+            << "# TYPE cinema_engine_calls_total counter\n";
+        for (size_t i = 0; i < calls.size(); i++) {
+            if (calls[i]) out << "cinema_engine_calls_total{method=\"" << kEngineOpNames[i] << "\"} " << calls[i] << "\n";
+        }
+        out << "# HELP cinema_engine_errors_total Calls that ended in an exception.\n"
+            << "# TYPE cinema_engine_errors_total counter\n";
+        for (size_t i = 0; i < errors.size(); i++) {
+            if (calls[i]) out << "cinema_engine_errors_total{method=\"" << kEngineOpNames[i] << "\"} " << errors[i] << "\n";
+        }
+        out << "# HELP cinema_engine_call_duration_seconds Latency of each public BookingSystem method.\n"
+            << "# TYPE cinema_engine_call_duration_seconds histogram\n";
+        for (size_t i = 0; i < latency.size(); i++) {
+            if (calls[i]) {
+                writeHistogram(out, "cinema_engine_call_duration_seconds",
+                               std::string("method=\"") + kEngineOpNames[i] + "\"", latency[i]);
+            }
+        }
+        out << "# HELP cinema_engine_lock_wait_seconds Time spent waiting to acquire the engine mutex.\n"
+            << "# TYPE cinema_engine_lock_wait_seconds histogram\n";
+        writeHistogram(out, "cinema_engine_lock_wait_seconds", "", lockWait);
+        out << "# HELP cinema_engine_lock_acquisitions_total Acquisitions of the engine mutex.\n"
+            << "# TYPE cinema_engine_lock_acquisitions_total counter\n"
+            << "cinema_engine_lock_acquisitions_total " << lockWait.count << "\n";
+        out << "# HELP cinema_engine_lock_contended_total Acquisitions of the engine mutex that had to block.\n"
+            << "# TYPE cinema_engine_lock_contended_total counter\n"
+            << "cinema_engine_lock_contended_total " << contended << "\n";
+        out << "# HELP cinema_engine_persistence_seconds Time spent reading and writing data files.\n"
+            << "# TYPE cinema_engine_persistence_seconds histogram\n";
+        for (size_t i = 0; i < persistence.size(); i++) {
+            if (persistence[i].count) {
+                writeHistogram(out, "cinema_engine_persistence_seconds",
+                               std::string("operation=\"") + kPersistOpNames[i] + "\"", persistence[i]);
+            }
+        }
+        out << "# HELP cinema_engine_uptime_seconds Seconds since the engine was created.\n"
+            << "# TYPE cinema_engine_uptime_seconds gauge\n"
+            << "cinema_engine_uptime_seconds " << uptimeSeconds() << "\n";
+        return out.str();
+    }
+    
+    // Zero every shard; recordings racing the reset may survive it
+    void reset() {
+        std::lock_guard<std::mutex> lock(shardsMutex_);
+        for (auto& [thread, shard] : shards_) {
+            for (auto& op : shard->ops) {
+                op.calls.store(0, std::memory_order_relaxed);
+                op.errors.store(0, std::memory_order_relaxed);
+                op.latency.reset();
+            }
+            shard->lockWait.reset();
+            shard->lockContended.store(0, std::memory_order_relaxed);
+            for (auto& histogram : shard->persistence) histogram.reset();
+        }
+    }
+    
+private:
+    static uint64_t nextInstanceId() {
+        static std::atomic<uint64_t> next{1};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    double uptimeSeconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count();
+    }
+    
+    size_t collect(std::vector<HistogramSnapshot>& latency, std::vector<uint64_t>& calls,
+                   std::vector<uint64_t>& errors, HistogramSnapshot& lockWait, uint64_t& contended,
+                   std::vector<HistogramSnapshot>& persistence) const {
+        std::lock_guard<std::mutex> lock(shardsMutex_);
+        for (const auto& [thread, shard] : shards_) {
+            for (size_t i = 0; i < shard->ops.size(); i++) {
+                calls[i] += shard->ops[i].calls.load(std::memory_order_relaxed);
+                errors[i] += shard->ops[i].errors.load(std::memory_order_relaxed);
+                latency[i].add(shard->ops[i].latency);
+            }
+            lockWait.add(shard->lockWait);
+            contended += shard->lockContended.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < shard->persistence.size(); i++) {
+                persistence[i].add(shard->persistence[i]);
+            }
+        }
+        return shards_.size();
+    }
+    
+    // Fine buckets fold into fixed decade-ish `le` buckets so series stay
+    // comparable across scrapes and instances
+    static void writeHistogram(std::ostringstream& out, const std::string& name, const std::string& labels,
+                               const HistogramSnapshot& histogram) {
+        static const std::pair<uint64_t, const char*> kBounds[] = {
+            {1000, "1e-06"}, {5000, "5e-06"}, {10000, "1e-05"}, {50000, "5e-05"},
+            {100000, "0.0001"}, {500000, "0.0005"}, {1000000, "0.001"}, {5000000, "0.005"},
+            {10000000, "0.01"}, {50000000, "0.05"}, {100000000, "0.1"}, {500000000, "0.5"},
+            {1000000000, "1"}, {5000000000, "5"}, {10000000000, "10"}
+        };
+        std::string prefix = labels.empty() ? "" : labels + ",";
+        for (const auto& [nanos, le] : kBounds) {
+            out << name << "_bucket{" << prefix << "le=\"" << le << "\"} " << histogram.countAtOrBelow(nanos) << "\n";
+        }
+        out << name << "_bucket{" << prefix << "le=\"+Inf\"} " << histogram.count << "\n";
+        std::string suffix = labels.empty() ? "" : "{" + labels + "}";
+        out << name << "_sum" << suffix << " " << histogram.sum / 1e9 << "\n";
+        out << name << "_count" << suffix << " " << histogram.count << "\n";
+    }
+    
+    const uint64_t id_;
+    const std::chrono::steady_clock::time_point started_;
+    mutable std::mutex shardsMutex_;
+    std::unordered_map<std::thread::id, std::unique_ptr<MetricsShard>> shards_;
+};
+
+inline uint64_t elapsedNanos(std::chrono::steady_clock::time_point since) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - since).count());
+}
+
+// Times one public call, and traces it as a span; a call left by an
+// exception also counts as an error
+class OpTimer {
+public:
+    OpTimer(EngineMetrics& metrics, EngineOp op)
+        : op_(metrics.shard().ops[static_cast<size_t>(op)]),
+          exceptions_(std::uncaught_exceptions()),
+          started_(std::chrono::steady_clock::now()),
+          span_(kEngineOpNames[static_cast<size_t>(op)]) {}
+    ~OpTimer() {
+        op_.calls.fetch_add(1, std::memory_order_relaxed);
+        if (std::uncaught_exceptions() > exceptions_) op_.errors.fetch_add(1, std::memory_order_relaxed);
+        op_.latency.record(elapsedNanos(started_));
+    }
+    OpTimer(const OpTimer&) = delete;
+    OpTimer& operator=(const OpTimer&) = delete;
+    
+private:
+    MetricsShard::Op& op_;
+    int exceptions_;
+    std::chrono::steady_clock::time_point started_;
+    TraceSpan span_;
+};
+
+// Times one load or save of a data file
+class PersistTimer {
+public:
+    PersistTimer(EngineMetrics& metrics, PersistOp op)
+        : histogram_(metrics.shard().persistence[static_cast<size_t>(op)]),
+          started_(std::chrono::steady_clock::now()) {}
+    ~PersistTimer() { histogram_.record(elapsedNanos(started_)); }
+    PersistTimer(const PersistTimer&) = delete;
+    PersistTimer& operator=(const PersistTimer&) = delete;
+    
+private:
+    LatencyHistogram& histogram_;
+    std::chrono::steady_clock::time_point started_;
+};
+
+// The enclosing function and line of an EngineLock, taken from its default
+// arguments so call sites need no annotation
+#if defined(__GNUC__) || defined(__clang__) || (defined(_MSC_VER) && _MSC_VER >= 1926)
+#define CINEMA_CALLER_FUNCTION __builtin_FUNCTION()
+#define CINEMA_CALLER_LINE __builtin_LINE()
+#else
+#define CINEMA_CALLER_FUNCTION "unknown"
+#define CINEMA_CALLER_LINE 0
+#endif
+
+// The engine's mutex_: a std::mutex that records how long each lock() waited.
+// An uncontended acquisition takes the try_lock fast path and reads no clock.
+//
+// While profiling is on, EngineLock also attributes wait time, hold time and
+// the number of threads queued behind each acquisition to its call site. The
+// site table is only touched with the mutex held, so it needs no lock of its
+// own and costs nothing when profiling is off.
+class TimedMutex {
+public:
+    struct SiteProfile {
+        const char* function = "";
+        int line = 0;
+        uint64_t acquisitions = 0;
+        uint64_t contended = 0;
+        uint64_t waiters = 0;       // Sum over acquisitions of threads still queued
+        uint64_t maxWaiters = 0;
+        LatencyHistogram wait;
+        LatencyHistogram hold;
+    };
+    
+    explicit TimedMutex(EngineMetrics& metrics) : metrics_(metrics) {}
+    
+    void lock() { acquire(nullptr); }
+    bool try_lock() { return mutex_.try_lock(); }
+    void unlock() { mutex_.unlock(); }
+    
+    // lock() returning the nanoseconds waited; `waitersBehind` receives the
+    // number of threads still blocked on the mutex once it was acquired
+    uint64_t acquire(uint64_t* waitersBehind) {
+        MetricsShard& shard = metrics_.shard();
+        if (mutex_.try_lock()) {
+            shard.lockWait.record(0);
+            if (waitersBehind) *waitersBehind = static_cast<uint64_t>(waiting_.load(std::memory_order_relaxed));
+            return 0;
+        }
+        waiting_.fetch_add(1, std::memory_order_relaxed);
+        auto started = std::chrono::steady_clock::now();
+        mutex_.lock();
+        uint64_t waited = elapsedNanos(started);
+        int behind = waiting_.fetch_sub(1, std::memory_order_relaxed) - 1;
+        if (waitersBehind) *waitersBehind = static_cast<uint64_t>(std::max(behind, 0));
+        shard.lockContended.fetch_add(1, std::memory_order_relaxed);
+        shard.lockWait.record(waited);
+        return waited;
+    }
+    
+    bool profiling() const { return profiling_.load(std::memory_order_relaxed); }
+    
+    // Mutex held. Turning profiling on starts a fresh profile.
+    void setProfiling(bool enabled) {
+        if (enabled == profiling()) return;
+        if (enabled) {
+            sites_.clear();
+            profileStarted_ = std::chrono::steady_clock::now();
+        } else {
+            profileStopped_ = std::chrono::steady_clock::now();
+        }
+        profiling_.store(enabled, std::memory_order_relaxed);
+    }
+    
+    // Mutex held
+    SiteProfile& site(const char* function, int line) {
+        SiteProfile& profile = sites_[SiteKey{function, line}];
+        if (profile.acquisitions == 0) {
+            profile.function = function;
+            profile.line = line;
+        }
+        return profile;
+    }
+    
+    // Mutex held. Call sites ranked by total time spent waiting for the mutex.
+    json contentionReport() const {
+        struct Row {
+            const SiteProfile* profile;
+            HistogramSnapshot wait;
+            HistogramSnapshot hold;
+        };
+        std::vector<Row> rows;
+        uint64_t totalWait = 0, totalHold = 0;
+        for (const auto& [key, profile] : sites_) {
+            Row row{&profile, {}, {}};
+            row.wait.add(profile.wait);
+            row.hold.add(profile.hold);
+            totalWait += row.wait.sum;
+            totalHold += row.hold.sum;
+            rows.push_back(std::move(row));
+        }
+        std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+            if (a.wait.sum != b.wait.sum) return a.wait.sum > b.wait.sum;
+            return a.hold.sum > b.hold.sum;
+        });
+        
+        json sites = json::array();
+        for (const Row& row : rows) {
+            const SiteProfile& p = *row.profile;
+            sites.push_back({
+                {"site", std::string(p.function) + ":" + std::to_string(p.line)},
+                {"function", p.function},
+                {"line", p.line},
+                {"acquisitions", p.acquisitions},
+                {"contended", p.contended},
+                {"meanWaiters", p.acquisitions ? static_cast<double>(p.waiters) / p.acquisitions : 0.0},
+                {"maxWaiters", p.maxWaiters},
+                {"waitShare", totalWait ? static_cast<double>(row.wait.sum) / totalWait : 0.0},
+                {"wait", row.wait.to_json()},
+                {"hold", row.hold.to_json()}
+            });
+        }
+        
+        auto windowEnd = profiling() ? std::chrono::steady_clock::now() : profileStopped_;
+        double window = sites_.empty() && !profiling()
+            ? 0.0 : std::chrono::duration<double>(windowEnd - profileStarted_).count();
+        return {
+            {"enabled", profiling()},
+            {"windowSeconds", window},
+            {"totalWaitSeconds", totalWait / 1e9},
+            {"totalHoldSeconds", totalHold / 1e9},
+            {"sites", sites}
+        };
+    }
+    
+private:
+    struct SiteKey {
+        const char* function;
+        int line;
+        bool operator==(const SiteKey& other) const {
+            return line == other.line && (function == other.function || std::strcmp(function, other.function) == 0);
+        }
+    };
+    struct SiteKeyHash {
+        size_t operator()(const SiteKey& key) const {
+            size_t h = 0;
+            for (const char* c = key.function; *c; c++) h = h * 131 + static_cast<unsigned char>(*c);
+            return h ^ static_cast<size_t>(mix64(static_cast<uint64_t>(key.line)));
+        }
+    };
+    
+    std::mutex mutex_;
+    EngineMetrics& metrics_;
+    std::atomic<int> waiting_{0};
+    std::atomic<bool> profiling_{false};
+    std::chrono::steady_clock::time_point profileStarted_;
+    std::chrono::steady_clock::time_point profileStopped_;
+    std::unordered_map<SiteKey, SiteProfile, SiteKeyHash> sites_;
+};
+
+// Scoped lock of mutex_ that, while profiling is on, charges its wait and
+// hold time to the calling function and line
+class EngineLock {
+public:
+    explicit EngineLock(TimedMutex& mutex, const char* function = CINEMA_CALLER_FUNCTION,
+                        int line = CINEMA_CALLER_LINE)
+        : mutex_(mutex) {
+        uint64_t waiters = 0;
+        uint64_t waited;
+        {
+            TraceSpan span("lock.wait");
+            if (!mutex_.profiling()) {
+                mutex_.lock();
+                return;
+            }
+            waited = mutex_.acquire(&waiters);
+        }
+        if (!mutex_.profiling()) return;  // Switched off while we waited
+        site_ = &mutex_.site(function, line);
+        site_->acquisitions++;
+        if (waited > 0) site_->contended++;
+        site_->waiters += waiters;
+        site_->maxWaiters = std::max(site_->maxWaiters, waiters);
+        site_->wait.record(waited);
+        acquired_ = std::chrono::steady_clock::now();
+    }
+    ~EngineLock() {
+        // The site table only changes under the mutex, so site_ is still valid
+        if (site_) site_->hold.record(elapsedNanos(acquired_));
+        mutex_.unlock();
+    }
+    EngineLock(const EngineLock&) = delete;
+    EngineLock& operator=(const EngineLock&) = delete;
+    
+private:
+    TimedMutex& mutex_;
+    TimedMutex::SiteProfile* site_ = nullptr;
+    std::chrono::steady_clock::time_point acquired_;
+};
+
+// Booking System implementation - owns all engine state behind the
+// BookingSystem facade declared in cinema_core.h
+class BookingSystem::Impl {
+public:
+    explicit Impl(const std::string& dataDir) : dataDir_(dataDir) {
+        // Try to load existing bookings when the system starts
+        try {
+            loadBookings("bookings");
+            rebuildAnalytics();
+            if (bookings_.empty()) {
+                ENGINE_LOG(LogLevel::Info, "No bookings found. Initializing with an empty list.");
+            }
+        } catch (const std::exception& e) {
+            ENGINE_LOG(LogLevel::Warn, "Failed to load existing bookings", {{"error", e.what()}});
+            bookings_.clear(); // Ensure bookings_ is initialized
+            bookingIndex_.clear();
+            bookedShowtimes_.clear();
+        }
+    }
+    
+    ~Impl() {
+        // Clean up the movie binary search tree
+        clearMovieTree(movieTreeRoot_);
+    }
+    
+    EngineMetrics& metrics() const { return metrics_; }
+    
+    // Lock contention profiling of mutex_; see TimedMutex
+    void setLockProfiling(bool enabled) {
+        EngineLock lock(mutex_);
+        mutex_.setProfiling(enabled);
+    }
+    
+    json lockContentionReport() const {
+        std::lock_guard<TimedMutex> lock(mutex_);  // Not an EngineLock: the report should not profile itself
+        return mutex_.contentionReport();
+    }
+    
+    // Sketch mode drops the exact per-user counts; leaving it recounts them
+    // from bookings_
+    void setSketchAnalytics(bool enabled) {
+        EngineLock lock(mutex_);
+        std::unordered_map<std::string, int> users;
+        if (!enabled) {
+            for (const auto& booking : bookings_) {
+                if (!booking.isCancelled()) {
+                    users[booking.getUserId()]++;
+                }
+            }
+        }
+        std::lock_guard<std::mutex> analyticsLock(analyticsMutex_);
+        sketchAnalytics_ = enabled;
+        analytics_.activeBookingsByUser.swap(users);
+        analytics_.uniqueUsers = static_cast<long long>(analytics_.activeBookingsByUser.size());
+    }
+    
+    bool sketchAnalyticsEnabled() const {
+        std::lock_guard<std::mutex> analyticsLock(analyticsMutex_);
+        return sketchAnalytics_;
+    }
+    
+    // Movie operations with optimized data structures
+    void loadMovies(const std::string& filename) {
+        EngineLock lock(mutex_);
+        PersistTimer persistTimer(metrics_, PersistOp::LoadMovies);
+        movies_.clear();
+        movieMap_.clear();
+        clearMovieTree(movieTreeRoot_);
+        movieTreeRoot_ = nullptr;
+
+        try {
+            // Read the JSON file
+            std::ifstream file(filename);
+            if (!file.is_open()) {
+                ENGINE_LOG(LogLevel::Error, "Could not open file", {{"file", filename}});
+                return;
+            }
+
+            json data;
+            try {
+                file >> data;
+            } catch (const json::parse_error& e) {
+                ENGINE_LOG(LogLevel::Error, "Error parsing JSON", {{"file", filename}, {"error", e.what()}});
+                return;
+            }
+
+            // Process the movies with optimized data structures
+            if (data.is_array()) {
+                for (const auto& movie_json : data) {
+                    try {
+                        Movie movie = Movie::from_json(movie_json);
+                        movies_.push_back(movie);
+                        // Add to movie map for O(1) lookups
+                        movieMap_[movie.getId()] = movie;
+                        // Add to the binary search tree
+                        insertMovieToTree(movieTreeRoot_, movie);
+                    } catch (const std::exception& e) {
+                        ENGINE_LOG(LogLevel::Error, "Error parsing movie", {{"error", e.what()}});
+                    }
+                }
+            }
+
+            // Add movies from existing bookings if not already loaded
+            for (const auto& booking : bookings_) {
+                int movieId = booking.getMovieId();
+                auto it = std::find_if(movies_.begin(), movies_.end(),
+                                       [movieId](const Movie& m) { return m.getId() == movieId; });
+                if (it == movies_.end()) {
+                    // Create a placeholder movie with minimal details from the booking
+                    movies_.push_back(Movie(
+                        movieId,
+                        booking.getMovieTitle(),
+                        booking.getMoviePoster(),
+                        "", // No banner available
+                        "", // No description available
+                        0.0, // No rating available
+                        "", // No duration available
+                        "", // No release date available
+                        "", // No genres available
+                        "", // No language available
+                        "", // No director available
+                        ""  // No cast available
+                    ));
+                }
+            }
+
+            ENGINE_LOG(LogLevel::Info, "Loaded movies", {{"count", movies_.size()}, {"file", filename}});
+        } catch (const std::exception& e) {
+            ENGINE_LOG(LogLevel::Error, "Error loading movies", {{"file", filename}, {"error", e.what()}});
+        }
+    }
+    
+    std::vector<Movie> getAllMovies() const {
+        EngineLock lock(mutex_);
+        return movies_;
+    }
+    
+    // Get movies in sorted order using in-order traversal of BST
+    std::vector<Movie> getSortedMovies() const {
+        EngineLock lock(mutex_);
+        std::vector<Movie> sortedMovies;
+        inOrderTraversal(movieTreeRoot_, sortedMovies);
+        return sortedMovies;
+    }
+    
+    // Get popular movies from the incrementally maintained ranking - O(count)
+    std::vector<Movie> getPopularMovies(int count) const {
+        EngineLock lock(mutex_);
+        std::lock_guard<std::mutex> analyticsLock(analyticsMutex_);
+        std::vector<Movie> result;
+        
+        ranking_.forEachTop([&](int movieId, long long) {
+            if (static_cast<int>(result.size()) >= count) return false;
+            auto it = movieMap_.find(movieId);
+            if (it != movieMap_.end()) {
+                result.push_back(it->second);
+            }
+            return true;
+        });
+        
+        return result;
+    }
+    
+    // Movies ranked by recent bookings, each weighted by exp(-age / decay) with
+    // the configured half-life (24 hours by default)
+    std::vector<Movie> getTrendingMovies(int count) const {
+        EngineLock lock(mutex_);
+        std::lock_guard<std::mutex> analyticsLock(analyticsMutex_);
+        std::vector<Movie> result;
+        
+        // Over-fetch a little in case some ranked movies are no longer in the catalog
+        size_t fetch = static_cast<size_t>(std::max(count, 0)) * 2 + 8;
+        for (const auto& [movieId, score] : ranking_.topTrending(fetch, now_seconds())) {
+            if (static_cast<int>(result.size()) >= count) break;
+            auto it = movieMap_.find(movieId);
+            if (it != movieMap_.end()) {
+                result.push_back(it->second);
+            }
+        }
+        
+        return result;
+    }
+    
+    void setTrendingHalfLife(double hours) {
+        EngineLock lock(mutex_);
+        std::lock_guard<std::mutex> analyticsLock(analyticsMutex_);
+        ranking_.setHalfLife(hours);
+        for (const auto& booking : bookings_) {
+            if (!booking.isCancelled()) {
+                ranking_.addTrending(booking.getMovieId(), bookingEventTime(booking), +1);
+            }
+        }
+    }
+    
+    Movie getMovieById(int id) const {
+        EngineLock lock(mutex_);
+        // O(1) lookup using hash map
+        auto it = movieMap_.find(id);
+        if (it != movieMap_.end()) {
+            return it->second;
+        }
+        // Return empty movie if not found
+        return Movie();
+    }
+
+    bool addMovie(const Movie& movie) {
+        try {
+            // Check if movie with this ID already exists
+            int movieId = movie.getId();
+            auto it = std::find_if(movies_.begin(), movies_.end(),
+                                   [movieId](const Movie& m) { return m.getId() == movieId; });
+            
+            // Lock for thread safety
+            EngineLock lock(mutex_);
+            
+            // If movie exists, update it; otherwise add new movie
+            if (it != movies_.end()) {
+                *it = movie;
+                ENGINE_LOG(LogLevel::Info, "Updated movie", {{"movieId", movieId}});
+            } else {
+                movies_.push_back(movie);
+                ENGINE_LOG(LogLevel::Info, "Added new movie", {{"movieId", movieId}});
+            }
+            
+            return true;
+        } catch (const std::exception& e) {
+            ENGINE_LOG(LogLevel::Error, "Error adding movie", {{"error", e.what()}});
+            return false;
+        }
+    }
+
+    bool saveMovies(const std::string& filename) const {
+        PersistTimer persistTimer(metrics_, PersistOp::SaveMovies);
+        try {
+            std::filesystem::path dataDir = dataDirectory();
+            std::filesystem::path fullPath = dataDir / (filename + ".json");
+    
+            // Ensure the data directory exists
+            if (!std::filesystem::exists(dataDir)) {
+                std::filesystem::create_directories(dataDir);
+            }
+    
+            // Convert movies to JSON
+            json movies_json = json::array();
+            for (const auto& movie : movies_) {
+                json movie_json;
+                movie_json["id"] = movie.getId();
+                movie_json["title"] = movie.getTitle();
+                movie_json["poster"] = movie.getPoster();
+                movie_json["banner"] = movie.getBanner();
+                movie_json["description"] = movie.getDescription();
+                movie_json["rating"] = movie.getRating();
+                movie_json["duration"] = movie.getDuration();
+                movie_json["releaseDate"] = movie.getReleaseDate();
+                
+                // Parse genres string into JSON array
+                std::string genres_str = movie.getGenres();
+                json genres_json = json::array();
+                std::istringstream genres_stream(genres_str);
+                std::string genre;
+                while (std::getline(genres_stream, genre, ',')) {
+                    std::string trimmed_genre = trim(genre);
+                    if (!trimmed_genre.empty()) {
+                        genres_json.push_back(trimmed_genre);
+                    }
+                }
+                movie_json["genres"] = genres_json;
+                
+                movie_json["language"] = movie.getLanguage();
+                movie_json["director"] = movie.getDirector();
+                
+                // Parse cast string into JSON array
+                std::string cast_str = movie.getCast();
+                json cast_json = json::array();
+                std::istringstream cast_stream(cast_str);
+                std::string actor;
+                while (std::getline(cast_stream, actor, ',')) {
+                    std::string trimmed_actor = trim(actor);
+                    if (!trimmed_actor.empty()) {
+                        cast_json.push_back(trimmed_actor);
+                    }
+                }
+                movie_json["cast"] = cast_json;
+                
+                movies_json.push_back(movie_json);
+            }
+            
+            // Write JSON to file with explicit open mode
+            std::ofstream file(fullPath, std::ios::out | std::ios::trunc);
+            if (!file.is_open()) {
+                throw std::runtime_error("Could not open file " + fullPath.string() + " for writing");
+            }
+
+            file << movies_json.dump(2); // Write formatted JSON
+            file.close();
+
+            ENGINE_LOG(LogLevel::Info, "Saved movies", {{"count", movies_.size()}, {"file", fullPath.string()}});
+            return true;
+        } catch (const std::exception& e) {
+            ENGINE_LOG(LogLevel::Error, "Error saving movies", {{"file", filename}, {"error", e.what()}});
+            return false;
+        }
+    }
+    
+    // Cinema operations with optimized hash maps
+    void loadCinemas(const std::string& filename) {
+        EngineLock lock(mutex_);
+        PersistTimer persistTimer(metrics_, PersistOp::LoadCinemas);
+        cinemas_.clear();
+        cinemaMap_.clear();
+        showtimeMap_.clear();
+        
+        try {
+            // Read the JSON file
+            std::ifstream file(filename);
+            if (!file.is_open()) {
+                ENGINE_LOG(LogLevel::Error, "Could not open file", {{"file", filename}});
+                return;
+            }
+            
+            json data;
+            try {
+                file >> data;
+            } catch (const json::parse_error& e) {
+                ENGINE_LOG(LogLevel::Error, "Error parsing JSON", {{"file", filename}, {"error", e.what()}});
+                return;
+            }
+            
+            // Process the cinemas with hash maps for O(1) lookup
+            if (data.is_array()) {
+                for (const auto& cinema_json : data) {
+                    try {
+                        Cinema cinema = Cinema::from_json(cinema_json);
+                        cinemas_.push_back(cinema);
+                        // Add to cinema map for O(1) lookups
+                        cinemaMap_[cinema.getId()] = cinema;
+                        
+                        // Add showtimes to showtime map for O(1) lookups
+                        for (const auto& showtime : cinema.getShowtimes()) {
+                            showtimeMap_[showtime.getId()] = showtime;
+                        }
+                    } catch (const std::exception& e) {
+                        ENGINE_LOG(LogLevel::Error, "Error parsing cinema", {{"error", e.what()}});
+                    }
+                }
+            }
+            
+            // Rebuild the capacity side of the occupancy rollups
+            {
+                std::lock_guard<std::mutex> analyticsLock(analyticsMutex_);
+                rollups_.clearCapacity();
+                for (const auto& cinema : cinemas_) {
+                    for (const auto& showtime : cinema.getShowtimes()) {
+                        rollups_.addCapacity(showtime, showtimeCapacity(showtime));
+                    }
+                }
+            }
+            
+            ENGINE_LOG(LogLevel::Info, "Loaded cinemas", {{"count", cinemas_.size()}, {"file", filename}});
+        } catch (const std::exception& e) {
+            ENGINE_LOG(LogLevel::Error, "Error loading cinemas", {{"file", filename}, {"error", e.what()}});
+        }
+    }
+    
+    std::vector<Cinema> getAllCinemas() const {
+        EngineLock lock(mutex_);
+        return cinemas_;
+    }
+    
+    Cinema getCinemaById(int id) const {
+        EngineLock lock(mutex_);
+        // O(1) lookup using hash map
+        auto it = cinemaMap_.find(id);
+        if (it != cinemaMap_.end()) {
+            return it->second;
+        }
+        // Return empty cinema if not found
+        return Cinema();
+    }
+
+    bool addCinema(const Cinema& cinema) {
+        try {
+            // Lock for thread safety
+            EngineLock lock(mutex_);
+            
+            // Check if cinema with this ID already exists
+            int cinemaId = cinema.getId();
+            auto it = std::find_if(cinemas_.begin(), cinemas_.end(),
+                                   [cinemaId](const Cinema& c) { return c.getId() == cinemaId; });
+            
+            // If cinema exists, update it; otherwise add new cinema
+            if (it != cinemas_.end()) {
+                *it = cinema;
+                ENGINE_LOG(LogLevel::Info, "Updated cinema", {{"cinemaId", cinemaId}});
+            } else {
+                cinemas_.push_back(cinema);
+                ENGINE_LOG(LogLevel::Info, "Added new cinema", {{"cinemaId", cinemaId}});
+            }
+            // Keep the map in step so showtimes added later see this cinema's screen layouts
+            cinemaMap_[cinemaId] = cinema;
+            
+            return true;
+        } catch (const std::exception& e) {
+            ENGINE_LOG(LogLevel::Error, "Error adding cinema", {{"error", e.what()}});
+            return false;
+        }
+    }
+    
+    bool saveCinemas(const std::string& filename) const {
+        PersistTimer persistTimer(metrics_, PersistOp::SaveCinemas);
+        try {
+            std::filesystem::path dataDir = dataDirectory();
+            std::filesystem::path fullPath = dataDir / (filename + ".json");
+    
+            // Ensure the data directory exists
+            if (!std::filesystem::exists(dataDir)) {
+                std::filesystem::create_directories(dataDir);
+            }
+    
+            // Convert cinemas to JSON
+            json cinemas_json = json::array();
+            for (const auto& cinema : cinemas_) {
+                json cinema_json;
+                cinema_json["id"] = cinema.getId();
+                cinema_json["name"] = cinema.getName();
+                cinema_json["location"] = cinema.getLocation();
+                cinema_json["screens"] = cinema.getScreens();
+                cinema_json["totalSeats"] = cinema.getTotalSeats();
+                
+                if (!cinema.getScreenLayouts().empty()) {
+                    json layouts_json = json::array();
+                    for (const auto& [screen, layout] : cinema.getScreenLayouts()) {
+                        json layout_json = layout->to_json();
+                        layout_json["screen"] = screen;
+                        layouts_json.push_back(layout_json);
+                    }
+                    cinema_json["screenLayouts"] = layouts_json;
+                }
+                
+                // Convert showtimes to JSON array
+                json showtimes_json = json::array();
+                for (const auto& showtime : cinema.getShowtimes()) {
+                    json showtime_json;
+                    showtime_json["id"] = showtime.getId();
+                    showtime_json["movieId"] = showtime.getMovieId();
+                    showtime_json["cinemaId"] = showtime.getCinemaId();
+                    showtime_json["cinemaName"] = showtime.getCinemaName();
+                    showtime_json["date"] = showtime.getDate();
+                    showtime_json["time"] = showtime.getTime();
+                    showtime_json["screenType"] = showtime.getScreenType();
+                    showtime_json["price"] = showtime.getPrice();
+                    if (showtime.getScreen() != 0) {
+                        showtime_json["screen"] = showtime.getScreen();
+                    }
+                    
+                    // Add booked seats array
+                    json seats_json = json::array();
+                    for (const auto& seat : showtime.getBookedSeats()) {
+                        seats_json.push_back(seat);
+                    }
+                    showtime_json["bookedSeats"] = seats_json;
+                    
+                    showtimes_json.push_back(showtime_json);
+                }
+                cinema_json["showtimes"] = showtimes_json;
+                
+                cinemas_json.push_back(cinema_json);
+            }
+            
+            // Write JSON to file with explicit open mode
+            std::ofstream file(fullPath, std::ios::out | std::ios::trunc);
+            if (!file.is_open()) {
+                throw std::runtime_error("Could not open file " + fullPath.string() + " for writing");
+            }
+
+            file << cinemas_json.dump(2); // Write formatted JSON
+            file.close();
+
+            ENGINE_LOG(LogLevel::Info, "Saved cinemas", {{"count", cinemas_.size()}, {"file", fullPath.string()}});
+            return true;
+        } catch (const std::exception& e) {
+            ENGINE_LOG(LogLevel::Error, "Error saving cinemas", {{"file", filename}, {"error", e.what()}});
+            return false;
+        }
+    }
+    
+    // Showtime operations with optimized hash maps
+    bool addShowtime(Showtime showtime) {
+        try {
+            const std::string id = showtime.getId();
+            const int cinemaId = showtime.getCinemaId();
+
+            // Lock for thread safety
+            EngineLock lock(mutex_);
+
+            // Find the cinema and add the showtime
+            auto it = cinemaMap_.find(cinemaId);
+            if (it != cinemaMap_.end()) {
+                showtime.setLayout(it->second.layoutForScreen(showtime.getScreen()));
+                
+                // Add to showtime map for O(1) lookups
+                showtimeMap_[id] = showtime;
+                
+                // Seat state built against another layout is rebuilt on next use
+                auto state = seatState_.find(id);
+                if (state != seatState_.end() && state->second.layout != showtime.getLayout()) {
+                    seatState_.erase(state);
+                    std::unique_lock<std::shared_mutex> claimsLock(claimsMutex_);
+                    claimsIndex_.erase(id);
+                    stampIndex_.erase(id);
+                }
+
+                // Update both the vector of cinemas and the cinema in the map
+                for (auto& cinema : cinemas_) {
+                    if (cinema.getId() == cinemaId) {
+                        cinema.addShowtime(showtime);
+                        break;
+                    }
+                }
+                
+                Cinema updated = it->second;
+                updated.addShowtime(showtime);
+                cinemaMap_[cinemaId] = updated;
+                
+                {
+                    std::lock_guard<std::mutex> analyticsLock(analyticsMutex_);
+                    rollups_.addCapacity(showtime, showtimeCapacity(showtime));
+                }
+                
+                ENGINE_LOG(LogLevel::Info, "Added showtime", {{"showtimeId", id}, {"cinemaId", cinemaId}});
+                return true;
+            } else {
+                throw std::runtime_error("Cinema with ID " + std::to_string(cinemaId) + " not found");
+            }
+        } catch (const std::exception& e) {
+            ENGINE_LOG(LogLevel::Error, "Error adding showtime", {{"error", e.what()}});
+            return false;
+        }
+    }
+
+    // O(1) lookup for showtime using hash map
+    Showtime getShowtimeById(const std::string& id) const {
+        EngineLock lock(mutex_);
+        auto it = showtimeMap_.find(id);
+        if (it != showtimeMap_.end()) {
+            return it->second;
+        }
+        
+        // Fallback to the old method if not found in the map
+        for (const auto& cinema : cinemas_) {
+            for (const auto& showtime : cinema.getShowtimes()) {
+                if (showtime.getId() == id) {
+                    return showtime;
+                }
+            }
+        }
+        
+        // Return empty showtime if not found
+        return Showtime();
+    }
+    
+    std::vector<Showtime> getShowtimesByMovie(int movieId) const {
+        EngineLock lock(mutex_);
+        std::vector<Showtime> result;
+        
+        for (const auto& cinema : cinemas_) {
+            for (const auto& showtime : cinema.getShowtimes()) {
+                if (showtime.getMovieId() == movieId) {
+                    result.push_back(showtime);
+                }
+            }
+        }
+        
+        return result;
+    }
+    
+    std::vector<Showtime> getShowtimesByDate(const std::string& date) const {
+        EngineLock lock(mutex_);
+        std::vector<Showtime> result;
+        
+        for (const auto& cinema : cinemas_) {
+            for (const auto& showtime : cinema.getShowtimes()) {
+                if (showtime.getDate() == date) {
+                    result.push_back(showtime);
+                }
+            }
+        }
+        
+        return result;
+    }
+    
+    std::vector<Showtime> getShowtimesByMovieAndDate(int movieId, const std::string& date) const {
+        EngineLock lock(mutex_);
+        std::vector<Showtime> result;
+        
+        for (const auto& cinema : cinemas_) {
+            for (const auto& showtime : cinema.getShowtimes()) {
+                if (showtime.getMovieId() == movieId && showtime.getDate() == date) {
+                    result.push_back(showtime);
+                }
+            }
+        }
+        
+        return result;
+    }
+    
+    std::vector<std::string> getBookedSeatsForShowtime(const std::string& showtimeId) {
+        ChangeDispatch dispatch(*this);
+        EngineLock lock(mutex_);
+        syncSharedJournal();
+        return getBookedSeatsForShowtimeInternal(showtimeId);
+    }
+    
+    // Booked seats plus seats currently held (and not yet expired) by any user
+    json getSeatAvailability(const std::string& showtimeId) {
+        ChangeDispatch dispatch(*this);
+        EngineLock lock(mutex_);
+        syncSharedJournal();
+        const ShowtimeSeats& state = seatsFor(showtimeId);
+        
+        json availability;
+        availability["showtimeId"] = showtimeId;
+        availability["booked"] = getBookedSeatsForShowtimeInternal(showtimeId);
+        availability["held"] = heldSeats(state);
+        availability["capacity"] = state.layout->capacity();
+        availability["available"] = state.available() - static_cast<int>(foreignHeldSeats(state).size());
+        return availability;
+    }
+    
+    // Price a seat set with the current rules: total plus a per-seat breakdown
+    json quote(const std::string& showtimeId, const std::vector<std::string>& seats) const {
+        EngineLock lock(mutex_);
+        auto showtime = showtimeMap_.find(showtimeId);
+        if (showtime == showtimeMap_.end()) {
+            throw std::runtime_error("Showtime " + showtimeId + " not found");
+        }
+        const ShowtimeSeats& state = seatsFor(showtimeId);
+        PricingEngine::Quote quote = pricing_.quote(showtime->second, *state.layout, occupancy(state), seats);
+        
+        json seatPrices = json::array();
+        for (size_t i = 0; i < seats.size(); i++) {
+            json item;
+            item["seat"] = seats[i];
+            item["tier"] = state.layout->tiers()[quote.seatTiers[i]];
+            item["price"] = quote.seatCents[i] / 100.0;
+            seatPrices.push_back(item);
+        }
+        
+        json result;
+        result["showtimeId"] = showtimeId;
+        result["basePrice"] = showtime->second.getPrice();
+        result["showtimeMultiplier"] = quote.showtimeMultiplier;
+        result["surgeMultiplier"] = quote.surgeMultiplier;
+        result["seats"] = seatPrices;
+        result["totalPrice"] = quote.totalCents / 100.0;
+        return result;
+    }
+    
+    void setPricingRules(PricingRules rules) {
+        EngineLock lock(mutex_);
+        pricing_.setRules(std::move(rules));
+    }
+    
+    PricingRules getPricingRules() const {
+        EngineLock lock(mutex_);
+        return pricing_.rules();
+    }
+    
+    // Conditional seat map read. If `etag` matches the current state only
+    // {"notModified": true, "etag": ...} is returned. Otherwise booked and held
+    // seats come back as label lists (format "list") or as base64 bitsets over
+    // the layout grid (format "bitmap": bit row * seatsPerRow + column, least
+    // significant bit first in each byte).
+    json getSeatMap(const std::string& showtimeId, const std::string& etag, const std::string& format) {
+        if (!etag.empty()) {
+            json unchanged = notModifiedSeatMap(showtimeId, etag);
+            if (!unchanged.is_null()) {
+                return unchanged;
+            }
+        }
+        ChangeDispatch dispatch(*this);
+        EngineLock lock(mutex_);
+        syncSharedJournal();
+        expireHolds();
+        const ShowtimeSeats& state = seatsFor(showtimeId);
+        
+        json result;
+        std::string current = state.etag();
+        if (shared_) {
+            // Holds in other processes do not move the local version
+            current += "-" + std::to_string(shared_->generation(showtimeId));
+        }
+        result["etag"] = current;
+        result["version"] = state.version;
+        if (!etag.empty() && etag == current) {
+            result["notModified"] = true;
+            return result;
+        }
+        result["notModified"] = false;
+        
+        std::vector<std::string> held = heldSeats(state);
+        if (format == "bitmap") {
+            const SeatLayout& layout = *state.layout;
+            result["format"] = "bitmap";
+            result["rows"] = layout.rows();
+            result["seatsPerRow"] = layout.seatsPerRow();
+            result["booked"] = encodeSeatBits(layout, state.booked.begin(), state.booked.end());
+            result["held"] = encodeSeatBits(layout, held.begin(), held.end());
+        } else if (format == "list") {
+            result["format"] = "list";
+            result["booked"] = getBookedSeatsForShowtimeInternal(showtimeId);
+            result["held"] = held;
+        } else {
+            throw std::runtime_error("Unknown seat map format " + format);
+        }
+        return result;
+    }
+    
+    // The not-modified answer to a conditional seat map read, decided from the
+    // published stamp without mutex_, or null when the full path must run:
+    // the ETag differs, a hold may have lapsed, or other processes share the
+    // inventory (their changes arrive through the journal under mutex_).
+    json notModifiedSeatMap(const std::string& showtimeId, const std::string& etag) const {
+        if (sharedInventory_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        std::shared_ptr<const SeatMapStamp> stamp;
+        {
+            std::shared_lock<std::shared_mutex> claimsLock(claimsMutex_);
+            auto it = stampIndex_.find(showtimeId);
+            if (it == stampIndex_.end()) {
+                return nullptr;
+            }
+            stamp = it->second;
+        }
+        uint64_t version = stamp->version.load(std::memory_order_acquire);
+        if (currentHoldTick() >= stamp->holdExpiryTick.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        std::string current = seat_etag(stamp->epoch, version);
+        if (etag != current) {
+            return nullptr;
+        }
+        json result;
+        result["etag"] = current;
+        result["version"] = version;
+        result["notModified"] = true;
+        return result;
+    }
+    
+    // Seat deltas after `sinceVersion`. If the log no longer reaches back that
+    // far, "reset" is set and the full booked/held state is included instead.
+    json seatChangesSince(const std::string& showtimeId, uint64_t sinceVersion) {
+        ChangeDispatch dispatch(*this);
+        EngineLock lock(mutex_);
+        syncSharedJournal();
+        const ShowtimeSeats& state = seatsFor(showtimeId);
+        
+        json result;
+        result["showtimeId"] = showtimeId;
+        result["version"] = state.version;
+        
+        uint64_t oldest = state.changes.empty() ? state.version + 1 : state.changes[0].version;
+        bool reset = sinceVersion > state.version || (sinceVersion < state.version && sinceVersion + 1 < oldest);
+        result["reset"] = reset;
+        
+        json changes = json::array();
+        if (reset) {
+            result["booked"] = getBookedSeatsForShowtimeInternal(showtimeId);
+            result["held"] = heldSeats(state);
+        } else {
+            for (size_t i = 0; i < state.changes.size(); i++) {
+                if (state.changes[i].version > sinceVersion) {
+                    changes.push_back(state.changes[i].to_json());
+                }
+            }
+        }
+        result["changes"] = changes;
+        return result;
+    }
+    
+    // Call `callback(change)` for every seat change of showtimeId (all showtimes
+    // if empty), after the change is committed. Returns an id for unsubscribing.
+    int subscribeSeatChanges(const std::function<void(const SeatChange&)>& callback, const std::string& showtimeId) {
+        // Copy the callback before taking subscribersMutex_: copying a
+        // Python-backed std::function takes the GIL
+        auto shared = std::make_shared<const std::function<void(const SeatChange&)>>(callback);
+        std::lock_guard<std::mutex> lock(subscribersMutex_);
+        int id = nextSubscriberId_++;
+        seatSubscribers_[id] = {showtimeId, std::move(shared)};
+        hasSeatSubscribers_ = true;
+        return id;
+    }
+    
+    bool unsubscribeSeatChanges(int id) {
+        SeatSubscriber removed;
+        {
+            std::lock_guard<std::mutex> lock(subscribersMutex_);
+            auto it = seatSubscribers_.find(id);
+            if (it == seatSubscribers_.end()) {
+                return false;
+            }
+            removed = std::move(it->second);
+            seatSubscribers_.erase(it);
+            hasSeatSubscribers_ = !seatSubscribers_.empty();
+        }
+        return true;  // The callback is destroyed here, outside subscribersMutex_
+    }
+    
+    // Seat plan of the screen a showtime runs on
+    json getSeatLayout(const std::string& showtimeId) const {
+        EngineLock lock(mutex_);
+        return seatsFor(showtimeId).layout->describe();
+    }
+    
+    // Booking operations
+    // An optional "idempotencyKey" makes retries safe: a repeated request with
+    // the same key and payload returns the original booking unchanged.
+    Booking createBooking(const BookingRequest& request) {
+        try {
+            Booking booking = makeBooking(request);
+            const std::string& idempotencyKey = request.idempotencyKey;
+            uint64_t fingerprint = idempotencyKey.empty() ? 0 : requestFingerprint(booking);
+            uint64_t ticket = request.admissionTicket;
+            
+            // A retry is answered before it is admitted or claims any seat
+            if (!idempotencyKey.empty()) {
+                if (std::optional<std::string> originalId = idempotentBookingId(idempotencyKey, fingerprint)) {
+                    EngineLock lock(mutex_);
+                    syncSharedJournal();
+                    return idempotentBooking(idempotencyKey, *originalId);
+                }
+            }
+            
+            // Wait our turn for this showtime, then claim the seats without the
+            // engine lock so a buyer who lost the race is turned away at once
+            AdmissionController::Lease lease;
+            {
+                TraceSpan span("admission");
+                lease = admission_.acquire(booking.getShowtimeId(), booking.getUserId(), ticket);
+            }
+            std::shared_ptr<SeatClaims> claims;
+            std::vector<size_t> claimed;
+            bool optimistic;
+            {
+                TraceSpan span("claimSeats");
+                optimistic = claimSeatsOptimistically(booking, !idempotencyKey.empty(), claims, claimed);
+            }
+            if (optimistic) {
+                optimisticClaims_.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                lockedFallbacks_.fetch_add(1, std::memory_order_relaxed);
+            }
+            
+            // Only the in-memory commit runs under the engine lock; the booking
+            // is written to disk after the lock is released
+            ChangeDispatch dispatch(*this);
+            BookingWrite write;
+            {
+                EngineLock lock(mutex_);
+                syncSharedJournal();
+                // Checked again: a concurrent request with the same key may have committed since
+                if (!idempotencyKey.empty()) {
+                    if (std::optional<std::string> originalId = idempotentBookingId(idempotencyKey, fingerprint)) {
+                        releaseClaims(booking.getShowtimeId(), claims, claimed);
+                        return idempotentBooking(idempotencyKey, *originalId);
+                    }
+                }
+                
+                expireHolds();
+                try {
+                    write = commitBooking(booking);
+                } catch (const std::exception&) {
+                    releaseClaims(booking.getShowtimeId(), claims, claimed);
+                    throw;
+                }
+                if (!idempotencyKey.empty()) {
+                    std::lock_guard<std::mutex> keyLock(idempotencyMutex_);
+                    idempotentBookings_.insert(idempotencyKey, fingerprint, booking.getId(), steady_seconds());
+                }
+            }
+            if (!appendBooking(write)) {
+                EngineLock lock(mutex_);
+                saveBookings("bookings");
+            }
+            return booking;
+        } catch (const std::exception& e) {
+            ENGINE_LOG(LogLevel::Error, "Error creating booking", {{"error", e.what()}});
+            throw; // Re-throw to let the caller handle the exception
+        }
+    }
+    
+    // All-or-nothing batch of bookings, possibly across showtimes. Every booking is validated
+    // before any is applied, and the batch is persisted and journaled once. The engine lock
+    // covers every showtime, so the batch is one critical section; showtimes are visited in
+    // sorted order.
+    std::vector<Booking> createBookings(const std::vector<BookingRequest>& requests) {
+        try {
+            if (requests.empty()) {
+                throw std::runtime_error("No bookings in batch");
+            }
+            std::vector<Booking> bookings;
+            for (const auto& request : requests) {
+                bookings.push_back(makeBooking(request));
+            }
+            
+            std::vector<size_t> order(bookings.size());
+            for (size_t i = 0; i < order.size(); i++) order[i] = i;
+            std::stable_sort(order.begin(), order.end(), [&bookings](size_t a, size_t b) {
+                return bookings[a].getShowtimeId() < bookings[b].getShowtimeId();
+            });
+            
+            // One admission slot per showtime, taken in the same sorted order
+            std::vector<AdmissionController::Lease> leases;
+            for (size_t k = 0; k < order.size(); k++) {
+                const Booking& booking = bookings[order[k]];
+                if (k == 0 || booking.getShowtimeId() != bookings[order[k - 1]].getShowtimeId()) {
+                    leases.push_back(admission_.acquire(booking.getShowtimeId(), booking.getUserId()));
+                }
+            }
+            
+            ChangeDispatch dispatch(*this);
+            EngineLock lock(mutex_);
+            syncSharedJournal();
+            expireHolds();
+            
+            // Seats claimed by earlier bookings of the batch, per showtime
+            std::unordered_map<std::string, std::unordered_set<std::string>> claimed;
+            for (size_t i : order) {
+                try {
+                    validateBooking(bookings[i]);
+                    auto& seats = claimed[bookings[i].getShowtimeId()];
+                    for (const auto& seat : bookings[i].getSeats()) {
+                        if (!seats.insert(seat).second) {
+                            throw std::runtime_error("Seat " + seat + " is requested twice in the batch");
+                        }
+                    }
+                } catch (const std::exception& e) {
+                    throw std::runtime_error("Booking " + std::to_string(i) + ": " + e.what());
+                }
+            }
+            
+            // Take the seats from other processes too; a conflict undoes the batch's claims
+            std::vector<std::pair<size_t, std::vector<std::string>>> sharedClaims;
+            for (size_t i : order) {
+                try {
+                    sharedClaims.emplace_back(i, claimShared(seatsFor(bookings[i].getShowtimeId()), bookings[i].getSeats()));
+                } catch (const std::exception& e) {
+                    for (const auto& [index, seats] : sharedClaims) {
+                        releaseShared(seatsFor(bookings[index].getShowtimeId()), seats);
+                    }
+                    throw std::runtime_error("Booking " + std::to_string(i) + ": " + e.what());
+                }
+            }
+            
+            // One journal entry for the batch, so other processes apply all of it or none
+            json journal = json::array();
+            for (const auto& booking : bookings) {
+                applyBooking(booking);
+                journal.push_back(booking.to_json());
+            }
+            journalShared(SharedSeatInventory::EntryKind::Batch, journal.dump());
+            saveBookings("bookings");
+            
+            ENGINE_LOG(LogLevel::Info, "Created batch of bookings",
+                       {{"bookings", bookings.size()}, {"showtimes", claimed.size()}});
+            return bookings;
+        } catch (const std::exception& e) {
+            ENGINE_LOG(LogLevel::Error, "Error creating bookings", {{"error", e.what()}});
+            throw;
+        }
+    }
+    
+    // Waiting room: take a ticket ahead of booking, poll its position, then pass
+    // it as "admissionTicket" to createBooking to keep the place in line
+    json enterWaitingRoom(const std::string& showtimeId, const std::string& userId) {
+        uint64_t ticket = admission_.enter(showtimeId, userId);
+        json result;
+        result["ticket"] = ticket;
+        result["position"] = admission_.position(showtimeId, ticket);
+        return result;
+    }
+    
+    int getQueuePosition(const std::string& showtimeId, uint64_t ticket) {
+        return admission_.position(showtimeId, ticket);
+    }
+    
+    void configureAdmission(AdmissionConfig config) {
+        config.maxConcurrent = std::max(1, config.maxConcurrent);
+        admission_.configure(config);
+    }
+    
+    AdmissionConfig getAdmissionConfig() const {
+        return admission_.config();
+    }
+    
+    // Active and queued requests per showtime
+    json getAdmissionStats() const {
+        return admission_.stats();
+    }
+    
+    // How createBooking requests settled their seats: claimed without the
+    // engine lock, sent to the locked path, or turned away on a conflict
+    // without it (rejected; conflicts also counts conflicts that fell back)
+    json getSeatClaimStats() const {
+        json stats;
+        stats["optimisticClaims"] = optimisticClaims_.load(std::memory_order_relaxed);
+        stats["conflicts"] = claimConflicts_.load(std::memory_order_relaxed);
+        stats["rejected"] = claimRejections_.load(std::memory_order_relaxed);
+        stats["lockedFallbacks"] = lockedFallbacks_.load(std::memory_order_relaxed);
+        return stats;
+    }
+    
+    // Share seat inventory with the other engine processes on this host (e.g.
+    // pre-forked server workers) through a POSIX shared memory segment. The
+    // first process to open it seeds it with its bookings and holds; every
+    // process then replays the others' booking changes from the segment journal.
+    void enableSharedInventory(const std::string& name, bool reset) {
+        ChangeDispatch dispatch(*this);
+        EngineLock lock(mutex_);
+        if (shared_) {
+            throw std::runtime_error("Shared seat inventory is already enabled");
+        }
+        auto inventory = std::make_unique<SharedSeatInventory>(name, reset);
+        if (inventory->created()) {
+            std::map<std::string, std::vector<std::string>> seats;
+            for (const auto& booking : bookings_) {
+                if (!booking.isCancelled()) {
+                    auto& list = seats[booking.getShowtimeId()];
+                    list.insert(list.end(), booking.getSeats().begin(), booking.getSeats().end());
+                }
+            }
+            for (const auto& [token, hold] : holds_) {
+                auto& list = seats[hold.showtimeId];
+                list.insert(list.end(), hold.seats.begin(), hold.seats.end());
+            }
+            for (const auto& [showtimeId, list] : seats) {
+                try {
+                    inventory->claim(showtimeId, sharedSeatBits(seatsFor(showtimeId), list));
+                } catch (const std::exception& e) {
+                    ENGINE_LOG(LogLevel::Warn, "Showtime not shared", {{"showtimeId", showtimeId}, {"error", e.what()}});
+                }
+            }
+            inventory->markReady();
+        }
+        shared_ = std::move(inventory);
+        sharedInventory_ = true;
+        journalCursor_ = 0;
+        syncSharedJournal();
+        ENGINE_LOG(LogLevel::Info, shared_->created() ? "Created shared seat inventory" : "Attached to shared seat inventory",
+                   {{"name", name}});
+    }
+    
+    // Reserve seats for a user for ttlSeconds; returns the hold token
+    std::string holdSeats(const std::string& showtimeId, const std::vector<std::string>& seats,
+                          const std::string& userId, double ttlSeconds) {
+        if (seats.empty()) {
+            throw std::runtime_error("No seats to hold");
+        }
+        AdmissionController::Lease lease = admission_.acquire(showtimeId, userId);
+        ChangeDispatch dispatch(*this);
+        EngineLock lock(mutex_);
+        syncSharedJournal();
+        expireHolds();
+        return placeHold(showtimeId, seats, userId, ttlSeconds);
+    }
+    
+    // Best contiguous block of `count` seats, nearest the sweet spot. With
+    // prefs.hold the block is held in the same critical section it was found in.
+    json findBestSeats(const std::string& showtimeId, int count, const SeatPreferences& prefs) {
+        if (prefs.hold && prefs.userId.empty()) {
+            throw std::runtime_error("userId is required to hold seats");
+        }
+        
+        AdmissionController::Lease lease;
+        if (prefs.hold) {
+            lease = admission_.acquire(showtimeId, prefs.userId);
+        }
+        ChangeDispatch dispatch(*this);
+        EngineLock lock(mutex_);
+        syncSharedJournal();
+        expireHolds();
+        const ShowtimeSeats& state = seatsFor(showtimeId);
+        SeatBlock block;
+        bool found;
+        if (shared_) {
+            // Seats other processes hold are taken too
+            SeatBitmap taken = state.taken;
+            taken.orWords(shared_->snapshot(showtimeId));
+            found = findBestBlock(taken, count, prefs, block);
+        } else {
+            found = findBestBlock(state.taken, count, prefs, block);
+        }
+        
+        json result;
+        result["found"] = found;
+        result["seats"] = block.seats;
+        if (found) {
+            result["row"] = seat_label(block.row, 0).substr(0, 1);
+            result["score"] = block.score;
+            if (prefs.hold) {
+                result["holdToken"] = placeHold(showtimeId, block.seats, prefs.userId, prefs.ttlSeconds);
+            }
+        }
+        return result;
+    }
+    
+    // Turn a hold into a booking; seats and showtime come from the hold
+    Booking confirmHold(const std::string& token, BookingRequest request) {
+        try {
+            ChangeDispatch dispatch(*this);
+            EngineLock lock(mutex_);
+            syncSharedJournal();
+            expireHolds();
+            
+            auto it = holds_.find(token);
+            if (it == holds_.end()) {
+                throw std::runtime_error("Hold " + token + " not found or expired");
+            }
+            if (!request.userId.empty() && request.userId != it->second.userId) {
+                throw std::runtime_error("Hold " + token + " belongs to another user");
+            }
+            request.userId = it->second.userId;
+            request.showtimeId = it->second.showtimeId;
+            request.seats = it->second.seats;
+            
+            // Without a client total, the booking is charged the current quote
+            auto showtime = showtimeMap_.find(it->second.showtimeId);
+            if (!request.totalPrice && showtime != showtimeMap_.end()) {
+                const ShowtimeSeats& state = seatsFor(it->second.showtimeId);
+                request.totalPrice =
+                    pricing_.quote(showtime->second, *state.layout, occupancy(state), it->second.seats).totalCents / 100.0;
+            }
+            
+            Booking booking = makeBooking(request);
+            if (!appendBooking(commitBooking(booking))) {
+                saveBookings("bookings");
+            }
+            return booking;
+        } catch (const std::exception& e) {
+            ENGINE_LOG(LogLevel::Error, "Error confirming hold", {{"error", e.what()}});
+            throw;
+        }
+    }
+    
+    bool releaseHold(const std::string& token) {
+        ChangeDispatch dispatch(*this);
+        EngineLock lock(mutex_);
+        expireHolds();
+        auto it = holds_.find(token);
+        if (it == holds_.end()) {
+            return false;
+        }
+        holdWheel_.cancel(it->second.timer);
+        dropHold(it);
+        return true;
+    }
+    
+    Booking getBookingById(const std::string& id) const {
+        EngineLock lock(mutex_);
+        if (const Booking* booking = findBooking(id)) {
+            return *booking;
+        }
+        // Return empty booking if not found
+        return Booking();
+    }
+    
+    bool cancelBooking(const std::string& id) {
+        ChangeDispatch dispatch(*this);
+        EngineLock lock(mutex_);
+        syncSharedJournal();
+        Booking* it = findBooking(id);
+        if (it) {
+            // Cancelling twice must not release the seats or reverse the analytics twice
+            if (!it->isCancelled()) {
+                recordAnalytics(*it, -1, true);
+                
+                // Cancel booking
+                it->cancel();
+                
+                // Update showtime seats
+                updateShowtimeSeats(it->getShowtimeId(), it->getSeats(), false);
+                releaseShared(seatsFor(it->getShowtimeId()), it->getSeats());
+                journalShared(SharedSeatInventory::EntryKind::Cancelled, id);
+            }
+            
+            // Save bookings
+            saveBookings("bookings");
+            
+            return true;
+        }
+        return false;
+    }
+    
+    bool restoreBooking(const std::string& id) {
+        ChangeDispatch dispatch(*this);
+        EngineLock lock(mutex_);
+        syncSharedJournal();
+        Booking* it = findBooking(id);
+        if (it && it->isCancelled()) {
+            expireHolds();
+            
+            // Check if seats are still available (not rebooked or held by someone else)
+            ShowtimeSeats& state = seatsFor(it->getShowtimeId());
+            try {
+                checkSeatsFree(state, it->getSeats(), it->getUserId());
+                claimShared(state, it->getSeats());
+            } catch (const std::exception&) {
+                return false;
+            }
+            for (const auto& seat : it->getSeats()) {
+                releaseHeldSeat(state, seat);
+            }
+            
+            // Restore booking
+            it->restore();
+            recordAnalytics(*it, +1, true);
+            
+            // Update showtime seats
+            updateShowtimeSeats(it->getShowtimeId(), it->getSeats(), true);
+            journalShared(SharedSeatInventory::EntryKind::Restored, id);
+            
+            // Save bookings
+            saveBookings("bookings");
+            
+            return true;
+        }
+        return false;
+    }
+    
+    std::vector<Booking> getBookingsByUser(const std::string& userId) const {
+        EngineLock lock(mutex_);
+        std::vector<Booking> result;
+        
+        for (const auto& booking : bookings_) {
+            if (booking.getUserId() == userId) {
+                result.push_back(booking);
+            }
+        }
+        
+        return result;
+    }
+    
+    std::vector<Booking> getAllBookings() const {
+        EngineLock lock(mutex_);
+        return bookings_;
+    }
+    
+    // Analytics operations - reads the running aggregates without taking mutex_.
+    // With approximate=true, user counts and top lists come from the sketches;
+    // in sketch mode they always do.
+    // The per-day, movie and screen type breakdown is published as an
+    // immutable snapshot. A read that finds it current copies only scalars
+    // under analyticsMutex_; the first read after a booking change also copies
+    // the three breakdown maps there, then rebuilds and publishes the snapshot
+    // outside the lock.
+    json getAnalytics(bool approximate = false) const {
+        json analytics = json::object();
+        long long totalBookings = 0;
+        long long cancelledBookings = 0;
+        long long revenueCents = 0;
+        long long uniqueUsers = 0;
+        std::shared_ptr<const json> breakdown;
+        std::shared_ptr<const json> sketches;
+        uint64_t version = 0;
+        AnalyticsAggregates changed;
+        {
+            std::lock_guard<std::mutex> analyticsLock(analyticsMutex_);
+            approximate = approximate || sketchAnalytics_;
+            if (approximate) {
+                // Sketch estimates are summarised once per change, not per read
+                if (sketchSnapshotVersion_ != analyticsVersion_ || !sketchSnapshot_) {
+                    json summary = json::object();
+                    addSketchAnalytics(summary);
+                    sketchSnapshot_ = std::make_shared<const json>(std::move(summary));
+                    sketchSnapshotVersion_ = analyticsVersion_;
+                }
+                sketches = sketchSnapshot_;
+            }
+            totalBookings = analytics_.activeBookings;
+            cancelledBookings = analytics_.cancelledBookings;
+            revenueCents = analytics_.revenueCents;
+            uniqueUsers = analytics_.uniqueUsers;
+            version = analyticsVersion_;
+            if (breakdownVersion_ == version && breakdown_) {
+                breakdown = breakdown_;
+            } else {
+                changed.dailyRevenue = analytics_.dailyRevenue;
+                changed.movieBookings = analytics_.movieBookings;
+                changed.screenTypeBookings = analytics_.screenTypeBookings;
+            }
+        }
+        if (sketches) {
+            analytics = *sketches;
+        }
+        if (!breakdown) {
+            breakdown = std::make_shared<const json>(analyticsBreakdown(changed));
+            std::lock_guard<std::mutex> analyticsLock(analyticsMutex_);
+            if (!breakdown_ || breakdownVersion_ < version) {
+                breakdown_ = breakdown;
+                breakdownVersion_ = version;
+            }
+        }
+        
+        double totalRevenue = revenueCents / 100.0;
+        
+        analytics["totalBookings"] = totalBookings;
+        analytics["totalRevenue"] = totalRevenue;
+        analytics["approximate"] = approximate;
+        if (!approximate) {
+            analytics["uniqueUsers"] = static_cast<int>(uniqueUsers);
+        }
+        for (const auto& [key, value] : breakdown->items()) {
+            analytics[key] = value;
+        }
+        
+        // Calculate average booking value
+        if (totalBookings > 0) {
+            analytics["averageBookingValue"] = totalRevenue / totalBookings;
+        } else {
+            analytics["averageBookingValue"] = 0.0;
+        }
+        
+        // Cancellation rate
+        if (totalBookings + cancelledBookings > 0) {
+            analytics["cancellationRate"] = static_cast<double>(cancelledBookings) / 
+                                          (totalBookings + cancelledBookings);
+        } else {
+            analytics["cancellationRate"] = 0.0;
+        }
+        
+        return analytics;
+    }
+    
+    // Ad-hoc report over the whole booking history grouped by "movie", "cinema",
+    // "screenType", "showtime", "user" or "day" (booking date). Bookings are
+    // aggregated in parallel into thread-local partials that are then merged.
+    json bookingReport(const std::string& groupBy) const {
+        struct Row {
+            long long bookings = 0;
+            long long cancellations = 0;
+            long long tickets = 0;
+            long long revenueCents = 0;
+            long long cancelledRevenueCents = 0;
+            long long capacity = 0;
+        };
+        using Rows = std::unordered_map<std::string, Row>;
+        
+        std::function<std::string(const Booking&)> bookingKey;
+        std::function<std::string(const Showtime&)> showtimeKey;
+        if (groupBy == "movie") {
+            bookingKey = [](const Booking& b) { return std::to_string(b.getMovieId()); };
+            showtimeKey = [](const Showtime& s) { return std::to_string(s.getMovieId()); };
+        } else if (groupBy == "cinema") {
+            bookingKey = [](const Booking& b) { return std::to_string(b.getCinemaId()); };
+            showtimeKey = [](const Showtime& s) { return std::to_string(s.getCinemaId()); };
+        } else if (groupBy == "screenType") {
+            bookingKey = [](const Booking& b) { return b.getScreenType(); };
+            showtimeKey = [](const Showtime& s) { return s.getScreenType(); };
+        } else if (groupBy == "showtime") {
+            bookingKey = [](const Booking& b) { return b.getShowtimeId(); };
+            showtimeKey = [](const Showtime& s) { return s.getId(); };
+        } else if (groupBy == "user") {
+            bookingKey = [](const Booking& b) { return b.getUserId(); };
+        } else if (groupBy == "day") {
+            bookingKey = [](const Booking& b) { return b.getBookingDate(); };
+        } else {
+            throw std::runtime_error("Unknown groupBy: " + groupBy);
+        }
+        
+        Rows rows;
+        {
+            EngineLock lock(mutex_);
+            rows = parallel_reduce<Rows>(bookings_.size(),
+                [&](Rows& partial, size_t i) {
+                    const Booking& booking = bookings_[i];
+                    Row& row = partial[bookingKey(booking)];
+                    long long cents = AnalyticsAggregates::toCents(booking.getTotalPrice());
+                    if (booking.isCancelled()) {
+                        row.cancellations++;
+                        row.cancelledRevenueCents += cents;
+                    } else {
+                        row.bookings++;
+                        row.tickets += static_cast<long long>(booking.getSeats().size());
+                        row.revenueCents += cents;
+                    }
+                },
+                [](Rows& into, const Rows& from) {
+                    for (const auto& [key, row] : from) {
+                        Row& target = into[key];
+                        target.bookings += row.bookings;
+                        target.cancellations += row.cancellations;
+                        target.tickets += row.tickets;
+                        target.revenueCents += row.revenueCents;
+                        target.cancelledRevenueCents += row.cancelledRevenueCents;
+                    }
+                });
+            
+            // Offered seats per group, for occupancy
+            if (showtimeKey) {
+                for (const auto& cinema : cinemas_) {
+                    for (const auto& showtime : cinema.getShowtimes()) {
+                        auto it = rows.find(showtimeKey(showtime));
+                        if (it != rows.end()) {
+                            it->second.capacity += showtimeCapacity(showtime);
+                        }
+                    }
+                }
+            }
+        }
+        
+        json report = json::object();
+        for (const auto& [key, row] : rows) {
+            json item;
+            item["bookings"] = row.bookings;
+            item["cancellations"] = row.cancellations;
+            item["tickets"] = row.tickets;
+            item["revenue"] = row.revenueCents / 100.0;
+            item["cancelledRevenue"] = row.cancelledRevenueCents / 100.0;
+            item["cancellationRate"] = row.bookings + row.cancellations > 0 ?
+                static_cast<double>(row.cancellations) / (row.bookings + row.cancellations) : 0.0;
+            if (showtimeKey) {
+                item["capacity"] = row.capacity;
+                item["occupancy"] = row.capacity > 0 ? static_cast<double>(row.tickets) / row.capacity : 0.0;
+            }
+            report[key] = item;
+        }
+        return report;
+    }
+    
+    // Revenue, tickets, cancellations and occupancy between two dates ("YYYY-MM-DD"
+    // or "YYYY-MM-DD HH:MM", inclusive; empty means unbounded), grouped by
+    // "total", "movie", "cinema" or "screenType" at hour/day/week granularity.
+    // Buckets that overlap the range are counted whole.
+    json analyticsRange(const std::string& from, const std::string& to,
+                            const std::string& groupBy, const std::string& granularity) const {
+        static const std::unordered_map<std::string, RollupEngine::Dimension> dimensions = {
+            {"total", RollupEngine::Total}, {"movie", RollupEngine::ByMovie},
+            {"cinema", RollupEngine::ByCinema}, {"screenType", RollupEngine::ByScreenType}
+        };
+        static const std::unordered_map<std::string, RollupEngine::Granularity> granularities = {
+            {"hour", RollupEngine::Hourly}, {"day", RollupEngine::Daily}, {"week", RollupEngine::Weekly}
+        };
+        auto dimension = dimensions.find(groupBy);
+        if (dimension == dimensions.end()) {
+            throw std::runtime_error("Unknown groupBy: " + groupBy);
+        }
+        auto bucketSize = granularities.find(granularity);
+        if (bucketSize == granularities.end()) {
+            throw std::runtime_error("Unknown granularity: " + granularity);
+        }
+        
+        long long fromHour = rangeBoundHour(from, false);
+        long long toHour = rangeBoundHour(to, true);
+        
+        RollupEngine::Groups totals;
+        RollupEngine::Groups undated;
+        std::vector<std::pair<long long, RollupEngine::Groups>> series;
+        {
+            std::lock_guard<std::mutex> analyticsLock(analyticsMutex_);
+            totals = rollups_.query(fromHour, toHour, bucketSize->second, dimension->second, &series);
+            undated = rollups_.undated(dimension->second);
+        }
+        
+        auto toJson = [](const RollupEngine::Groups& groups) {
+            json result = json::object();
+            for (const auto& [key, metrics] : groups) {
+                json item;
+                item["revenue"] = metrics.revenueCents / 100.0;
+                item["tickets"] = metrics.tickets;
+                item["bookings"] = metrics.bookings;
+                item["cancellations"] = metrics.cancellations;
+                item["capacity"] = metrics.capacity;
+                item["occupancy"] = metrics.capacity > 0 ?
+                    static_cast<double>(metrics.tickets) / metrics.capacity : 0.0;
+                result[key] = item;
+            }
+            return result;
+        };
+        
+        json buckets = json::array();
+        for (const auto& [startHour, groups] : series) {
+            json bucket;
+            char hour[8];
+            std::snprintf(hour, sizeof(hour), " %02lld:00", ((startHour % 24) + 24) % 24);
+            long long day = (startHour - ((startHour % 24) + 24) % 24) / 24;
+            bucket["start"] = civil_from_days(day) + hour;
+            bucket["groups"] = toJson(groups);
+            buckets.push_back(bucket);
+        }
+        
+        json result = json::object();
+        result["groupBy"] = groupBy;
+        result["granularity"] = granularity;
+        result["totals"] = toJson(totals);
+        result["buckets"] = buckets;
+        result["undated"] = toJson(undated);  // Not in any range; see RollupEngine::undated
+        return result;
+    }
+    
+    // Data persistence
+    void saveData() const {
+        EngineLock lock(mutex_);
+        
+        // Check if this is being called during shutdown
+        static bool is_shutdown_in_progress = false;
+        if (is_shutdown_in_progress) {
+            ENGINE_LOG(LogLevel::Warn, "Data saving during shutdown is disabled. No data will be saved.");
+            return;
+        }
+
+        // For manual saves during application runtime
+        try {
+            saveBookings("bookings");
+            ENGINE_LOG(LogLevel::Info, "Saved bookings", {{"count", bookings_.size()}});
+            
+            saveMovies("movies");
+            ENGINE_LOG(LogLevel::Info, "Saved movies", {{"count", movies_.size()}});
+            
+            saveCinemas("cinemas");
+            ENGINE_LOG(LogLevel::Info, "Saved cinemas", {{"count", cinemas_.size()}});
+        } catch (const std::exception& e) {
+            ENGINE_LOG(LogLevel::Error, "Error in saveData", {{"error", e.what()}});
+        }
+    }
+
+    // Mark shutdown in progress to prevent data saving during termination
+    void markShutdownInProgress() {
+        static bool is_shutdown_in_progress = true;
+        ENGINE_LOG(LogLevel::Info, "Shutdown in progress. Data saving is disabled.");
+    }
+
+private:
+    std::vector<Movie> movies_;
+    std::vector<Cinema> cinemas_;
+    std::vector<Booking> bookings_;
+    std::unordered_map<std::string, size_t> bookingIndex_;  // Booking ID -> position in bookings_
+    
+    // Optimized data structures for O(1) lookups
+    std::unordered_map<int, Movie> movieMap_;
+    std::unordered_map<int, Cinema> cinemaMap_;
+    std::unordered_map<std::string, Showtime> showtimeMap_;
+    
+    // BST for sorted movie access
+    MovieNode* movieTreeRoot_ = nullptr;
+    
+    // Seat state per showtime, built from bookings_ on first use and kept current
+    mutable std::unordered_map<std::string, ShowtimeSeats> seatState_;
+    // Showtime IDs referenced by bookings_, including showtimes no longer scheduled
+    std::unordered_set<std::string> bookedShowtimes_;
+    
+    // Seat holds, expired by a timer wheel ticking every kHoldTickMs
+    static constexpr double kHoldTickMs = 100.0;
+    static constexpr double kMaxHoldSeconds = 30.0 * 60.0;
+    std::unordered_map<std::string, SeatHold> holds_;
+    PricingEngine pricing_;
+    // Key -> booking ID. Its own mutex lets a retry be answered before it is
+    // admitted or takes mutex_; taken after mutex_ when both are held.
+    std::mutex idempotencyMutex_;
+    IdempotencyTable<std::string> idempotentBookings_;
+    AdmissionController admission_;
+    
+    // Lock-free seat claims per showtime (the ShowtimeSeats' claims), readable
+    // without mutex_; updated under mutex_ then claimsMutex_
+    mutable std::shared_mutex claimsMutex_;
+    mutable std::unordered_map<std::string, std::shared_ptr<SeatClaims>> claimsIndex_;
+    mutable std::unordered_map<std::string, std::shared_ptr<const SeatMapStamp>> stampIndex_;  // Same scheme
+    std::atomic<bool> sharedInventory_{false};  // Set once shared_ is attached
+    std::atomic<uint64_t> optimisticClaims_{0};
+    std::atomic<uint64_t> claimConflicts_{0};
+    std::atomic<uint64_t> claimRejections_{0};
+    std::atomic<uint64_t> lockedFallbacks_{0};
+    
+    // Where bookings are persisted; empty means backend/data
+    std::filesystem::path dataDir_;
+    // Serialises writes to bookings.json. savedBookings_ is the bookings_
+    // size at the last full save: bookings before it are already on disk.
+    mutable std::mutex bookingsFileMutex_;
+    mutable size_t savedBookings_ = 0;
+    
+    // Cross-process seat inventory, when enabled, and this process's journal read position
+    std::unique_ptr<SharedSeatInventory> shared_;
+    uint64_t journalCursor_ = 0;
+    
+    // Seat change subscribers; an empty showtimeId receives every showtime.
+    // Callbacks are shared so that subscribersMutex_ only ever guards pointer
+    // copies: copying or destroying a Python callback needs the GIL, and
+    // publishChanges runs with the GIL released.
+    struct SeatSubscriber {
+        std::string showtimeId;
+        std::shared_ptr<const std::function<void(const SeatChange&)>> callback;
+    };
+    std::mutex subscribersMutex_;
+    std::map<int, SeatSubscriber> seatSubscribers_;
+    int nextSubscriberId_ = 1;
+    std::atomic<bool> hasSeatSubscribers_{false};
+    std::vector<SeatChange> pendingChanges_;  // guarded by mutex_
+    TimerWheel<std::string> holdWheel_;
+    std::chrono::steady_clock::time_point holdClockStart_ = std::chrono::steady_clock::now();
+    
+    // Running analytics, guarded by analyticsMutex_ (always taken after mutex_)
+    AnalyticsAggregates analytics_;
+    AnalyticsSketches sketches_;
+    RollupEngine rollups_;
+    MovieRanking ranking_;
+    std::unordered_map<std::string, double> bookingEventTimes_;  // Set when created/restored live
+    uint64_t analyticsVersion_ = 0;  // Bumped by every change to analytics_
+    bool sketchAnalytics_ = false;   // Written holding mutex_ and analyticsMutex_
+    mutable std::shared_ptr<const json> breakdown_;  // Published getAnalytics breakdown
+    mutable uint64_t breakdownVersion_ = 0;          // analyticsVersion_ breakdown_ was built at
+    mutable std::shared_ptr<const json> sketchSnapshot_;  // addSketchAnalytics output, same scheme
+    mutable uint64_t sketchSnapshotVersion_ = 0;
+    
+    mutable EngineMetrics metrics_;     // Declared first: mutex_ records into it
+    mutable TimedMutex mutex_{metrics_};
+    mutable std::mutex analyticsMutex_;
+    
+    // BST operations
+    void insertMovieToTree(MovieNode*& root, const Movie& movie) {
+        if (root == nullptr) {
+            root = new MovieNode(movie);
+            return;
+        }
+        
+        if (movie.getTitle() < root->movie.getTitle()) {
+            insertMovieToTree(root->left, movie);
+        } else {
+            insertMovieToTree(root->right, movie);
+        }
+    }
+    
+    void clearMovieTree(MovieNode* root) {
+        if (root == nullptr) return;
+        
+        clearMovieTree(root->left);
+        clearMovieTree(root->right);
+        delete root;
+    }
+    
+    void inOrderTraversal(MovieNode* root, std::vector<Movie>& result) const {
+        if (root == nullptr) return;
+        
+        inOrderTraversal(root->left, result);
+        result.push_back(root->movie);
+        inOrderTraversal(root->right, result);
+    }
+    
+    // Helper methods
+    
+    // Revenue by day, movie popularity and screen type popularity of getAnalytics
+    static json analyticsBreakdown(const AnalyticsAggregates& aggregates) {
+        json breakdown = json::object();
+        
+        // Convert daily revenue to a JSON object
+        json revenueByDay = json::object();
+        for (const auto& [day, entry] : aggregates.dailyRevenue) {
+            revenueByDay[day] = entry.second / 100.0;
+        }
+        breakdown["revenueByDay"] = revenueByDay;
+        
+        // Convert movie popularity to a JSON object
+        json popularMovies = json::object();
+        for (const auto& [movieId, count] : aggregates.movieBookings) {
+            popularMovies[std::to_string(movieId)] = count;
+        }
+        breakdown["moviePopularity"] = popularMovies;
+        
+        // Convert screen type popularity to a JSON object
+        json screenTypePopularity = json::object();
+        for (const auto& [screenType, count] : aggregates.screenTypeBookings) {
+            screenTypePopularity[screenType] = count;
+        }
+        breakdown["screenTypePopularity"] = screenTypePopularity;
+        return breakdown;
+    }
+    
+    void updateShowtimeSeats(const std::string& showtimeId, const std::vector<std::string>& seats, bool isBooking) {
+        ShowtimeSeats& state = seatsFor(showtimeId);
+        for (const auto& seat : seats) {
+            if (isBooking) {
+                state.booked.insert(seat);
+            } else {
+                state.booked.erase(seat);
+            }
+            state.sync(seat);
+        }
+        recordSeatChange(state, isBooking ? SeatChange::Kind::Booked : SeatChange::Kind::Unbooked, seats);
+        
+        ENGINE_LOG(LogLevel::Debug, isBooking ? "Booked seats" : "Unbooked seats",
+                   {{"showtimeId", showtimeId}, {"seats", seats}});
+    }
+    
+    // Fill the sketch-based fields of getAnalytics (caller holds analyticsMutex_)
+    void addSketchAnalytics(json& analytics) const {
+        static constexpr size_t kTopCount = 10;
+        
+        analytics["uniqueUsers"] = std::llround(sketches_.users.estimate());
+        
+        json usersByDay = json::object();
+        for (const auto& [day, sketch] : sketches_.usersByDay) {
+            usersByDay[day] = std::llround(sketch.estimate());
+        }
+        analytics["uniqueUsersByDay"] = usersByDay;
+        
+        json usersByMovie = json::object();
+        for (const auto& [movieId, sketch] : sketches_.usersByMovie) {
+            usersByMovie[std::to_string(movieId)] = std::llround(sketch.estimate());
+        }
+        analytics["uniqueUsersByMovie"] = usersByMovie;
+        
+        json usersByCinema = json::object();
+        for (const auto& [cinemaId, sketch] : sketches_.usersByCinema) {
+            usersByCinema[std::to_string(cinemaId)] = std::llround(sketch.estimate());
+        }
+        analytics["uniqueUsersByCinema"] = usersByCinema;
+        
+        // Space-Saving and Count-Min both overestimate, so report the tighter of the two
+        json topMovies = json::array();
+        for (const auto& entry : sketches_.topMovies.top(kTopCount)) {
+            json item;
+            item["movieId"] = entry.key;
+            item["bookings"] = std::min(entry.count, sketches_.movieCounts.estimate(hash64(entry.key)));
+            item["maxError"] = entry.error;
+            topMovies.push_back(item);
+        }
+        analytics["topMovies"] = topMovies;
+        
+        json topUsers = json::array();
+        for (const auto& entry : sketches_.topUsers.top(kTopCount)) {
+            json item;
+            item["userId"] = entry.key;
+            item["bookings"] = std::min(entry.count, sketches_.userCounts.estimate(hash64(entry.key)));
+            item["maxError"] = entry.error;
+            topUsers.push_back(item);
+        }
+        analytics["topUsers"] = topUsers;
+    }
+    
+    // Apply a booking state change to the running analytics: sign is +1 when
+    // the booking becomes active and -1 when it is cancelled. countsCancellation
+    // also moves it in or out of the cancelled total (cancel/restore).
+    void recordAnalytics(const Booking& booking, int sign, bool countsCancellation) {
+        std::lock_guard<std::mutex> analyticsLock(analyticsMutex_);
+        analyticsVersion_++;
+        analytics_.apply(booking, sign, !sketchAnalytics_);
+        sketches_.apply(booking, sign);
+        rollups_.recordBooking(booking, sign);
+        ranking_.add(booking.getMovieId(), sign);
+        if (sign > 0) {
+            bookingEventTimes_[booking.getId()] = now_seconds();
+        }
+        ranking_.addTrending(booking.getMovieId(), bookingEventTime(booking), sign);
+        if (countsCancellation) {
+            analytics_.cancelledBookings -= sign;
+            rollups_.recordCancellation(booking, -sign);
+        }
+    }
+    
+    // Recompute the running analytics from bookings_ (used after loading),
+    // folding chunks of bookings in parallel and merging the partial results
+    void rebuildAnalytics() {
+        struct Partial {
+            AnalyticsAggregates aggregates;
+            AnalyticsSketches sketches;
+            RollupEngine rollups;
+        };
+        
+        bool perUser = !sketchAnalytics_;  // Read under mutex_
+        Partial total = parallel_reduce<Partial>(bookings_.size(),
+            [this, perUser](Partial& partial, size_t i) {
+                const Booking& booking = bookings_[i];
+                if (booking.isCancelled()) {
+                    partial.aggregates.cancelledBookings++;
+                    partial.rollups.recordCancellation(booking, +1);
+                } else {
+                    partial.aggregates.apply(booking, +1, perUser);
+                    partial.sketches.apply(booking, +1);
+                    partial.rollups.recordBooking(booking, +1);
+                }
+            },
+            [](Partial& into, const Partial& from) {
+                into.aggregates.merge(from.aggregates);
+                into.sketches.merge(from.sketches);
+                into.rollups.merge(from.rollups);
+            });
+        
+        std::lock_guard<std::mutex> analyticsLock(analyticsMutex_);
+        analyticsVersion_++;
+        analytics_ = std::move(total.aggregates);
+        sketches_ = std::move(total.sketches);
+        rollups_.clearBookings();
+        rollups_.merge(total.rollups);
+        
+        ranking_.clear();
+        bookingEventTimes_.clear();
+        for (const auto& booking : bookings_) {
+            if (!booking.isCancelled()) {
+                ranking_.add(booking.getMovieId(), +1);
+                ranking_.addTrending(booking.getMovieId(), bookingEventTime(booking), +1);
+            }
+        }
+    }
+    
+    // When a booking became active: live bookings carry their exact time,
+    // loaded ones fall back to midnight of the booking date (analyticsMutex_ held)
+    double bookingEventTime(const Booking& booking) const {
+        auto it = bookingEventTimes_.find(booking.getId());
+        if (it != bookingEventTimes_.end()) {
+            return it->second;
+        }
+        long long days = 0;
+        return parse_date(booking.getBookingDate(), days) ? days * 86400.0 : 0.0;
+    }
+    
+    // Convert an analyticsRange bound to an hour index; a bare date covers the whole day
+    static long long rangeBoundHour(const std::string& bound, bool upper) {
+        static constexpr long long kUnbounded = 1LL << 40;
+        if (bound.empty()) {
+            return upper ? kUnbounded : -kUnbounded;
+        }
+        std::string date = bound.substr(0, 10);
+        std::string time = bound.size() > 11 ? bound.substr(11) : "";
+        long long hour = RollupEngine::toHour(date, time);
+        if (hour < 0) {
+            throw std::runtime_error("Invalid date: " + bound);
+        }
+        if (time.empty() && upper) {
+            hour += 23;
+        }
+        return hour;
+    }
+    
+    // Seats offered by one showtime, from its screen layout; used for occupancy rollups
+    static long long showtimeCapacity(const Showtime& showtime) {
+        const auto& layout = showtime.getLayout();
+        return layout ? layout->capacity() : SeatLayout::standard()->capacity();
+    }
+    
+    std::vector<std::string> getBookedSeatsForShowtimeInternal(const std::string& showtimeId) const {
+        const ShowtimeSeats& state = seatsFor(showtimeId);
+        std::vector<std::string> bookedSeats(state.booked.begin(), state.booked.end());
+        std::sort(bookedSeats.begin(), bookedSeats.end());
+        return bookedSeats;
+    }
+    
+    // Pack seat labels into a base64 bitset over the layout grid
+    template <typename It>
+    static std::string encodeSeatBits(const SeatLayout& layout, It first, It last) {
+        std::vector<uint8_t> bytes((static_cast<size_t>(layout.rows()) * layout.seatsPerRow() + 7) / 8, 0);
+        for (; first != last; ++first) {
+            int row, column;
+            if (layout.locate(*first, row, column)) {
+                size_t bit = static_cast<size_t>(row) * layout.seatsPerRow() + column;
+                bytes[bit >> 3] |= uint8_t(1) << (bit & 7);
+            }
+        }
+        return base64_encode(bytes);
+    }
+    
+    // Seats under a hold that has not yet expired, sorted
+    std::vector<std::string> heldSeats(const ShowtimeSeats& state) const {
+        uint64_t now = currentHoldTick();
+        std::vector<std::string> held;
+        for (const auto& [seat, token] : state.held) {
+            auto hold = holds_.find(token);
+            if (hold != holds_.end() && hold->second.expiresTick > now) {
+                held.push_back(seat);
+            }
+        }
+        std::vector<std::string> foreign = foreignHeldSeats(state);
+        held.insert(held.end(), foreign.begin(), foreign.end());
+        std::sort(held.begin(), held.end());
+        return held;
+    }
+    
+    // Seat bits in the shared inventory, laid out like the showtime's SeatBitmap
+    static std::vector<size_t> sharedSeatBits(const ShowtimeSeats& state, const std::vector<std::string>& seats) {
+        std::vector<size_t> bits;
+        for (const auto& seat : seats) {
+            int row, column;
+            if (state.layout->locate(seat, row, column)) {
+                bits.push_back(static_cast<size_t>(row) * state.taken.wordsPerRow() * 64 + column);
+            }
+        }
+        return bits;
+    }
+    
+    // Claim seats in the shared inventory, except those this process already
+    // holds (their bits are set). Throws if another process has any of them;
+    // returns the seats claimed.
+    std::vector<std::string> claimShared(const ShowtimeSeats& state, const std::vector<std::string>& seats) {
+        std::vector<std::string> claimed;
+        if (!shared_) {
+            return claimed;
+        }
+        for (const auto& seat : seats) {
+            if (!state.held.count(seat)) {
+                claimed.push_back(seat);
+            }
+        }
+        if (!claimed.empty() && !shared_->claim(state.showtimeId, sharedSeatBits(state, claimed))) {
+            throw std::runtime_error("Seats are taken by another server process");
+        }
+        return claimed;
+    }
+    
+    void releaseShared(const ShowtimeSeats& state, const std::vector<std::string>& seats) {
+        if (shared_ && !seats.empty()) {
+            shared_->release(state.showtimeId, sharedSeatBits(state, seats));
+        }
+    }
+    
+    // Publish a booking change for the other processes; the seats are already
+    // claimed, so a failure here only delays when they see it
+    void journalShared(SharedSeatInventory::EntryKind kind, const std::string& payload) {
+        if (!shared_) {
+            return;
+        }
+        try {
+            shared_->append(kind, payload);
+        } catch (const std::exception& e) {
+            ENGINE_LOG(LogLevel::Warn, "Booking change not journaled", {{"error", e.what()}});
+        }
+    }
+    
+    // Apply booking changes other processes journaled since the last call (mutex_ held)
+    void syncSharedJournal() {
+        if (!shared_) {
+            return;
+        }
+        std::vector<SharedSeatInventory::Record> records;
+        if (!shared_->readSince(journalCursor_, records)) {
+            ENGINE_LOG(LogLevel::Warn, "Shared seat journal overran, some changes from other processes were missed");
+        }
+        int self = SharedSeatInventory::processId();
+        for (const auto& record : records) {
+            if (record.pid == self) {
+                continue;
+            }
+            try {
+                applySharedRecord(record);
+            } catch (const std::exception& e) {
+                ENGINE_LOG(LogLevel::Warn, "Could not apply shared journal entry", {{"error", e.what()}});
+            }
+        }
+    }
+    
+    // Replay one journal entry; entries already reflected locally are ignored.
+    // A batch is parsed whole before any of its bookings is applied.
+    void applySharedRecord(const SharedSeatInventory::Record& record) {
+        if (record.kind == SharedSeatInventory::EntryKind::Booked ||
+            record.kind == SharedSeatInventory::EntryKind::Batch) {
+            json payload = json::parse(record.payload);
+            std::vector<Booking> bookings;
+            if (record.kind == SharedSeatInventory::EntryKind::Batch) {
+                for (const auto& booking_json : payload) {
+                    bookings.push_back(Booking::from_json(booking_json));
+                }
+            } else {
+                bookings.push_back(Booking::from_json(payload));
+            }
+            for (const auto& booking : bookings) {
+                if (findBooking(booking.getId())) {
+                    continue;
+                }
+                addBooking(booking);
+                updateShowtimeSeats(booking.getShowtimeId(), booking.getSeats(), true);
+                recordAnalytics(booking, +1, false);
+            }
+            return;
+        }
+        
+        Booking* it = findBooking(record.payload);
+        if (!it) {
+            return;
+        }
+        if (record.kind == SharedSeatInventory::EntryKind::Cancelled && !it->isCancelled()) {
+            recordAnalytics(*it, -1, true);
+            it->cancel();
+            updateShowtimeSeats(it->getShowtimeId(), it->getSeats(), false);
+        } else if (record.kind == SharedSeatInventory::EntryKind::Restored && it->isCancelled()) {
+            it->restore();
+            recordAnalytics(*it, +1, true);
+            updateShowtimeSeats(it->getShowtimeId(), it->getSeats(), true);
+        }
+    }
+    
+    // Seats taken in the shared inventory by another process that this process
+    // has not seen booked: that process's holds (or a booking not yet replayed)
+    std::vector<std::string> foreignHeldSeats(const ShowtimeSeats& state) const {
+        std::vector<std::string> seats;
+        if (!shared_) {
+            return seats;
+        }
+        std::vector<uint64_t> words = shared_->snapshot(state.showtimeId);
+        const SeatBitmap& taken = state.taken;
+        for (int r = 0; r < taken.rows(); r++) {
+            for (int w = 0; w < taken.wordsPerRow(); w++) {
+                size_t index = static_cast<size_t>(r) * taken.wordsPerRow() + w;
+                if (index >= words.size()) {
+                    return seats;
+                }
+                uint64_t bits = words[index] & ~taken.row(r)[w] & taken.validMask(w);
+                while (bits) {
+                    seats.push_back(seat_label(r, w * 64 + countTrailingZeros64(bits)));
+                    bits &= bits - 1;
+                }
+            }
+        }
+        return seats;
+    }
+    
+    // Seat state for a showtime, computed from bookings_ the first time it is
+    // needed. An ID that is neither scheduled nor referenced by a booking is
+    // rejected before anything is allocated for it.
+    ShowtimeSeats& seatsFor(const std::string& showtimeId) const {
+        auto it = seatState_.find(showtimeId);
+        if (it != seatState_.end()) {
+            return it->second;
+        }
+        
+        auto showtime = showtimeMap_.find(showtimeId);
+        if (showtime == showtimeMap_.end() && !bookedShowtimes_.count(showtimeId)) {
+            throw std::runtime_error("Showtime " + showtimeId + " not found");
+        }
+        std::shared_ptr<const SeatLayout> layout =
+            showtime != showtimeMap_.end() && showtime->second.getLayout() ? showtime->second.getLayout()
+                                                                           : SeatLayout::standard();
+        ShowtimeSeats& state = seatState_.emplace(showtimeId, ShowtimeSeats(showtimeId, layout)).first->second;
+        for (const auto& booking : bookings_) {
+            if (booking.getShowtimeId() == showtimeId && !booking.isCancelled()) {
+                state.booked.insert(booking.getSeats().begin(), booking.getSeats().end());
+            }
+        }
+        for (const auto& seat : state.booked) {
+            state.sync(seat);
+        }
+        state.stamp->version.store(state.version, std::memory_order_release);
+        std::unique_lock<std::shared_mutex> claimsLock(claimsMutex_);
+        claimsIndex_[showtimeId] = state.claims;
+        stampIndex_[showtimeId] = state.stamp;
+        return state;
+    }
+    
+    // Throw unless every seat is unbooked and not held by a different user
+    void checkSeatsFree(const ShowtimeSeats& state, const std::vector<std::string>& seats,
+                        const std::string& userId) const {
+        std::unordered_set<std::string> requested;
+        for (const auto& seat : seats) {
+            int row, column;
+            if (!state.layout->locate(seat, row, column)) {
+                throw std::runtime_error("Seat " + seat + " does not exist on this screen");
+            }
+            if (!requested.insert(seat).second) {
+                throw std::runtime_error("Seat " + seat + " is requested twice");
+            }
+            if (state.booked.count(seat)) {
+                throw std::runtime_error("Seat " + seat + " is already booked");
+            }
+            auto held = state.held.find(seat);
+            if (held != state.held.end() && holds_.at(held->second).userId != userId) {
+                throw std::runtime_error("Seat " + seat + " is held by another user");
+            }
+        }
+    }
+    
+    // Booking for a createBooking request; seats are checked later under the lock
+    Booking makeBooking(const BookingRequest& request) const {
+        if (request.userId.empty() || request.showtimeId.empty() || !request.totalPrice) {
+            throw std::runtime_error("Missing required booking data fields");
+        }
+        
+        return Booking(
+            generate_uuid(),
+            request.userId,
+            request.movieId,
+            request.movieTitle,
+            request.moviePoster,
+            request.showtimeId,
+            request.showtimeDate,
+            request.showtimeTime,
+            request.cinemaId,
+            request.cinemaName,
+            request.screenType,
+            request.seats,
+            *request.totalPrice,
+            get_current_date(),
+            false
+        );
+    }
+    
+    // Claim the booking's seats on the showtime's seat words, before taking the
+    // engine lock. Seats the user holds are already claimed by the hold and
+    // are skipped. Throws if another buyer has a seat. Returns false when the
+    // request must go through the locked path unclaimed: the showtime's seat
+    // state is not built yet, a seat label is invalid, or a conflict is not
+    // certain without the lock - a hold may have lapsed but not been released
+    // yet, another process may have freed the seat, or a keyed request may be
+    // racing its own retry.
+    bool claimSeatsOptimistically(const Booking& booking, bool keyed, std::shared_ptr<SeatClaims>& claims,
+                                  std::vector<size_t>& claimed) {
+        std::shared_ptr<const SeatMapStamp> stamp;
+        {
+            std::shared_lock<std::shared_mutex> claimsLock(claimsMutex_);
+            auto it = claimsIndex_.find(booking.getShowtimeId());
+            if (it == claimsIndex_.end()) {
+                return false;
+            }
+            claims = it->second;
+            stamp = stampIndex_.at(booking.getShowtimeId());
+        }
+        std::vector<size_t> bits;
+        if (!claims->bitsFor(booking.getSeats(), bits)) {
+            claims.reset();
+            return false;
+        }
+        uint64_t userHash = hash64(booking.getUserId());
+        bits.erase(std::remove_if(bits.begin(), bits.end(),
+                                  [&claims, userHash](size_t bit) { return claims->holder(bit) == userHash; }),
+                   bits.end());
+        if (claims->claim(bits)) {
+            claimed = std::move(bits);
+            return true;
+        }
+        claims.reset();
+        claimConflicts_.fetch_add(1, std::memory_order_relaxed);
+        if (keyed || sharedInventory_.load(std::memory_order_acquire) ||
+            currentHoldTick() >= stamp->holdExpiryTick.load(std::memory_order_acquire)) {
+            return false;
+        }
+        claimRejections_.fetch_add(1, std::memory_order_relaxed);
+        throw std::runtime_error("Seats are no longer available");
+    }
+    
+    // Undo an optimistic claim after the booking failed (mutex_ held). Seats
+    // that are booked or held in the meantime keep their bits.
+    void releaseClaims(const std::string& showtimeId, const std::shared_ptr<SeatClaims>& claims,
+                       const std::vector<size_t>& bits) {
+        if (!claims || bits.empty()) {
+            return;
+        }
+        claims->release(bits);
+        ShowtimeSeats& state = seatsFor(showtimeId);
+        if (state.claims != claims) {
+            return;
+        }
+        for (size_t bit : bits) {
+            size_t rowBits = static_cast<size_t>(state.taken.wordsPerRow()) * 64;
+            int row = static_cast<int>(bit / rowBits);
+            int column = static_cast<int>(bit % rowBits);
+            if (state.taken.test(row, column)) {
+                claims->set(bit, true);
+            }
+        }
+    }
+    
+    // A committed booking waiting to be written: its position in bookings_
+    // and its bookings.json record
+    struct BookingWrite {
+        size_t position = 0;
+        json record;
+    };
+    
+    // Validate and store a new booking in memory (mutex_ held); returns what
+    // appendBooking writes to disk
+    BookingWrite commitBooking(Booking& booking) {
+        {
+            TraceSpan span("conflictCheck");
+            validateBooking(booking);
+            claimShared(seatsFor(booking.getShowtimeId()), booking.getSeats());
+        }
+        TraceSpan span("applyBooking");
+        applyBooking(booking);
+        journalShared(SharedSeatInventory::EntryKind::Booked, booking.to_json().dump());
+        return {bookingIndex_.at(booking.getId()), bookingRecord(booking)};
+    }
+    
+    // Check seats and price without changing any state. Seats the same user
+    // holds are allowed; seats held by anyone else are a conflict.
+    void validateBooking(Booking& booking) const {
+        const ShowtimeSeats& state = seatsFor(booking.getShowtimeId());
+        checkSeatsFree(state, booking.getSeats(), booking.getUserId());
+        verifyPrice(booking, state);
+    }
+    
+    // Append a booking to bookings_ and index its ID (mutex_ held)
+    void addBooking(const Booking& booking) {
+        bookingIndex_[booking.getId()] = bookings_.size();
+        bookings_.push_back(booking);
+        bookedShowtimes_.insert(booking.getShowtimeId());
+    }
+    
+    // The booking with this ID, or nullptr (mutex_ held)
+    Booking* findBooking(const std::string& id) {
+        auto it = bookingIndex_.find(id);
+        return it == bookingIndex_.end() ? nullptr : &bookings_[it->second];
+    }
+    
+    const Booking* findBooking(const std::string& id) const {
+        auto it = bookingIndex_.find(id);
+        return it == bookingIndex_.end() ? nullptr : &bookings_[it->second];
+    }
+    
+    // ID of the booking an earlier request with this key created, if any.
+    // Throws if the key was used for a different request.
+    std::optional<std::string> idempotentBookingId(const std::string& key, uint64_t fingerprint) {
+        std::lock_guard<std::mutex> lock(idempotencyMutex_);
+        const std::string* id = idempotentBookings_.find(key, fingerprint, steady_seconds());
+        return id ? std::optional<std::string>(*id) : std::nullopt;
+    }
+    
+    // The current record of a keyed request's booking, so a retry after a
+    // cancel sees the cancellation (mutex_ held)
+    Booking idempotentBooking(const std::string& key, const std::string& bookingId) const {
+        ENGINE_LOG(LogLevel::Debug, "Returning booking for repeated idempotency key",
+                   {{"bookingId", bookingId}, {"idempotencyKey", key}});
+        const Booking* original = findBooking(bookingId);
+        if (!original) {
+            throw std::runtime_error("Booking " + bookingId + " for idempotency key " + key + " no longer exists");
+        }
+        return *original;
+    }
+    
+    // Record a validated booking in memory; the caller persists and journals
+    void applyBooking(const Booking& booking) {
+        ShowtimeSeats& state = seatsFor(booking.getShowtimeId());
+        for (const auto& seat : booking.getSeats()) {
+            releaseHeldSeat(state, seat);
+        }
+        
+        // Add to bookings
+        addBooking(booking);
+        
+        // Update showtime seats in memory
+        updateShowtimeSeats(booking.getShowtimeId(), booking.getSeats(), true);
+        
+        // Update running analytics
+        recordAnalytics(booking, +1, false);
+        
+        // Log successful booking creation
+        ENGINE_LOG(LogLevel::Info, "Created booking",
+                   {{"bookingId", booking.getId()}, {"userId", booking.getUserId()}, {"movieId", booking.getMovieId()},
+                    {"showtimeId", booking.getShowtimeId()}, {"seats", booking.getSeats().size()}});
+    }
+    
+    // Identifies what a keyed booking request asked for, to catch key reuse
+    static uint64_t requestFingerprint(const Booking& booking) {
+        uint64_t fingerprint = mix64(hash64(booking.getUserId()) ^ hash64(booking.getShowtimeId()) * 31);
+        for (const auto& seat : booking.getSeats()) {
+            fingerprint = mix64(fingerprint ^ hash64(seat));
+        }
+        return mix64(fingerprint ^ static_cast<uint64_t>(AnalyticsAggregates::toCents(booking.getTotalPrice())));
+    }
+    
+    // Share of the layout's seats already booked or held
+    static double occupancy(const ShowtimeSeats& state) {
+        int capacity = state.layout->capacity();
+        return capacity > 0 ? 1.0 - static_cast<double>(state.available()) / capacity : 0.0;
+    }
+    
+    // Reject a client total that differs from the server quote by more than a
+    // cent, and store the quoted amount
+    void verifyPrice(Booking& booking, const ShowtimeSeats& state) const {
+        auto showtime = showtimeMap_.find(booking.getShowtimeId());
+        if (showtime == showtimeMap_.end()) {
+            ENGINE_LOG(LogLevel::Warn, "Showtime not found, booking total not verified",
+                       {{"showtimeId", booking.getShowtimeId()}});
+            return;
+        }
+        PricingEngine::Quote quote = pricing_.quote(showtime->second, *state.layout, occupancy(state), booking.getSeats());
+        long long clientCents = AnalyticsAggregates::toCents(booking.getTotalPrice());
+        if (std::llabs(clientCents - quote.totalCents) > 1) {
+            std::ostringstream message;
+            message << std::fixed << std::setprecision(2) << "Total price " << booking.getTotalPrice()
+                    << " does not match quoted price " << quote.totalCents / 100.0;
+            throw std::runtime_error(message.str());
+        }
+        booking.setTotalPrice(quote.totalCents / 100.0);
+    }
+    
+    // Create a hold (mutex_ held, expired holds already released)
+    std::string placeHold(const std::string& showtimeId, const std::vector<std::string>& seats,
+                          const std::string& userId, double ttlSeconds) {
+        double ttl = std::min(std::max(ttlSeconds, 1.0), kMaxHoldSeconds);
+        ShowtimeSeats& state = seatsFor(showtimeId);
+        checkSeatsFree(state, seats, userId);
+        claimShared(state, seats);
+        
+        SeatHold hold;
+        hold.token = generate_uuid();
+        hold.showtimeId = showtimeId;
+        hold.userId = userId;
+        hold.expiresTick = currentHoldTick() + static_cast<uint64_t>(std::ceil(ttl * 1000.0 / kHoldTickMs));
+        
+        // Seats this user already holds elsewhere move into the new hold
+        for (const auto& seat : seats) {
+            releaseHeldSeat(state, seat);
+            state.hold(seat, hold.token, hash64(userId));
+        }
+        hold.seats = seats;
+        hold.timer = holdWheel_.schedule(hold.expiresTick, hold.token);
+        std::string token = hold.token;
+        holds_.emplace(token, std::move(hold));
+        recordSeatChange(state, SeatChange::Kind::Held, seats);  // After emplace: the stamp reads its expiry
+        
+        ENGINE_LOG(LogLevel::Debug, "Held seats",
+                   {{"showtimeId", showtimeId}, {"userId", userId}, {"seats", seats.size()}, {"ttlSeconds", ttl}});
+        return token;
+    }
+    
+    // Scan each row's run-start mask for blocks of `count` free seats and keep the
+    // one closest to the sweet spot. Rows are visited nearest-first so the scan
+    // stops as soon as the row penalty alone exceeds the best score.
+    static bool findBestBlock(const SeatBitmap& taken, int count, const SeatPreferences& prefs, SeatBlock& best) {
+        if (count < 1 || count > taken.seatsPerRow()) {
+            return false;
+        }
+        int sweetRow = prefs.sweetSpotRow >= 0 ? prefs.sweetSpotRow : (taken.rows() * 2) / 3;
+        double centerColumn = (taken.seatsPerRow() - 1) / 2.0;
+        double idealStart = centerColumn - (count - 1) / 2.0;
+        
+        std::vector<int> rows = prefs.allowedRows;
+        if (rows.empty()) {
+            for (int r = 0; r < taken.rows(); r++) rows.push_back(r);
+        }
+        std::sort(rows.begin(), rows.end(), [sweetRow](int a, int b) {
+            return std::abs(a - sweetRow) < std::abs(b - sweetRow) ||
+                   (std::abs(a - sweetRow) == std::abs(b - sweetRow) && a > b);
+        });
+        
+        bool found = false;
+        std::vector<uint64_t> starts;
+        for (int r : rows) {
+            if (r < 0 || r >= taken.rows()) continue;
+            double rowPenalty = prefs.rowWeight * std::abs(r - sweetRow);
+            if (found && rowPenalty >= best.score) break;
+            
+            taken.runStarts(r, count, starts);
+            for (int w = 0; w < taken.wordsPerRow(); w++) {
+                uint64_t bits = starts[w];
+                while (bits) {
+                    int column = w * 64 + countTrailingZeros64(bits);
+                    bits &= bits - 1;
+                    double score = rowPenalty + std::abs(column - idealStart);
+                    if (!found || score < best.score) {
+                        found = true;
+                        best.row = r;
+                        best.firstColumn = column;
+                        best.score = score;
+                    }
+                }
+            }
+        }
+        
+        if (found) {
+            best.seats.clear();
+            for (int c = best.firstColumn; c < best.firstColumn + count; c++) {
+                best.seats.push_back(seat_label(best.row, c));
+            }
+        }
+        return found;
+    }
+    
+    uint64_t currentHoldTick() const {
+        auto elapsed = std::chrono::steady_clock::now() - holdClockStart_;
+        return static_cast<uint64_t>(std::chrono::duration<double, std::milli>(elapsed).count() / kHoldTickMs);
+    }
+    
+    // Release every hold whose TTL has passed (mutex_ held)
+    void expireHolds() {
+        holdWheel_.advance(currentHoldTick(), [this](const std::string& token) {
+            auto it = holds_.find(token);
+            if (it != holds_.end()) {
+                ENGINE_LOG(LogLevel::Debug, "Hold expired", {{"token", token}});
+                dropHold(it);
+            }
+        });
+    }
+    
+    // Remove a hold and free its remaining seats (its timer must already be gone)
+    void dropHold(std::unordered_map<std::string, SeatHold>::iterator it) {
+        ShowtimeSeats& state = seatsFor(it->second.showtimeId);
+        std::vector<std::string> released;
+        for (const auto& seat : it->second.seats) {
+            auto held = state.held.find(seat);
+            if (held != state.held.end() && held->second == it->first) {
+                state.held.erase(held);
+                state.sync(seat);
+                released.push_back(seat);
+            }
+        }
+        holds_.erase(it);
+        if (!released.empty()) {
+            releaseShared(state, released);
+            recordSeatChange(state, SeatChange::Kind::Released, released);
+        } else {
+            publishStamp(state);  // Its expiry no longer bounds the stamp
+        }
+    }
+    
+    // Append a delta to the showtime's change log and queue it for subscribers
+    void recordSeatChange(ShowtimeSeats& state, SeatChange::Kind kind, const std::vector<std::string>& seats) {
+        SeatChange change;
+        change.showtimeId = state.showtimeId;
+        change.version = ++state.version;
+        publishStamp(state);
+        change.kind = kind;
+        change.seats = seats;
+        if (hasSeatSubscribers_.load(std::memory_order_relaxed)) {
+            pendingChanges_.push_back(change);
+        }
+        state.changes.push(std::move(change));
+    }
+    
+    // Publish the state's version and earliest hold expiry for notModifiedSeatMap.
+    // The expiry tick is taken before the version so a reader that sees the
+    // new version also sees the holds that came with it.
+    void publishStamp(ShowtimeSeats& state) {
+        uint64_t expiry = std::numeric_limits<uint64_t>::max();
+        for (const auto& [seat, token] : state.held) {
+            auto hold = holds_.find(token);
+            if (hold != holds_.end()) {
+                expiry = std::min(expiry, hold->second.expiresTick);
+            }
+        }
+        state.stamp->holdExpiryTick.store(expiry, std::memory_order_release);
+        state.stamp->version.store(state.version, std::memory_order_release);
+    }
+    
+    // Hand queued changes to subscribers; called with mutex_ released so a
+    // callback may call back into the engine
+    void publishChanges() {
+        std::vector<SeatChange> changes;
+        {
+            EngineLock lock(mutex_);
+            changes.swap(pendingChanges_);
+        }
+        if (changes.empty()) {
+            return;
+        }
+        
+        std::vector<SeatSubscriber> subscribers;
+        {
+            std::lock_guard<std::mutex> lock(subscribersMutex_);
+            for (const auto& [id, subscriber] : seatSubscribers_) {
+                subscribers.push_back(subscriber);
+            }
+        }
+        for (const auto& change : changes) {
+            for (const auto& subscriber : subscribers) {
+                if (!subscriber.showtimeId.empty() && subscriber.showtimeId != change.showtimeId) continue;
+                try {
+                    (*subscriber.callback)(change);
+                } catch (const std::exception& e) {
+                    ENGINE_LOG(LogLevel::Error, "Error in seat change subscriber", {{"error", e.what()}});
+                }
+            }
+        }
+    }
+    
+    // Publishes queued seat changes when the enclosing call returns. Declared
+    // before the engine lock so it runs after the lock is released.
+    class ChangeDispatch {
+    public:
+        explicit ChangeDispatch(Impl& system) : system_(system) {}
+        ~ChangeDispatch() { system_.publishChanges(); }
+        
+    private:
+        Impl& system_;
+    };
+    
+    // Take one seat out of whichever hold has it; empty holds are dropped
+    void releaseHeldSeat(ShowtimeSeats& state, const std::string& seat) {
+        auto held = state.held.find(seat);
+        if (held == state.held.end()) {
+            return;
+        }
+        auto hold = holds_.find(held->second);
+        state.held.erase(held);
+        state.sync(seat);
+        if (hold == holds_.end()) {
+            return;
+        }
+        auto& seats = hold->second.seats;
+        seats.erase(std::remove(seats.begin(), seats.end(), seat), seats.end());
+        if (seats.empty()) {
+            holdWheel_.cancel(hold->second.timer);
+            holds_.erase(hold);
+        }
+    }
+    
+    // Directory holding bookings.json and the saved catalogue: the configured
+    // one, else backend/data found by walking up from the working directory
+    std::filesystem::path dataDirectory() const {
+        if (!dataDir_.empty()) {
+            return dataDir_;
+        }
+        std::filesystem::path basePath = std::filesystem::canonical(std::filesystem::current_path());
+        while (basePath.filename() != "backend" && basePath.has_parent_path() &&
+               basePath != basePath.parent_path()) {
+            basePath = basePath.parent_path(); // Traverse up to find the "backend" directory
+        }
+        if (basePath.filename() != "backend") {
+            throw std::runtime_error("Error: Could not locate the backend directory.");
+        }
+        return basePath / "data";
+    }
+    
+    void loadBookings(const std::string& filename) {
+        PersistTimer persistTimer(metrics_, PersistOp::LoadBookings);
+        bookings_.clear();
+        bookingIndex_.clear();
+        bookedShowtimes_.clear();
+        
+        try {
+            std::filesystem::path fullPath = dataDirectory() / (filename + ".json");
+            
+            std::ifstream file(fullPath);
+            if (!file.is_open()) {
+                ENGINE_LOG(LogLevel::Error, "Could not open file", {{"file", fullPath.string()}});
+                return;
+            }
+            
+            json data;
+            try {
+                file >> data;
+            } catch (const json::parse_error& e) {
+                ENGINE_LOG(LogLevel::Error, "Error parsing JSON", {{"file", fullPath.string()}, {"error", e.what()}});
+                return;
+            }
+            
+            // Process the bookings
+            if (data.is_array()) {
+                for (const auto& booking_json : data) {
+                    try {
+                        Booking booking = Booking::from_json(booking_json);
+                        addBooking(booking);
+
+                        // Restore associated movie details
+                        if (booking_json.contains("movieDetails")) {
+                            const auto& movie_json = booking_json["movieDetails"];
+                            int movieId = movie_json["id"].get<int>();
+                            auto it = std::find_if(movies_.begin(), movies_.end(),
+                                                   [movieId](const Movie& m) { return m.getId() == movieId; });
+                            if (it == movies_.end()) {
+                                movies_.push_back(Movie::from_json(movie_json));
+                            }
+                        }
+                    } catch (const std::exception& e) {
+                        ENGINE_LOG(LogLevel::Error, "Error parsing booking", {{"error", e.what()}});
+                    }
+                }
+            }
+            
+            ENGINE_LOG(LogLevel::Info, "Loaded bookings", {{"count", bookings_.size()}, {"file", fullPath.string()}});
+        } catch (const std::exception& e) {
+            ENGINE_LOG(LogLevel::Error, "Error loading bookings", {{"file", filename}, {"error", e.what()}});
+        }
+    }
+    
+    // A booking as stored in bookings.json, with its movie's details
+    json bookingRecord(const Booking& booking) const {
+        json booking_json = booking.to_json();
+        auto it = std::find_if(movies_.begin(), movies_.end(),
+                               [&booking](const Movie& m) { return m.getId() == booking.getMovieId(); });
+        if (it != movies_.end()) {
+            booking_json["movieDetails"] = {
+                {"id", it->getId()},
+                {"title", it->getTitle()},
+                {"poster", it->getPoster()},
+                {"banner", it->getBanner()},
+                {"description", it->getDescription()},
+                {"rating", it->getRating()},
+                {"duration", it->getDuration()},
+                {"releaseDate", it->getReleaseDate()},
+                {"genres", it->getGenres()},
+                {"language", it->getLanguage()},
+                {"director", it->getDirector()},
+                {"cast", it->getCast()}
+            };
+        }
+        return booking_json;
+    }
+    
+    void saveBookings(const std::string& filename) const {
+        PersistTimer persistTimer(metrics_, PersistOp::SaveBookings);
+        TraceSpan saveSpan("saveBookings");
+        try {
+            std::filesystem::path dataDir = dataDirectory();
+            std::filesystem::path fullPath = dataDir / (filename + ".json");
+    
+            // Ensure the data directory exists
+            if (!std::filesystem::exists(dataDir)) {
+                std::filesystem::create_directories(dataDir);
+            }
+    
+            // Convert bookings to JSON
+            std::optional<TraceSpan> phase;
+            phase.emplace("saveBookings.build");
+            json bookings_json = json::array();
+            for (const auto& booking : bookings_) {
+                bookings_json.push_back(bookingRecord(booking));
+            }
+            
+            phase.reset();
+            phase.emplace("saveBookings.serialize");
+            std::string text = bookings_json.dump(4); // Formatted JSON
+            
+            // Write JSON to file with explicit open mode
+            phase.reset();
+            phase.emplace("saveBookings.write");
+            std::lock_guard<std::mutex> fileLock(bookingsFileMutex_);
+            std::ofstream file(fullPath, std::ios::out | std::ios::trunc);
+            if (!file.is_open()) {
+                throw std::runtime_error("Could not open file " + fullPath.string() + " for writing");
+            }
+            file.write(text.data(), static_cast<std::streamsize>(text.size()));
+            file.close();
+            savedBookings_ = bookings_.size();
+            phase.reset();
+
+            ENGINE_LOG(LogLevel::Debug, "Saved bookings", {{"count", bookings_.size()}, {"file", fullPath.string()}});
+        } catch (const std::exception& e) {
+            ENGINE_LOG(LogLevel::Error, "Error saving bookings", {{"file", filename}, {"error", e.what()}});
+        }
+    }
+    
+    // Add one new booking to bookings.json in place: the closing bracket is
+    // overwritten with the record and a new bracket, as dump(4) would lay
+    // them out. Runs without mutex_, so bookings on one showtime do not wait
+    // for each other's disk writes; bookingsFileMutex_ orders it against full
+    // saves, and a booking a full save already wrote is skipped. Returns
+    // false if the file is not a JSON array this can extend, for the caller
+    // to fall back to saveBookings.
+    bool appendBooking(const BookingWrite& write) const {
+        PersistTimer persistTimer(metrics_, PersistOp::SaveBookings);
+        TraceSpan span("appendBooking");
+        try {
+            // The record indented as an element of the top-level array
+            std::string entry = json::array({write.record}).dump(4);
+            entry = entry.substr(2, entry.size() - 4);
+            
+            std::filesystem::path fullPath = dataDirectory() / "bookings.json";
+            std::lock_guard<std::mutex> fileLock(bookingsFileMutex_);
+            if (write.position < savedBookings_) {
+                return true;
+            }
+            std::fstream file(fullPath, std::ios::in | std::ios::out | std::ios::binary);
+            if (!file.is_open()) {
+                return false;
+            }
+            
+            // Offset of the last non-space character before `end`, or -1
+            char c = 0;
+            auto lastNonSpace = [&file, &c](std::streamoff end) -> std::streamoff {
+                while (end > 0) {
+                    file.seekg(--end);
+                    if (!file.get(c)) return -1;
+                    if (!std::isspace(static_cast<unsigned char>(c))) return end;
+                }
+                return -1;
+            };
+            file.seekg(0, std::ios::end);
+            std::streamoff close = lastNonSpace(file.tellg());
+            if (close < 0 || c != ']') {
+                return false;
+            }
+            std::streamoff last = lastNonSpace(close);
+            if (last < 0) {
+                return false;
+            }
+            std::string text = (c == '[' ? "\n" : ",\n") + entry + "\n]";
+            file.seekp(last + 1);
+            file.write(text.data(), static_cast<std::streamsize>(text.size()));
+            file.flush();
+            if (!file) {
+                return false;
+            }
+            
+            ENGINE_LOG(LogLevel::Debug, "Appended booking", {{"bookingId", write.record["id"]}, {"file", fullPath.string()}});
+            return true;
+        } catch (const std::exception& e) {
+            ENGINE_LOG(LogLevel::Warn, "Could not append booking", {{"error", e.what()}});
+            return false;
+        }
+    }
+};
+
+// BookingSystem facade - forwards to the implementation
+BookingSystem::BookingSystem(const std::string& dataDir) : impl_(std::make_unique<Impl>(dataDir)) {}
+BookingSystem::~BookingSystem() = default;
+
+void BookingSystem::loadMovies(const std::string& filename) {
+    OpTimer timer(impl_->metrics(), EngineOp::LoadMovies);
+    impl_->loadMovies(filename);
+}
+std::vector<Movie> BookingSystem::getAllMovies() const {
+    OpTimer timer(impl_->metrics(), EngineOp::GetAllMovies);
+    return impl_->getAllMovies();
+}
+std::vector<Movie> BookingSystem::getSortedMovies() const {
+    OpTimer timer(impl_->metrics(), EngineOp::GetSortedMovies);
+    return impl_->getSortedMovies();
+}
+std::vector<Movie> BookingSystem::getPopularMovies(int count) const {
+    OpTimer timer(impl_->metrics(), EngineOp::GetPopularMovies);
+    return impl_->getPopularMovies(count);
+}
+std::vector<Movie> BookingSystem::getTrendingMovies(int count) const {
+    OpTimer timer(impl_->metrics(), EngineOp::GetTrendingMovies);
+    return impl_->getTrendingMovies(count);
+}
+void BookingSystem::setTrendingHalfLife(double hours) {
+    OpTimer timer(impl_->metrics(), EngineOp::SetTrendingHalfLife);
+    impl_->setTrendingHalfLife(hours);
+}
+Movie BookingSystem::getMovieById(int id) const {
+    OpTimer timer(impl_->metrics(), EngineOp::GetMovieById);
+    return impl_->getMovieById(id);
+}
+bool BookingSystem::addMovie(const Movie& movie) {
+    OpTimer timer(impl_->metrics(), EngineOp::AddMovie);
+    return impl_->addMovie(movie);
+}
+bool BookingSystem::saveMovies(const std::string& filename) const {
+    OpTimer timer(impl_->metrics(), EngineOp::SaveMovies);
+    return impl_->saveMovies(filename);
+}
+
+void BookingSystem::loadCinemas(const std::string& filename) {
+    OpTimer timer(impl_->metrics(), EngineOp::LoadCinemas);
+    impl_->loadCinemas(filename);
+}
+std::vector<Cinema> BookingSystem::getAllCinemas() const {
+    OpTimer timer(impl_->metrics(), EngineOp::GetAllCinemas);
+    return impl_->getAllCinemas();
+}
+Cinema BookingSystem::getCinemaById(int id) const {
+    OpTimer timer(impl_->metrics(), EngineOp::GetCinemaById);
+    return impl_->getCinemaById(id);
+}
+bool BookingSystem::addCinema(const Cinema& cinema) {
+    OpTimer timer(impl_->metrics(), EngineOp::AddCinema);
+    return impl_->addCinema(cinema);
+}
+bool BookingSystem::saveCinemas(const std::string& filename) const {
+    OpTimer timer(impl_->metrics(), EngineOp::SaveCinemas);
+    return impl_->saveCinemas(filename);
+}
+bool BookingSystem::addShowtime(const Showtime& showtime) {
+    OpTimer timer(impl_->metrics(), EngineOp::AddShowtime);
+    return impl_->addShowtime(showtime);
+}
+Showtime BookingSystem::getShowtimeById(const std::string& id) const {
+    OpTimer timer(impl_->metrics(), EngineOp::GetShowtimeById);
+    return impl_->getShowtimeById(id);
+}
+std::vector<Showtime> BookingSystem::getShowtimesByMovie(int movieId) const {
+    OpTimer timer(impl_->metrics(), EngineOp::GetShowtimesByMovie);
+    return impl_->getShowtimesByMovie(movieId);
+}
+std::vector<Showtime> BookingSystem::getShowtimesByDate(const std::string& date) const {
+    OpTimer timer(impl_->metrics(), EngineOp::GetShowtimesByDate);
+    return impl_->getShowtimesByDate(date);
+}
+std::vector<Showtime> BookingSystem::getShowtimesByMovieAndDate(int movieId, const std::string& date) const {
+    OpTimer timer(impl_->metrics(), EngineOp::GetShowtimesByMovieAndDate);
+    return impl_->getShowtimesByMovieAndDate(movieId, date);
+}
+
+std::vector<std::string> BookingSystem::getBookedSeatsForShowtime(const std::string& showtimeId) {
+    OpTimer timer(impl_->metrics(), EngineOp::GetBookedSeatsForShowtime);
+    return impl_->getBookedSeatsForShowtime(showtimeId);
+}
+json BookingSystem::getSeatAvailability(const std::string& showtimeId) {
+    OpTimer timer(impl_->metrics(), EngineOp::GetSeatAvailability);
+    return impl_->getSeatAvailability(showtimeId);
+}
+json BookingSystem::getSeatLayout(const std::string& showtimeId) const {
+    OpTimer timer(impl_->metrics(), EngineOp::GetSeatLayout);
+    return impl_->getSeatLayout(showtimeId);
+}
+json BookingSystem::getSeatMap(const std::string& showtimeId, const std::string& etag, const std::string& format) {
+    OpTimer timer(impl_->metrics(), EngineOp::GetSeatMap);
+    return impl_->getSeatMap(showtimeId, etag, format);
+}
+json BookingSystem::seatChangesSince(const std::string& showtimeId, uint64_t sinceVersion) {
+    OpTimer timer(impl_->metrics(), EngineOp::SeatChangesSince);
+    return impl_->seatChangesSince(showtimeId, sinceVersion);
+}
+int BookingSystem::subscribeSeatChanges(const std::function<void(const SeatChange&)>& callback,
+                                        const std::string& showtimeId) {
+    OpTimer timer(impl_->metrics(), EngineOp::SubscribeSeatChanges);
+    return impl_->subscribeSeatChanges(callback, showtimeId);
+}
+bool BookingSystem::unsubscribeSeatChanges(int id) {
+    OpTimer timer(impl_->metrics(), EngineOp::UnsubscribeSeatChanges);
+    return impl_->unsubscribeSeatChanges(id);
+}
+
+json BookingSystem::quote(const std::string& showtimeId, const std::vector<std::string>& seats) const {
+    OpTimer timer(impl_->metrics(), EngineOp::Quote);
+    return impl_->quote(showtimeId, seats);
+}
+void BookingSystem::setPricingRules(const PricingRules& rules) {
+    OpTimer timer(impl_->metrics(), EngineOp::SetPricingRules);
+    impl_->setPricingRules(rules);
+}
+PricingRules BookingSystem::getPricingRules() const {
+    OpTimer timer(impl_->metrics(), EngineOp::GetPricingRules);
+    return impl_->getPricingRules();
+}
+
+std::string BookingSystem::holdSeats(const std::string& showtimeId, const std::vector<std::string>& seats,
+                                     const std::string& userId, double ttlSeconds) {
+    OpTimer timer(impl_->metrics(), EngineOp::HoldSeats);
+    return impl_->holdSeats(showtimeId, seats, userId, ttlSeconds);
+}
+Booking BookingSystem::confirmHold(const std::string& token, const BookingRequest& request) {
+    OpTimer timer(impl_->metrics(), EngineOp::ConfirmHold);
+    return impl_->confirmHold(token, request);
+}
+bool BookingSystem::releaseHold(const std::string& token) {
+    OpTimer timer(impl_->metrics(), EngineOp::ReleaseHold);
+    return impl_->releaseHold(token);
+}
+json BookingSystem::findBestSeats(const std::string& showtimeId, int count, const SeatPreferences& preferences) {
+    OpTimer timer(impl_->metrics(), EngineOp::FindBestSeats);
+    return impl_->findBestSeats(showtimeId, count, preferences);
+}
+Booking BookingSystem::createBooking(const BookingRequest& request) {
+    OpTimer timer(impl_->metrics(), EngineOp::CreateBooking);
+    return impl_->createBooking(request);
+}
+std::vector<Booking> BookingSystem::createBookings(const std::vector<BookingRequest>& requests) {
+    OpTimer timer(impl_->metrics(), EngineOp::CreateBookings);
+    return impl_->createBookings(requests);
+}
+Booking BookingSystem::getBookingById(const std::string& id) const {
+    OpTimer timer(impl_->metrics(), EngineOp::GetBookingById);
+    return impl_->getBookingById(id);
+}
+bool BookingSystem::cancelBooking(const std::string& id) {
+    OpTimer timer(impl_->metrics(), EngineOp::CancelBooking);
+    return impl_->cancelBooking(id);
+}
+bool BookingSystem::restoreBooking(const std::string& id) {
+    OpTimer timer(impl_->metrics(), EngineOp::RestoreBooking);
+    return impl_->restoreBooking(id);
+}
+std::vector<Booking> BookingSystem::getBookingsByUser(const std::string& userId) const {
+    OpTimer timer(impl_->metrics(), EngineOp::GetBookingsByUser);
+    return impl_->getBookingsByUser(userId);
+}
+std::vector<Booking> BookingSystem::getAllBookings() const {
+    OpTimer timer(impl_->metrics(), EngineOp::GetAllBookings);
+    return impl_->getAllBookings();
+}
+
+json BookingSystem::enterWaitingRoom(const std::string& showtimeId, const std::string& userId) {
+    OpTimer timer(impl_->metrics(), EngineOp::EnterWaitingRoom);
+    return impl_->enterWaitingRoom(showtimeId, userId);
+}
+int BookingSystem::getQueuePosition(const std::string& showtimeId, uint64_t ticket) {
+    OpTimer timer(impl_->metrics(), EngineOp::GetQueuePosition);
+    return impl_->getQueuePosition(showtimeId, ticket);
+}
+void BookingSystem::configureAdmission(const AdmissionConfig& config) {
+    OpTimer timer(impl_->metrics(), EngineOp::ConfigureAdmission);
+    impl_->configureAdmission(config);
+}
+AdmissionConfig BookingSystem::getAdmissionConfig() const {
+    OpTimer timer(impl_->metrics(), EngineOp::GetAdmissionConfig);
+    return impl_->getAdmissionConfig();
+}
+json BookingSystem::getAdmissionStats() const {
+    OpTimer timer(impl_->metrics(), EngineOp::GetAdmissionStats);
+    return impl_->getAdmissionStats();
+}
+json BookingSystem::getSeatClaimStats() const {
+    OpTimer timer(impl_->metrics(), EngineOp::GetSeatClaimStats);
+    return impl_->getSeatClaimStats();
+}
+void BookingSystem::enableSharedInventory(const std::string& name, bool reset) {
+    OpTimer timer(impl_->metrics(), EngineOp::EnableSharedInventory);
+    impl_->enableSharedInventory(name, reset);
+}
+
+json BookingSystem::getAnalytics(bool approximate) const {
+    OpTimer timer(impl_->metrics(), EngineOp::GetAnalytics);
+    return impl_->getAnalytics(approximate);
+}
+void BookingSystem::setSketchAnalytics(bool enabled) {
+    OpTimer timer(impl_->metrics(), EngineOp::SetSketchAnalytics);
+    impl_->setSketchAnalytics(enabled);
+}
+bool BookingSystem::sketchAnalyticsEnabled() const { return impl_->sketchAnalyticsEnabled(); }
+json BookingSystem::bookingReport(const std::string& groupBy) const {
+    OpTimer timer(impl_->metrics(), EngineOp::BookingReport);
+    return impl_->bookingReport(groupBy);
+}
+json BookingSystem::analyticsRange(const std::string& from, const std::string& to,
+                                   const std::string& groupBy, const std::string& granularity) const {
+    OpTimer timer(impl_->metrics(), EngineOp::AnalyticsRange);
+    return impl_->analyticsRange(from, to, groupBy, granularity);
+}
+
+void BookingSystem::saveData() const {
+    OpTimer timer(impl_->metrics(), EngineOp::SaveData);
+    impl_->saveData();
+}
+void BookingSystem::markShutdownInProgress() {
+    OpTimer timer(impl_->metrics(), EngineOp::MarkShutdownInProgress);
+    impl_->markShutdownInProgress();
+}
+
+json BookingSystem::getMetrics() const { return impl_->metrics().snapshot(); }
+std::string BookingSystem::prometheusMetrics() const { return impl_->metrics().prometheus(); }
+void BookingSystem::resetMetrics() { impl_->metrics().reset(); }
+
+void BookingSystem::setLockProfiling(bool enabled) { impl_->setLockProfiling(enabled); }
+json BookingSystem::lockContentionReport() const { return impl_->lockContentionReport(); }
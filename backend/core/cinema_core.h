@@ -0,0 +1,1216 @@
+// CineVerse booking engine core. Movies, cinemas, showtimes, seat inventory,
+// bookings and analytics behind a plain C++ API: requests are typed structs,
+// replies are model objects or JSON documents. The Python module
+// (cinema_engine.cpp) is a thin pybind11 wrapper over this library, and
+// benchmarks or C++ services link it directly.
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <sstream>
+#include <memory>
+#include <map>
+#include <functional>
+#include <cstdint>
+#include <array>
+#include <bitset>
+#include <optional>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+// Helpers shared by the model classes and the engine
+std::string generate_uuid();
+std::string get_current_date();
+double now_seconds();
+std::string trim(const std::string& str);
+bool parse_seat_label(const std::string& label, int& row, int& column);
+std::string seat_label(int row, int column);
+long long days_from_civil(int y, unsigned m, unsigned d);
+std::string civil_from_days(long long z);
+bool parse_date(const std::string& date, long long& days);
+
+// Engine logging. Lines are a message plus JSON fields, queued on a lock-free
+// ring and written by a background thread (info and debug to stdout, warn and
+// error to stderr) as text or JSON lines. Lines below the level are never
+// formatted; flushLog() waits until everything logged so far is written.
+enum class LogLevel { Debug, Info, Warn, Error, Off };
+enum class LogFormat { Text, Json };
+void setLogLevel(LogLevel level);
+LogLevel getLogLevel();
+void setLogFormat(LogFormat format);
+bool logEnabled(LogLevel level);
+void logEvent(LogLevel level, const std::string& message, const json& fields = json::object());
+void flushLog();
+bool parse_log_level(const std::string& name, LogLevel& level);
+
+// Engine tracing. Each request on a thread is one trace of nested spans:
+// beginTrace()/endTrace() bracket a request with the caller's request ID, and
+// a public BookingSystem call made outside one starts its own. Finished traces
+// are kept in a ring of the most recent `capacity`, queryable as JSON or as
+// Chrome trace-event JSON (chrome://tracing, Perfetto). Off by default.
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name);   // `name` must outlive the trace, e.g. a literal
+    ~TraceSpan();
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+    
+private:
+    int index_ = -1;
+    bool root_ = false;
+    uint64_t generation_ = 0;  // Trace the span belongs to
+};
+void setTracing(bool enabled, size_t capacity = 256);
+bool tracingEnabled();
+void beginTrace(const std::string& requestId, const std::string& name);
+void endTrace();
+json recentTraces(size_t limit = 50, double minDurationMs = 0.0);
+json findTrace(const std::string& requestId);
+json chromeTrace(const std::string& requestId = "");
+void clearTraces();
+
+// Movie class
+class Movie {
+public:
+    Movie() = default;
+    
+    Movie(int id, std::string title, std::string poster, std::string banner, 
+          std::string description, double rating, std::string duration,
+          std::string releaseDate, std::string genres, std::string language,
+          std::string director, std::string cast) 
+        : id_(id), title_(std::move(title)), poster_(std::move(poster)), 
+          banner_(std::move(banner)), description_(std::move(description)),
+          rating_(rating), duration_(std::move(duration)), 
+          releaseDate_(std::move(releaseDate)), genres_(std::move(genres)),
+          language_(std::move(language)), director_(std::move(director)),
+          cast_(std::move(cast)) {}
+          
+    // Getters
+    int getId() const { return id_; }
+    std::string getTitle() const { return title_; }
+    std::string getPoster() const { return poster_; }
+    std::string getBanner() const { return banner_; }
+    std::string getDescription() const { return description_; }
+    double getRating() const { return rating_; }
+    std::string getDuration() const { return duration_; }
+    std::string getReleaseDate() const { return releaseDate_; }
+    std::string getGenres() const { return genres_; }
+    std::string getLanguage() const { return language_; }
+    std::string getDirector() const { return director_; }
+    std::string getCast() const { return cast_; }
+    
+    // Convert to JSON (genres and cast as lists)
+    json to_json() const {
+        json movie_dict;
+        movie_dict["id"] = id_;
+        movie_dict["title"] = title_;
+        movie_dict["poster"] = poster_;
+        movie_dict["banner"] = banner_;
+        movie_dict["description"] = description_;
+        movie_dict["rating"] = rating_;
+        movie_dict["duration"] = duration_;
+        movie_dict["releaseDate"] = releaseDate_;
+        
+        // Parse genres into a list
+        json genres_list = json::array();
+        std::istringstream genres_stream(genres_);
+        std::string genre;
+        while (std::getline(genres_stream, genre, ',')) {
+            std::string trimmed_genre = trim(genre);
+            if (!trimmed_genre.empty()) {
+                genres_list.push_back(trimmed_genre);
+            }
+        }
+        movie_dict["genres"] = genres_list;
+        
+        movie_dict["language"] = language_;
+        movie_dict["director"] = director_;
+        
+        // Parse cast into a list
+        json cast_list = json::array();
+        std::istringstream cast_stream(cast_);
+        std::string actor;
+        while (std::getline(cast_stream, actor, ',')) {
+            std::string trimmed_actor = trim(actor);
+            if (!trimmed_actor.empty()) {
+                cast_list.push_back(trimmed_actor);
+            }
+        }
+        movie_dict["cast"] = cast_list;
+        
+        return movie_dict;
+    }
+    
+    // Create from JSON
+    static Movie from_json(const json& j) {
+        if (!j.contains("id") || !j.contains("title")) {
+            throw std::runtime_error("Invalid movie JSON - missing required fields");
+        }
+        
+        // Extract genres from list and join them
+        std::string genres;
+        if (j.contains("genres") && !j["genres"].is_null() && j["genres"].is_array()) {
+            bool first = true;
+            for (const auto& genre : j["genres"]) {
+                if (!first) genres += ", ";
+                genres += genre.get<std::string>();
+                first = false;
+            }
+        }
+        
+        // Extract cast from list and join them
+        std::string cast;
+        if (j.contains("cast") && !j["cast"].is_null() && j["cast"].is_array()) {
+            bool first = true;
+            for (const auto& actor : j["cast"]) {
+                if (!first) cast += ", ";
+                cast += actor.get<std::string>();
+                first = false;
+            }
+        }
+        
+        return Movie(
+            j["id"].get<int>(),
+            j["title"].get<std::string>(),
+            j.contains("poster") && !j["poster"].is_null() ? j["poster"].get<std::string>() : "",
+            j.contains("banner") && !j["banner"].is_null() ? j["banner"].get<std::string>() : "",
+            j.contains("description") && !j["description"].is_null() ? j["description"].get<std::string>() : "",
+            j.contains("rating") && !j["rating"].is_null() ? j["rating"].get<double>() : 0.0,
+            j.contains("duration") && !j["duration"].is_null() ? j["duration"].get<std::string>() : "",
+            j.contains("releaseDate") && !j["releaseDate"].is_null() ? j["releaseDate"].get<std::string>() : "",
+            genres,
+            j.contains("language") && !j["language"].is_null() ? j["language"].get<std::string>() : "",
+            j.contains("director") && !j["director"].is_null() ? j["director"].get<std::string>() : "",
+            cast
+        );
+    }
+
+private:
+    int id_ = 0;
+    std::string title_;
+    std::string poster_;
+    std::string banner_;
+    std::string description_;
+    double rating_ = 0.0;
+    std::string duration_;
+    std::string releaseDate_;
+    std::string genres_;
+    std::string language_;
+    std::string director_;
+    std::string cast_;
+};
+
+// Custom linked list node for seat management
+struct SeatNode {
+    std::string seatId;
+    bool isBooked;
+    SeatNode* next;
+    
+    SeatNode(const std::string& id) : seatId(id), isBooked(false), next(nullptr) {}
+};
+
+// Seat manager using linked list for efficient updates
+class SeatManager {
+public:
+    SeatManager() : head(nullptr), size_(0) {}
+
+    // Showtimes are copied and moved around in vectors, so the list is owned:
+    // copies are deep and moves hand the nodes over
+    SeatManager(const SeatManager& other) : head(nullptr), size_(0) {
+        copyFrom(other);
+    }
+
+    SeatManager(SeatManager&& other) noexcept : head(other.head), size_(other.size_) {
+        other.head = nullptr;
+        other.size_ = 0;
+    }
+
+    SeatManager& operator=(const SeatManager& other) {
+        if (this != &other) {
+            clear();
+            copyFrom(other);
+        }
+        return *this;
+    }
+
+    SeatManager& operator=(SeatManager&& other) noexcept {
+        if (this != &other) {
+            clear();
+            head = other.head;
+            size_ = other.size_;
+            other.head = nullptr;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    ~SeatManager() {
+        clear();
+    }
+    
+    void addSeat(const std::string& seatId) {
+        if (head == nullptr) {
+            head = new SeatNode(seatId);
+            size_++;
+            return;
+        }
+        
+        // Check if seat already exists
+        SeatNode* current = head;
+        while (current->next != nullptr) {
+            if (current->seatId == seatId) return;
+            current = current->next;
+        }
+        if (current->seatId == seatId) return;
+        
+        current->next = new SeatNode(seatId);
+        size_++;
+    }
+    
+    bool bookSeat(const std::string& seatId) {
+        SeatNode* current = head;
+        while (current != nullptr) {
+            if (current->seatId == seatId) {
+                if (current->isBooked) return false;
+                current->isBooked = true;
+                return true;
+            }
+            current = current->next;
+        }
+        return false;  // Seat not found
+    }
+    
+    bool unbookSeat(const std::string& seatId) {
+        SeatNode* current = head;
+        while (current != nullptr) {
+            if (current->seatId == seatId) {
+                if (!current->isBooked) return false;
+                current->isBooked = false;
+                return true;
+            }
+            current = current->next;
+        }
+        return false;  // Seat not found
+    }
+    
+    bool isSeatBooked(const std::string& seatId) const {
+        SeatNode* current = head;
+        while (current != nullptr) {
+            if (current->seatId == seatId) {
+                return current->isBooked;
+            }
+            current = current->next;
+        }
+        return false;  // Seat not found, default to not booked
+    }
+    
+    std::vector<std::string> getBookedSeats() const {
+        std::vector<std::string> bookedSeats;
+        SeatNode* current = head;
+        while (current != nullptr) {
+            if (current->isBooked) {
+                bookedSeats.push_back(current->seatId);
+            }
+            current = current->next;
+        }
+        return bookedSeats;
+    }
+    
+    size_t size() const { return size_; }
+
+private:
+    void clear() {
+        SeatNode* current = head;
+        while (current != nullptr) {
+            SeatNode* next = current->next;
+            delete current;
+            current = next;
+        }
+        head = nullptr;
+        size_ = 0;
+    }
+
+    void copyFrom(const SeatManager& other) {
+        SeatNode** tail = &head;
+        for (const SeatNode* node = other.head; node != nullptr; node = node->next) {
+            *tail = new SeatNode(node->seatId);
+            (*tail)->isBooked = node->isBooked;
+            tail = &(*tail)->next;
+        }
+        size_ = other.size_;
+    }
+
+    SeatNode* head;
+    size_t size_;
+};
+
+// One bit per seat, rows padded to whole 64-bit words so each row can be
+// scanned word by word. Bit `column % 64` of word `column / 64` is the seat.
+class SeatBitmap {
+public:
+    SeatBitmap(int rows = 0, int seatsPerRow = 0)
+        : rows_(rows), seatsPerRow_(seatsPerRow),
+          wordsPerRow_((seatsPerRow + 63) / 64),
+          words_(static_cast<size_t>(rows) * wordsPerRow_, 0) {}
+    
+    int rows() const { return rows_; }
+    int seatsPerRow() const { return seatsPerRow_; }
+    int wordsPerRow() const { return wordsPerRow_; }
+    
+    bool contains(int row, int column) const {
+        return row >= 0 && row < rows_ && column >= 0 && column < seatsPerRow_;
+    }
+    
+    bool test(int row, int column) const {
+        return (words_[index(row, column)] >> (column & 63)) & 1;
+    }
+    
+    void set(int row, int column, bool value) {
+        uint64_t bit = uint64_t(1) << (column & 63);
+        if (value) {
+            words_[index(row, column)] |= bit;
+        } else {
+            words_[index(row, column)] &= ~bit;
+        }
+    }
+    
+    size_t count() const {
+        size_t total = 0;
+        for (uint64_t word : words_) {
+            total += std::bitset<64>(word).count();
+        }
+        return total;
+    }
+    
+    const uint64_t* row(int r) const { return &words_[static_cast<size_t>(r) * wordsPerRow_]; }
+    
+    // Raw words, row after row; bit (row * wordsPerRow + column / 64) * 64 + column % 64
+    size_t wordCount() const { return words_.size(); }
+    
+    void orWords(const std::vector<uint64_t>& words) {
+        for (size_t i = 0; i < words_.size() && i < words.size(); i++) {
+            words_[i] |= words[i];
+        }
+    }
+    
+    // Mask of the seats that exist in word w of a row
+    uint64_t validMask(int w) const {
+        int bits = std::min(64, seatsPerRow_ - w * 64);
+        return bits >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+    }
+    
+    // Bit c of `starts` is set when seats c .. c+length-1 of the row are all clear.
+    // The run mask is built by AND-ing shifted copies of the free mask, doubling
+    // the covered length each step, so it costs O(log length) word operations.
+    void runStarts(int r, int length, std::vector<uint64_t>& starts) const {
+        const uint64_t* taken = row(r);
+        starts.resize(wordsPerRow_);
+        for (int w = 0; w < wordsPerRow_; w++) {
+            starts[w] = ~taken[w] & validMask(w);
+        }
+        std::vector<uint64_t> shifted(wordsPerRow_);
+        int covered = 1;
+        while (covered < length) {
+            int step = std::min(covered, length - covered);
+            shiftRight(starts, step, shifted);
+            for (int w = 0; w < wordsPerRow_; w++) {
+                starts[w] &= shifted[w];
+            }
+            covered += step;
+        }
+    }
+    
+private:
+    int rows_;
+    int seatsPerRow_;
+    int wordsPerRow_;
+    std::vector<uint64_t> words_;
+    
+    size_t index(int row, int column) const {
+        return static_cast<size_t>(row) * wordsPerRow_ + (column >> 6);
+    }
+    
+    // Multi-word shift towards lower seat numbers, filling with zeros
+    void shiftRight(const std::vector<uint64_t>& in, int count, std::vector<uint64_t>& out) const {
+        int wordShift = count >> 6;
+        int bitShift = count & 63;
+        for (int w = 0; w < wordsPerRow_; w++) {
+            int src = w + wordShift;
+            uint64_t low = src < wordsPerRow_ ? in[src] : 0;
+            uint64_t high = src + 1 < wordsPerRow_ ? in[src + 1] : 0;
+            out[w] = bitShift == 0 ? low : (low >> bitShift) | (high << (64 - bitShift));
+        }
+    }
+};
+
+// Seat plan of one auditorium screen: rows A.., seats 1..seatsPerRow per row,
+// aisle columns that hold no seats, individually blocked seats and a price tier
+// per row. Built once per screen and shared by every showtime on that screen.
+class SeatLayout {
+public:
+    SeatLayout(int rows, int seatsPerRow)
+        : rows_(std::min(std::max(rows, 1), 26)), seatsPerRow_(std::min(std::max(seatsPerRow, 1), 999)),
+          unavailable_(rows_, seatsPerRow_), tierNames_{"standard"}, rowTier_(rows_, 0) {}
+    
+    // The 10x16 grid the booking UI draws: seats 8 and 9 form the centre aisle
+    // and rows H-J are premium
+    static std::shared_ptr<const SeatLayout> standard() {
+        static const std::shared_ptr<const SeatLayout> layout = [] {
+            auto built = std::make_shared<SeatLayout>(10, 16);
+            built->addAisle(7);
+            built->addAisle(8);
+            for (int row = 7; row < 10; row++) {
+                built->setRowTier(row, "premium");
+            }
+            return built;
+        }();
+        return layout;
+    }
+    
+    void addAisle(int column) {
+        if (column < 0 || column >= seatsPerRow_ || isAisle(column)) return;
+        aisles_.push_back(column);
+        for (int row = 0; row < rows_; row++) {
+            unavailable_.set(row, column, true);
+        }
+    }
+    
+    void block(int row, int column) {
+        if (!unavailable_.contains(row, column) || unavailable_.test(row, column)) return;
+        blocked_.emplace_back(row, column);
+        unavailable_.set(row, column, true);
+    }
+    
+    void setRowTier(int row, const std::string& tier) {
+        if (row < 0 || row >= rows_) return;
+        auto it = std::find(tierNames_.begin(), tierNames_.end(), tier);
+        if (it == tierNames_.end()) {
+            it = tierNames_.insert(tierNames_.end(), tier);
+        }
+        rowTier_[row] = static_cast<int>(it - tierNames_.begin());
+    }
+    
+    int rows() const { return rows_; }
+    int seatsPerRow() const { return seatsPerRow_; }
+    int capacity() const { return rows_ * seatsPerRow_ - static_cast<int>(unavailable_.count()); }
+    
+    // Aisles and blocked seats, set in every showtime's seat bitmap up front
+    const SeatBitmap& unavailable() const { return unavailable_; }
+    
+    const std::vector<std::string>& tiers() const { return tierNames_; }
+    int tierIndex(int row) const { return rowTier_[row]; }
+    const std::string& tierOf(int row) const { return tierNames_[rowTier_[row]]; }
+    
+    // O(1) seat validation: the label parses, is on the grid and is a real seat
+    bool locate(const std::string& label, int& row, int& column) const {
+        return parse_seat_label(label, row, column) && unavailable_.contains(row, column) &&
+               !unavailable_.test(row, column);
+    }
+    
+    bool isAisle(int column) const {
+        return std::find(aisles_.begin(), aisles_.end(), column) != aisles_.end();
+    }
+    
+    // {"rows": 10, "seatsPerRow": 16, "aisles": [8, 9], "blocked": ["A1"], "tiers": {"premium": ["H", "I", "J"]}}
+    static std::shared_ptr<const SeatLayout> from_json(const json& j) {
+        if (!j.contains("rows") || !j.contains("seatsPerRow")) {
+            throw std::runtime_error("Invalid seat layout JSON - missing rows or seatsPerRow");
+        }
+        auto layout = std::make_shared<SeatLayout>(j["rows"].get<int>(), j["seatsPerRow"].get<int>());
+        if (j.contains("aisles") && j["aisles"].is_array()) {
+            for (const auto& seat : j["aisles"]) {
+                layout->addAisle(seat.get<int>() - 1);
+            }
+        }
+        if (j.contains("blocked") && j["blocked"].is_array()) {
+            for (const auto& label : j["blocked"]) {
+                int row, column;
+                if (parse_seat_label(label.get<std::string>(), row, column)) {
+                    layout->block(row, column);
+                }
+            }
+        }
+        if (j.contains("tiers") && j["tiers"].is_object()) {
+            for (const auto& [tier, rowLabels] : j["tiers"].items()) {
+                for (const auto& label : rowLabels) {
+                    int row, column;
+                    if (parse_seat_label(label.get<std::string>() + "1", row, column)) {
+                        layout->setRowTier(row, tier);
+                    }
+                }
+            }
+        }
+        return layout;
+    }
+    
+    json to_json() const {
+        json j;
+        j["rows"] = rows_;
+        j["seatsPerRow"] = seatsPerRow_;
+        json aisles = json::array();
+        for (int column : aisles_) {
+            aisles.push_back(column + 1);
+        }
+        j["aisles"] = aisles;
+        json blocked = json::array();
+        for (const auto& [row, column] : blocked_) {
+            blocked.push_back(seat_label(row, column));
+        }
+        j["blocked"] = blocked;
+        json tiers = json::object();
+        for (int row = 0; row < rows_; row++) {
+            if (rowTier_[row] != 0) {
+                tiers[tierOf(row)].push_back(seat_label(row, 0).substr(0, 1));
+            }
+        }
+        j["tiers"] = tiers;
+        return j;
+    }
+    
+    // As reported to clients: to_json plus the capacity and every row's tier
+    json describe() const {
+        json layout_dict;
+        layout_dict["rows"] = rows_;
+        layout_dict["seatsPerRow"] = seatsPerRow_;
+        layout_dict["capacity"] = capacity();
+        std::vector<int> aisles;
+        for (int column : aisles_) {
+            aisles.push_back(column + 1);
+        }
+        layout_dict["aisles"] = aisles;
+        std::vector<std::string> blocked;
+        for (const auto& [row, column] : blocked_) {
+            blocked.push_back(seat_label(row, column));
+        }
+        layout_dict["blocked"] = blocked;
+        std::map<std::string, std::vector<std::string>> tiers;
+        for (int row = 0; row < rows_; row++) {
+            tiers[tierOf(row)].push_back(seat_label(row, 0).substr(0, 1));
+        }
+        layout_dict["tiers"] = tiers;
+        return layout_dict;
+    }
+    
+private:
+    int rows_;
+    int seatsPerRow_;
+    SeatBitmap unavailable_;
+    std::vector<int> aisles_;
+    std::vector<std::pair<int, int>> blocked_;
+    std::vector<std::string> tierNames_;  // index 0 is the default tier
+    std::vector<int> rowTier_;
+};
+
+// Showtime class
+class Showtime {
+public:
+    Showtime() = default;
+    
+    Showtime(std::string id, int movieId, int cinemaId, std::string cinemaName,
+             std::string date, std::string time, std::string screenType, double price)
+        : id_(std::move(id)), movieId_(movieId), cinemaId_(cinemaId), 
+          cinemaName_(std::move(cinemaName)), date_(std::move(date)), 
+          time_(std::move(time)), screenType_(std::move(screenType)), price_(price) {}
+    
+    // Getters
+    std::string getId() const { return id_; }
+    int getMovieId() const { return movieId_; }
+    int getCinemaId() const { return cinemaId_; }
+    std::string getCinemaName() const { return cinemaName_; }
+    std::string getDate() const { return date_; }
+    std::string getTime() const { return time_; }
+    std::string getScreenType() const { return screenType_; }
+    double getPrice() const { return price_; }
+    int getScreen() const { return screen_; }
+    void setScreen(int screen) { screen_ = screen; }
+    
+    // Seat plan of the screen this showtime runs on (shared, never null once added to a cinema)
+    const std::shared_ptr<const SeatLayout>& getLayout() const { return layout_; }
+    void setLayout(std::shared_ptr<const SeatLayout> layout) { layout_ = std::move(layout); }
+    
+    // Methods for seats using the optimized SeatManager
+    bool isSeatBooked(const std::string& seat) const {
+        return seatManager_.isSeatBooked(seat);
+    }
+    
+    void bookSeat(const std::string& seat) {
+        // First ensure the seat exists in our manager
+        seatManager_.addSeat(seat);
+        seatManager_.bookSeat(seat);
+    }
+    
+    void unbookSeat(const std::string& seat) {
+        seatManager_.unbookSeat(seat);
+    }
+    
+    std::vector<std::string> getBookedSeats() const { 
+        return seatManager_.getBookedSeats(); 
+    }
+    
+    // Convert to JSON
+    json to_json() const {
+        json showtime_dict;
+        showtime_dict["id"] = id_;
+        showtime_dict["movieId"] = movieId_;
+        showtime_dict["cinemaId"] = cinemaId_;
+        showtime_dict["cinemaName"] = cinemaName_;
+        showtime_dict["date"] = date_;
+        showtime_dict["time"] = time_;
+        showtime_dict["screenType"] = screenType_;
+        showtime_dict["price"] = price_;
+        showtime_dict["screen"] = screen_;
+        
+        showtime_dict["bookedSeats"] = seatManager_.getBookedSeats();
+        
+        return showtime_dict;
+    }
+    
+    // Create from JSON
+    static Showtime from_json(const json& j) {
+        if (!j.contains("id") || !j.contains("movieId") || !j.contains("cinemaId")) {
+            throw std::runtime_error("Invalid showtime JSON - missing required fields");
+        }
+        
+        Showtime showtime(
+            j["id"].get<std::string>(),
+            j["movieId"].get<int>(),
+            j["cinemaId"].get<int>(),
+            j.contains("cinemaName") && !j["cinemaName"].is_null() ? j["cinemaName"].get<std::string>() : "",
+            j.contains("date") && !j["date"].is_null() ? j["date"].get<std::string>() : "",
+            j.contains("time") && !j["time"].is_null() ? j["time"].get<std::string>() : "",
+            j.contains("screenType") && !j["screenType"].is_null() ? j["screenType"].get<std::string>() : "Standard",
+            j.contains("price") && !j["price"].is_null() ? j["price"].get<double>() : 0.0
+        );
+        if (j.contains("screen") && !j["screen"].is_null()) {
+            showtime.setScreen(j["screen"].get<int>());
+        }
+        
+        // Load booked seats if available
+        if (j.contains("bookedSeats") && !j["bookedSeats"].is_null() && j["bookedSeats"].is_array()) {
+            for (const auto& seat : j["bookedSeats"]) {
+                if (seat.is_string()) {
+                    showtime.bookSeat(seat.get<std::string>());
+                }
+            }
+        }
+        
+        return showtime;
+    }
+
+private:
+    std::string id_;
+    int movieId_ = 0;
+    int cinemaId_ = 0;
+    std::string cinemaName_;
+    std::string date_;
+    std::string time_;
+    std::string screenType_;
+    double price_ = 0.0;
+    int screen_ = 0;  // 0 when the screen is not known
+    std::shared_ptr<const SeatLayout> layout_;
+    SeatManager seatManager_;  // Replace vector with efficient SeatManager
+};
+
+// Cinema class
+class Cinema {
+public:
+    Cinema() = default;
+    
+    Cinema(int id, std::string name, std::string location, int screens, int totalSeats)
+        : id_(id), name_(std::move(name)), location_(std::move(location)), 
+          screens_(screens), totalSeats_(totalSeats) {}
+    
+    // Getters
+    int getId() const { return id_; }
+    std::string getName() const { return name_; }
+    std::string getLocation() const { return location_; }
+    int getScreens() const { return screens_; }
+    int getTotalSeats() const { return totalSeats_; }
+    
+    // Add a showtime to this cinema, attaching the layout of its screen
+    void addShowtime(Showtime showtime) {
+        showtime.setLayout(layoutForScreen(showtime.getScreen()));
+        showtimes_.push_back(std::move(showtime));
+    }
+    
+    // Layout of a screen; screens without their own layout use the standard one
+    std::shared_ptr<const SeatLayout> layoutForScreen(int screen) const {
+        auto it = screenLayouts_.find(screen);
+        return it != screenLayouts_.end() ? it->second : SeatLayout::standard();
+    }
+    
+    void setScreenLayout(int screen, std::shared_ptr<const SeatLayout> layout) {
+        screenLayouts_[screen] = std::move(layout);
+    }
+    
+    const std::map<int, std::shared_ptr<const SeatLayout>>& getScreenLayouts() const {
+        return screenLayouts_;
+    }
+    
+    const std::vector<Showtime>& getShowtimes() const {
+        return showtimes_;
+    }
+    
+    // Convert to JSON, with each screen's layout as reported to clients
+    json to_json() const {
+        json cinema_dict;
+        cinema_dict["id"] = id_;
+        cinema_dict["name"] = name_;
+        cinema_dict["location"] = location_;
+        cinema_dict["screens"] = screens_;
+        cinema_dict["totalSeats"] = totalSeats_;
+        
+        json layouts_list = json::array();
+        for (const auto& [screen, layout] : screenLayouts_) {
+            json layout_dict = layout->describe();
+            layout_dict["screen"] = screen;
+            layouts_list.push_back(layout_dict);
+        }
+        cinema_dict["screenLayouts"] = layouts_list;
+        
+        json showtimes_list = json::array();
+        for (const auto& showtime : showtimes_) {
+            showtimes_list.push_back(showtime.to_json());
+        }
+        cinema_dict["showtimes"] = showtimes_list;
+        
+        return cinema_dict;
+    }
+    
+    // Create from JSON
+    static Cinema from_json(const json& j) {
+        if (!j.contains("id") || !j.contains("name")) {
+            throw std::runtime_error("Invalid cinema JSON - missing required fields");
+        }
+        
+        Cinema cinema(
+            j["id"].get<int>(),
+            j["name"].get<std::string>(),
+            j.contains("location") && !j["location"].is_null() ? j["location"].get<std::string>() : "",
+            j.contains("screens") && !j["screens"].is_null() ? j["screens"].get<int>() : 1,
+            j.contains("totalSeats") && !j["totalSeats"].is_null() ? j["totalSeats"].get<int>() : 100
+        );
+        
+        // Layouts first so showtimes pick up their screen's layout
+        if (j.contains("screenLayouts") && j["screenLayouts"].is_array()) {
+            cinema.loadScreenLayouts(j["screenLayouts"]);
+        }
+        
+        if (j.contains("showtimes") && !j["showtimes"].is_null() && j["showtimes"].is_array()) {
+            for (const auto& showtime_json : j["showtimes"]) {
+                try {
+                    cinema.addShowtime(Showtime::from_json(showtime_json));
+                } catch (const std::exception& e) {
+                    logEvent(LogLevel::Warn, "Failed to parse showtime", {{"error", e.what()}});
+                }
+            }
+        }
+        
+        return cinema;
+    }
+    
+    // [{"screen": 1, "rows": 12, "seatsPerRow": 20, ...}, ...]
+    void loadScreenLayouts(const json& layouts) {
+        for (const auto& layout_json : layouts) {
+            try {
+                int screen = layout_json.contains("screen") ? layout_json["screen"].get<int>() : 0;
+                setScreenLayout(screen, SeatLayout::from_json(layout_json));
+            } catch (const std::exception& e) {
+                logEvent(LogLevel::Warn, "Failed to parse screen layout", {{"error", e.what()}});
+            }
+        }
+    }
+
+private:
+    int id_ = 0;
+    std::string name_;
+    std::string location_;
+    int screens_ = 0;
+    int totalSeats_ = 0;
+    std::vector<Showtime> showtimes_;
+    std::map<int, std::shared_ptr<const SeatLayout>> screenLayouts_;
+};
+
+// Booking class
+class Booking {
+public:
+    Booking() = default;
+    
+    Booking(std::string id, std::string userId, int movieId, std::string movieTitle,
+            std::string moviePoster, std::string showtimeId, std::string showtimeDate,
+            std::string showtimeTime, int cinemaId, std::string cinemaName,
+            std::string screenType, std::vector<std::string> seats, double totalPrice,
+            std::string bookingDate, bool cancelled = false)
+        : id_(std::move(id)), userId_(std::move(userId)), movieId_(movieId), 
+          movieTitle_(std::move(movieTitle)), moviePoster_(std::move(moviePoster)),
+          showtimeId_(std::move(showtimeId)), showtimeDate_(std::move(showtimeDate)),
+          showtimeTime_(std::move(showtimeTime)), cinemaId_(cinemaId),
+          cinemaName_(std::move(cinemaName)), screenType_(std::move(screenType)),
+          seats_(std::move(seats)), totalPrice_(totalPrice),
+          bookingDate_(std::move(bookingDate)), cancelled_(cancelled) {}
+    
+    // Getters (by reference - analytics scans call these for every booking)
+    const std::string& getId() const { return id_; }
+    const std::string& getUserId() const { return userId_; }
+    int getMovieId() const { return movieId_; }
+    const std::string& getMovieTitle() const { return movieTitle_; }
+    const std::string& getMoviePoster() const { return moviePoster_; }
+    const std::string& getShowtimeId() const { return showtimeId_; }
+    const std::string& getShowtimeDate() const { return showtimeDate_; }
+    const std::string& getShowtimeTime() const { return showtimeTime_; }
+    int getCinemaId() const { return cinemaId_; }
+    const std::string& getCinemaName() const { return cinemaName_; }
+    const std::string& getScreenType() const { return screenType_; }
+    const std::vector<std::string>& getSeats() const { return seats_; }
+    double getTotalPrice() const { return totalPrice_; }
+    const std::string& getBookingDate() const { return bookingDate_; }
+    bool isCancelled() const { return cancelled_; }
+    
+    // Setters
+    void setTotalPrice(double totalPrice) { totalPrice_ = totalPrice; }
+    void cancel() { cancelled_ = true; }
+    void restore() { cancelled_ = false; }
+    
+    // Create from JSON
+    static Booking from_json(const json& j) {
+        if (!j.contains("userId") || !j.contains("movieId") || !j.contains("showtimeId")) {
+            throw std::runtime_error("Invalid booking JSON - missing required fields");
+        }
+        
+        std::vector<std::string> seats;
+        if (j.contains("seats") && !j["seats"].is_null() && j["seats"].is_array()) {
+            for (const auto& seat : j["seats"]) {
+                if (seat.is_string()) {
+                    seats.push_back(seat.get<std::string>());
+                }
+            }
+        }
+        
+        std::string id = j.contains("id") && !j["id"].is_null() ? j["id"].get<std::string>() : generate_uuid();
+        std::string userId = j["userId"].get<std::string>();
+        int movieId = j["movieId"].get<int>();
+        std::string movieTitle = j.contains("movieTitle") && !j["movieTitle"].is_null() ? j["movieTitle"].get<std::string>() : "";
+        std::string moviePoster = j.contains("moviePoster") && !j["moviePoster"].is_null() ? j["moviePoster"].get<std::string>() : "";
+        std::string showtimeId = j["showtimeId"].get<std::string>();
+        std::string showtimeDate = j.contains("showtimeDate") && !j["showtimeDate"].is_null() ? j["showtimeDate"].get<std::string>() : "";
+        std::string showtimeTime = j.contains("showtimeTime") && !j["showtimeTime"].is_null() ? j["showtimeTime"].get<std::string>() : "";
+        int cinemaId = j.contains("cinemaId") && !j["cinemaId"].is_null() ? j["cinemaId"].get<int>() : 0;
+        std::string cinemaName = j.contains("cinemaName") && !j["cinemaName"].is_null() ? j["cinemaName"].get<std::string>() : "";
+        std::string screenType = j.contains("screenType") && !j["screenType"].is_null() ? j["screenType"].get<std::string>() : "Standard";
+        double totalPrice = j.contains("totalPrice") && !j["totalPrice"].is_null() ? j["totalPrice"].get<double>() : 0.0;
+        std::string bookingDate = j.contains("bookingDate") && !j["bookingDate"].is_null() ? j["bookingDate"].get<std::string>() : get_current_date();
+        bool cancelled = j.contains("cancelled") && !j["cancelled"].is_null() ? j["cancelled"].get<bool>() : false;
+        
+        return Booking(
+            id, userId, movieId, movieTitle, moviePoster, showtimeId,
+            showtimeDate, showtimeTime, cinemaId, cinemaName, screenType,
+            seats, totalPrice, bookingDate, cancelled
+        );
+    }
+    
+    // Convert to JSON (the bookings file format, without movie details)
+    json to_json() const {
+        json booking_json;
+        booking_json["id"] = id_;
+        booking_json["userId"] = userId_;
+        booking_json["movieId"] = movieId_;
+        booking_json["movieTitle"] = movieTitle_;
+        booking_json["moviePoster"] = moviePoster_;
+        booking_json["showtimeId"] = showtimeId_;
+        booking_json["showtimeDate"] = showtimeDate_;
+        booking_json["showtimeTime"] = showtimeTime_;
+        booking_json["cinemaId"] = cinemaId_;
+        booking_json["cinemaName"] = cinemaName_;
+        booking_json["screenType"] = screenType_;
+        booking_json["seats"] = seats_;
+        booking_json["totalPrice"] = totalPrice_;
+        booking_json["bookingDate"] = bookingDate_;
+        booking_json["cancelled"] = cancelled_;
+        return booking_json;
+    }
+
+private:
+    std::string id_;
+    std::string userId_;
+    int movieId_ = 0;
+    std::string movieTitle_;
+    std::string moviePoster_;
+    std::string showtimeId_;
+    std::string showtimeDate_;
+    std::string showtimeTime_;
+    int cinemaId_ = 0;
+    std::string cinemaName_;
+    std::string screenType_;
+    std::vector<std::string> seats_;
+    double totalPrice_ = 0.0;
+    std::string bookingDate_;
+    bool cancelled_ = false;
+};
+
+// Raised when a request is rate limited or times out in the admission queue
+class AdmissionError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+struct AdmissionConfig {
+    bool enabled = false;             // off unless the host turns it on
+    int maxConcurrent = 8;            // requests per showtime inside the engine at once
+    double userRate = 5.0;            // requests per second per user
+    double userBurst = 10.0;
+    double showtimeRate = 200.0;      // requests per second per showtime
+    double showtimeBurst = 400.0;
+    double queueTimeoutSeconds = 10.0;
+    double ticketTtlSeconds = 120.0;  // lifetime of a waiting-room ticket
+    double pollGraceSeconds = 30.0;   // a ticket not polled for this long is dropped
+};
+
+// One versioned delta of a showtime's seat state. Booked seats stop being
+// held, so a consumer applying deltas in order tracks booked and held seats.
+struct SeatChange {
+    enum class Kind { Booked, Unbooked, Held, Released };
+    
+    std::string showtimeId;
+    uint64_t version = 0;
+    Kind kind = Kind::Booked;
+    std::vector<std::string> seats;
+    
+    static const char* kindName(Kind kind) {
+        switch (kind) {
+            case Kind::Booked: return "booked";
+            case Kind::Unbooked: return "unbooked";
+            case Kind::Held: return "held";
+            case Kind::Released: return "released";
+        }
+        return "";
+    }
+    
+    json to_json() const {
+        json change_dict;
+        change_dict["showtimeId"] = showtimeId;
+        change_dict["version"] = version;
+        change_dict["kind"] = kindName(kind);
+        change_dict["seats"] = seats;
+        return change_dict;
+    }
+};
+
+// Pricing rules applied on top of a showtime's base price. Every multiplier
+// defaults to 1, so without configured rules a seat costs exactly the showtime
+// price - which is what the booking UI charges.
+struct PricingRules {
+    std::map<std::string, double> tierMultipliers;        // "premium" -> 1.25
+    std::map<std::string, double> screenTypeMultipliers;  // "IMAX" -> 1.2
+    std::array<double, 7> weekdayMultipliers{{1, 1, 1, 1, 1, 1, 1}};  // Sunday first
+    
+    struct TimeBand {
+        int fromHour;  // inclusive
+        int toHour;    // exclusive
+        double multiplier;
+    };
+    std::vector<TimeBand> timeBands;
+    
+    // Applied when occupancy before the booking is at least `occupancy` (0-1);
+    // the highest matching step wins
+    struct SurgeStep {
+        double occupancy;
+        double multiplier;
+    };
+    std::vector<SurgeStep> surge;
+    
+    // Keys match the admin API: tiers, screenTypes, weekdays, timeBands, surge
+    static PricingRules from_json(const json& j) {
+        PricingRules rules;
+        if (j.contains("tiers")) {
+            rules.tierMultipliers = j["tiers"].get<std::map<std::string, double>>();
+        }
+        if (j.contains("screenTypes")) {
+            rules.screenTypeMultipliers = j["screenTypes"].get<std::map<std::string, double>>();
+        }
+        if (j.contains("weekdays")) {
+            std::vector<double> weekdays = j["weekdays"].get<std::vector<double>>();
+            if (weekdays.size() != 7) {
+                throw std::runtime_error("weekdays must have 7 multipliers, Sunday first");
+            }
+            std::copy(weekdays.begin(), weekdays.end(), rules.weekdayMultipliers.begin());
+        }
+        if (j.contains("timeBands")) {
+            for (const auto& band : j["timeBands"]) {
+                rules.timeBands.push_back({band["from"].get<int>(), band["to"].get<int>(),
+                                           band["multiplier"].get<double>()});
+            }
+        }
+        if (j.contains("surge")) {
+            for (const auto& step : j["surge"]) {
+                rules.surge.push_back({step["occupancy"].get<double>(), step["multiplier"].get<double>()});
+            }
+        }
+        return rules;
+    }
+    
+    json to_json() const {
+        json dict;
+        dict["tiers"] = tierMultipliers;
+        dict["screenTypes"] = screenTypeMultipliers;
+        dict["weekdays"] = std::vector<double>(weekdayMultipliers.begin(), weekdayMultipliers.end());
+        json bands = json::array();
+        for (const auto& band : timeBands) {
+            json item;
+            item["from"] = band.fromHour;
+            item["to"] = band.toHour;
+            item["multiplier"] = band.multiplier;
+            bands.push_back(item);
+        }
+        dict["timeBands"] = bands;
+        json steps = json::array();
+        for (const auto& step : surge) {
+            json item;
+            item["occupancy"] = step.occupancy;
+            item["multiplier"] = step.multiplier;
+            steps.push_back(item);
+        }
+        dict["surge"] = steps;
+        return dict;
+    }
+};
+
+// Options for findBestSeats. The sweet spot defaults to the horizontal centre
+// of the row about two thirds of the way back from the screen.
+struct SeatPreferences {
+    int sweetSpotRow = -1;
+    double rowWeight = 1.5;
+    std::vector<int> allowedRows;  // empty means any row
+    bool hold = false;
+    std::string userId;
+    double ttlSeconds = 300.0;
+};
+// One booking request. totalPrice is what the client was charged; confirmHold
+// fills it from the hold's quote when it is left empty. idempotencyKey and
+// admissionTicket are optional (empty / 0 means none).
+struct BookingRequest {
+    std::string userId;
+    int movieId = 0;
+    std::string movieTitle;
+    std::string moviePoster;
+    std::string showtimeId;
+    std::string showtimeDate;
+    std::string showtimeTime;
+    int cinemaId = 0;
+    std::string cinemaName;
+    std::string screenType = "Standard";
+    std::vector<std::string> seats;
+    std::optional<double> totalPrice;
+    std::string idempotencyKey;
+    uint64_t admissionTicket = 0;
+};
+
+// Booking engine - main class that manages all operations. Every method is
+// safe to call from any thread. Errors surface as std::runtime_error (or
+// AdmissionError when admission control turns a request away).
+class BookingSystem {
+public:
+    // Bookings are loaded from and saved to dataDir/bookings.json; by default
+    // the data directory next to the backend sources (backend/data)
+    explicit BookingSystem(const std::string& dataDir = "");
+    ~BookingSystem();
+    BookingSystem(const BookingSystem&) = delete;
+    BookingSystem& operator=(const BookingSystem&) = delete;
+    
+    // Movies
+    void loadMovies(const std::string& filename);
+    std::vector<Movie> getAllMovies() const;
+    std::vector<Movie> getSortedMovies() const;
+    std::vector<Movie> getPopularMovies(int count) const;
+    std::vector<Movie> getTrendingMovies(int count) const;
+    void setTrendingHalfLife(double hours);
+    Movie getMovieById(int id) const;
+    bool addMovie(const Movie& movie);
+    bool saveMovies(const std::string& filename) const;
+    
+    // Cinemas and showtimes
+    void loadCinemas(const std::string& filename);
+    std::vector<Cinema> getAllCinemas() const;
+    Cinema getCinemaById(int id) const;
+    bool addCinema(const Cinema& cinema);
+    bool saveCinemas(const std::string& filename) const;
+    bool addShowtime(const Showtime& showtime);
+    Showtime getShowtimeById(const std::string& id) const;
+    std::vector<Showtime> getShowtimesByMovie(int movieId) const;
+    std::vector<Showtime> getShowtimesByDate(const std::string& date) const;
+    std::vector<Showtime> getShowtimesByMovieAndDate(int movieId, const std::string& date) const;
+    
+    // Seat state. Replies are the JSON documents the HTTP API returns.
+    std::vector<std::string> getBookedSeatsForShowtime(const std::string& showtimeId);
+    json getSeatAvailability(const std::string& showtimeId);
+    json getSeatLayout(const std::string& showtimeId) const;
+    json getSeatMap(const std::string& showtimeId, const std::string& etag = "",
+                    const std::string& format = "list");
+    json seatChangesSince(const std::string& showtimeId, uint64_t sinceVersion);
+    int subscribeSeatChanges(const std::function<void(const SeatChange&)>& callback,
+                             const std::string& showtimeId = "");
+    bool unsubscribeSeatChanges(int id);
+    
+    // Pricing
+    json quote(const std::string& showtimeId, const std::vector<std::string>& seats) const;
+    void setPricingRules(const PricingRules& rules);
+    PricingRules getPricingRules() const;
+    
+    // Holds and bookings
+    std::string holdSeats(const std::string& showtimeId, const std::vector<std::string>& seats,
+                          const std::string& userId, double ttlSeconds = 300.0);
+    Booking confirmHold(const std::string& token, const BookingRequest& request);
+    bool releaseHold(const std::string& token);
+    json findBestSeats(const std::string& showtimeId, int count, const SeatPreferences& preferences = {});
+    Booking createBooking(const BookingRequest& request);
+    std::vector<Booking> createBookings(const std::vector<BookingRequest>& requests);
+    Booking getBookingById(const std::string& id) const;
+    bool cancelBooking(const std::string& id);
+    bool restoreBooking(const std::string& id);
+    std::vector<Booking> getBookingsByUser(const std::string& userId) const;
+    std::vector<Booking> getAllBookings() const;
+    
+    // Admission control and seat inventory sharing
+    json enterWaitingRoom(const std::string& showtimeId, const std::string& userId);
+    int getQueuePosition(const std::string& showtimeId, uint64_t ticket);
+    void configureAdmission(const AdmissionConfig& config);
+    AdmissionConfig getAdmissionConfig() const;
+    json getAdmissionStats() const;
+    json getSeatClaimStats() const;
+    void enableSharedInventory(const std::string& name = "/cineverse_seats", bool reset = false);
+    
+    // Analytics. In sketch mode the exact per-user counts are not maintained
+    // and getAnalytics reports user figures from the sketches only.
+    json getAnalytics(bool approximate = false) const;
+    void setSketchAnalytics(bool enabled);
+    bool sketchAnalyticsEnabled() const;
+    json bookingReport(const std::string& groupBy) const;
+    json analyticsRange(const std::string& from, const std::string& to,
+                        const std::string& groupBy = "total", const std::string& granularity = "day") const;
+    
+    // Persistence
+    void saveData() const;
+    void markShutdownInProgress();
+    
+    // Metrics: calls, errors and latency of every method above, mutex wait
+    // and data file load/save time. prometheusMetrics() renders the same data
+    // in the Prometheus text exposition format.
+    json getMetrics() const;
+    std::string prometheusMetrics() const;
+    void resetMetrics();
+    
+    // Lock contention profiling: while enabled, every acquisition of the engine
+    // mutex records its wait, hold time and queued waiters against the calling
+    // function and line. Enabling starts a fresh profile; the report ranks call
+    // sites by total wait.
+    void setLockProfiling(bool enabled);
+    json lockContentionReport() const;
+    
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
@@ -16,13 +16,15 @@ else:
     # Add OpenMP support for Linux and macOS
     extra_compile_args.append('-fopenmp')
     extra_link_args.append('-fopenmp')
+    if sys.platform.startswith('linux'):
+        extra_link_args.append('-lrt')  # shm_open for the shared seat inventory
 
 # Define the extension module
 ext_modules = [
     Extension(
         'cinema_engine',
-        ['src/cinema_engine.cpp'],
-        include_dirs=[pybind11.get_include()],
+        ['cinema_engine.cpp', 'core/cinema_core.cpp'],
+        include_dirs=[pybind11.get_include(), 'core', 'third_party/json/include'],
         language='c++',
         extra_compile_args=extra_compile_args,
         extra_link_args=extra_link_args,
@@ -0,0 +1,851 @@
+// Native engine tests, run by ctest (or directly: cinema_tests [name...]).
+//
+// The engine's building blocks - parallel_reduce, sketches, the timer wheel,
+// the idempotency table, token buckets, the admission queue, the shared-memory
+// journal - are internal to cinema_core.cpp, so this file compiles that
+// translation unit in and tests them directly. Engine-level behaviour (analytics, price checks,
+// holds, best-seat search, batches, keyed retries, seat claims, seat maps)
+// goes through the public BookingSystem API against a small dataset in a
+// temporary directory. Each test prints PASS or FAIL; the exit status is
+// non-zero if any check fails.
+#include "cinema_core.cpp"
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if (!(condition)) {                                                               \
+            std::cerr << "  " << __FILE__ << ":" << __LINE__ << ": " << #condition << "\n"; \
+            failures++;                                                                   \
+        }                                                                                 \
+    } while (0)
+
+// A throwaway data directory with one cinema running `showtimes` showtimes
+class TempDataset {
+public:
+    explicit TempDataset(int showtimes) {
+#ifdef _WIN32
+        const std::string suffix = std::to_string(std::time(nullptr));
+#else
+        const std::string suffix = std::to_string(getpid());
+#endif
+        dir_ = std::filesystem::temp_directory_path() / ("cinema_tests-" + suffix);
+        std::filesystem::remove_all(dir_);
+        std::filesystem::create_directories(dir_);
+
+        json movies = json::array({{{"id", 1}, {"title", "Test Movie"}, {"rating", 7.0}, {"genres", {"Drama"}},
+                                    {"cast", {"Actor"}}, {"language", "English"}, {"duration", "2h"},
+                                    {"releaseDate", "2025-04-01"}}});
+        std::ofstream(dir_ / "movies.json") << movies.dump();
+
+        json list = json::array();
+        for (int i = 0; i < showtimes; i++) {
+            // An awkward price, so floating-point revenue totals would drift
+            list.push_back({{"id", "show-test-" + std::to_string(i)}, {"movieId", 1}, {"cinemaId", 1},
+                            {"cinemaName", "Cinema 1"}, {"date", "2025-05-01"}, {"time", "7:45 PM"},
+                            {"screenType", "Standard"}, {"price", 333.33}, {"screen", i % 8}});
+        }
+        json cinemas = json::array({{{"id", 1}, {"name", "Cinema 1"}, {"location", "City"}, {"screens", 8},
+                                     {"totalSeats", 1120}, {"showtimes", list}}});
+        std::ofstream(dir_ / "cinemas.json") << cinemas.dump();
+        std::ofstream(dir_ / "bookings.json") << "[]";
+    }
+
+    ~TempDataset() {
+        std::error_code ignored;
+        std::filesystem::remove_all(dir_, ignored);
+    }
+
+    std::string path() const { return dir_.string(); }
+
+private:
+    std::filesystem::path dir_;
+};
+
+// Load the dataset, as app.py does at startup
+void loadDataset(BookingSystem& system, const TempDataset& data) {
+    system.loadMovies(data.path() + "/movies.json");
+    system.loadCinemas(data.path() + "/cinemas.json");
+}
+
+// A quoted booking request, as clients send them
+BookingRequest bookingFor(BookingSystem& system, const std::string& userId, const std::string& showtimeId,
+                          std::vector<std::string> seats) {
+    BookingRequest request;
+    request.userId = userId;
+    request.movieId = 1;
+    request.showtimeId = showtimeId;
+    request.seats = std::move(seats);
+    request.totalPrice = system.quote(showtimeId, request.seats)["totalPrice"].get<double>();
+    return request;
+}
+
+std::vector<uint8_t> base64Decode(const std::string& text) {
+    static const std::string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::vector<uint8_t> bytes;
+    uint32_t chunk = 0;
+    int bits = 0;
+    for (char c : text) {
+        if (c == '=') break;
+        chunk = (chunk << 6) | static_cast<uint32_t>(alphabet.find(c));
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            bytes.push_back(static_cast<uint8_t>(chunk >> bits));
+        }
+    }
+    return bytes;
+}
+
+// Cancelling every booking and restoring it again must return the exact
+// analytics document, revenue included
+void testAnalyticsReversal() {
+    TempDataset data(2);
+    BookingSystem system(data.path());
+    loadDataset(system, data);
+    json empty = system.getAnalytics();
+
+    std::vector<std::string> ids;
+    for (int i = 0; i < 20; i++) {
+        std::string showtimeId = "show-test-" + std::to_string(i % 2);
+        std::vector<std::string> seats{seat_label(i / 2, 0)};
+        if (i % 3 == 0) seats.push_back(seat_label(i / 2, 1));
+        ids.push_back(system.createBooking(bookingFor(system, "user-" + std::to_string(i % 7), showtimeId, seats)).getId());
+    }
+    json booked = system.getAnalytics();
+    CHECK(booked["totalBookings"] == 20);
+    CHECK(booked["uniqueUsers"] == 7);
+
+    for (const auto& id : ids) CHECK(system.cancelBooking(id));
+    json cancelled = system.getAnalytics();
+    CHECK(cancelled["totalBookings"] == empty["totalBookings"]);
+    CHECK(cancelled["totalRevenue"] == empty["totalRevenue"]);
+    CHECK(cancelled["uniqueUsers"] == empty["uniqueUsers"]);
+    CHECK(cancelled["cancellationRate"] == 1.0);
+
+    for (const auto& id : ids) CHECK(system.restoreBooking(id));
+    CHECK(system.getAnalytics() == booked);
+
+    // Sketch mode must keep the exact totals
+    system.setSketchAnalytics(true);
+    json sketched = system.getAnalytics();
+    CHECK(sketched["approximate"] == true);
+    CHECK(sketched["totalBookings"] == booked["totalBookings"]);
+    CHECK(sketched["totalRevenue"] == booked["totalRevenue"]);
+}
+
+// A batch with one bad booking changes nothing: no bookings, seats,
+// analytics or seat map versions
+void testBatchRollback() {
+    TempDataset data(2);
+    BookingSystem system(data.path());
+    loadDataset(system, data);
+    system.createBooking(bookingFor(system, "user-1", "show-test-1", {"A5"}));
+    json analytics = system.getAnalytics();
+    json seatMaps = json::array({system.getSeatMap("show-test-0"), system.getSeatMap("show-test-1")});
+    size_t bookings = system.getAllBookings().size();
+
+    std::vector<std::vector<BookingRequest>> failing{
+        // A seat already booked
+        {bookingFor(system, "user-2", "show-test-0", {"A1", "A2"}), bookingFor(system, "user-2", "show-test-1", {"A5"})},
+        // The same seat twice
+        {bookingFor(system, "user-2", "show-test-0", {"B1"}), bookingFor(system, "user-3", "show-test-0", {"B1"})},
+        // A wrong total
+        {bookingFor(system, "user-2", "show-test-0", {"C1"}), bookingFor(system, "user-2", "show-test-1", {"C1"})},
+    };
+    failing[2][1].totalPrice = *failing[2][1].totalPrice + 50.0;
+    for (const auto& batch : failing) {
+        bool rejected = false;
+        try {
+            system.createBookings(batch);
+        } catch (const std::runtime_error&) {
+            rejected = true;
+        }
+        CHECK(rejected);
+        CHECK(system.getAllBookings().size() == bookings);
+        CHECK(system.getAnalytics() == analytics);
+        CHECK(system.getSeatMap("show-test-0") == seatMaps[0]);
+        CHECK(system.getSeatMap("show-test-1") == seatMaps[1]);
+    }
+
+    // The same requests without the bad one go through together
+    std::vector<Booking> created = system.createBookings({failing[0][0], failing[1][0], failing[2][0]});
+    CHECK(created.size() == 3);
+    CHECK(system.getAllBookings().size() == bookings + 3);
+    CHECK(system.getAnalytics()["totalBookings"] == analytics["totalBookings"].get<int>() + 3);
+}
+
+// A total that differs from the server's quote by more than a cent is
+// refused and books nothing; an accepted booking is charged the quote
+void testPriceVerification() {
+    TempDataset data(1);
+    BookingSystem system(data.path());
+    loadDataset(system, data);
+    const std::string showtimeId = "show-test-0";
+
+    BookingRequest request = bookingFor(system, "user-1", showtimeId, {"D5", "D6"});
+    const double quoted = *request.totalPrice;
+    request.totalPrice = quoted - 5.0;
+    bool refused = false;
+    try {
+        system.createBooking(request);
+    } catch (const std::runtime_error& e) {
+        refused = std::string(e.what()).find("does not match quoted price") != std::string::npos;
+    }
+    CHECK(refused);
+    CHECK(system.getAllBookings().empty());
+    CHECK(system.getBookedSeatsForShowtime(showtimeId).empty());
+
+    request.totalPrice = quoted + 0.01;
+    Booking booking = system.createBooking(request);
+    CHECK(booking.getTotalPrice() == quoted);
+    CHECK(system.getAnalytics()["totalRevenue"] == quoted);
+}
+
+// Held seats are closed to other users until the hold is confirmed,
+// released or expires
+void testSeatHolds() {
+    TempDataset data(1);
+    BookingSystem system(data.path());
+    loadDataset(system, data);
+    const std::string showtimeId = "show-test-0";
+
+    std::string token = system.holdSeats(showtimeId, {"A1", "A2"}, "holder", 60.0);
+    auto refused = [&](const std::function<void()>& attempt) {
+        try {
+            attempt();
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    CHECK(refused([&] { system.createBooking(bookingFor(system, "other", showtimeId, {"A2"})); }));
+    CHECK(refused([&] { system.holdSeats(showtimeId, {"A1"}, "other", 60.0); }));
+    CHECK(refused([&] { system.confirmHold(token, bookingFor(system, "other", showtimeId, {})); }));
+    json held = system.getSeatMap(showtimeId)["held"];
+    CHECK(std::set<std::string>(held.begin(), held.end()) == std::set<std::string>({"A1", "A2"}));
+
+    // Confirming with no total charges the quote; the hold is used up
+    const double quoted = system.quote(showtimeId, {"A1", "A2"})["totalPrice"];
+    BookingRequest confirm;
+    confirm.movieId = 1;
+    Booking booking = system.confirmHold(token, confirm);
+    CHECK(booking.getUserId() == "holder");
+    CHECK(booking.getSeats() == std::vector<std::string>({"A1", "A2"}));
+    CHECK(booking.getTotalPrice() == quoted);
+    CHECK(system.getSeatMap(showtimeId)["held"].empty());
+    CHECK(refused([&] { system.confirmHold(token, confirm); }));
+
+    std::string released = system.holdSeats(showtimeId, {"B1"}, "holder", 60.0);
+    CHECK(system.releaseHold(released));
+    CHECK(!system.releaseHold(released));
+    system.createBooking(bookingFor(system, "other", showtimeId, {"B1"}));
+
+    // TTLs are at least a second
+    std::string expiring = system.holdSeats(showtimeId, {"C1", "C2"}, "holder", 0.1);
+    CHECK(refused([&] { system.createBooking(bookingFor(system, "other", showtimeId, {"C1"})); }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1300));
+    system.createBooking(bookingFor(system, "other", showtimeId, {"C1"}));
+    CHECK(refused([&] { system.confirmHold(expiring, confirm); }));
+    CHECK(system.getSeatMap(showtimeId)["held"].empty());
+}
+
+// Blocks are contiguous seats of one row, avoid taken seats, honour the
+// allowed rows and can be held in the same call
+void testFindBestSeats() {
+    TempDataset data(1);
+    BookingSystem system(data.path());
+    loadDataset(system, data);
+    const std::string showtimeId = "show-test-0";
+    auto block = [](const json& result) {
+        std::vector<std::pair<int, int>> seats;
+        for (const auto& label : result["seats"]) {
+            const std::string seat = label;
+            seats.emplace_back(seat[0] - 'A', std::stoi(seat.substr(1)));
+        }
+        return seats;
+    };
+    auto contiguous = [](const std::vector<std::pair<int, int>>& seats) {
+        for (size_t i = 1; i < seats.size(); i++) {
+            if (seats[i].first != seats[0].first || seats[i].second != seats[i - 1].second + 1) return false;
+        }
+        return !seats.empty();
+    };
+
+    SeatPreferences hold;
+    hold.hold = true;
+    hold.userId = "holder";
+    json first = system.findBestSeats(showtimeId, 4, hold);
+    CHECK(first["found"] == true);
+    CHECK(first.contains("holdToken"));
+    std::vector<std::pair<int, int>> firstSeats = block(first);
+    CHECK(firstSeats.size() == 4);
+    CHECK(contiguous(firstSeats));
+    json held = system.getSeatMap(showtimeId)["held"];
+    CHECK(std::set<std::string>(held.begin(), held.end()) ==
+          std::set<std::string>(first["seats"].begin(), first["seats"].end()));
+
+    // The held block is taken, so the next search lands elsewhere
+    json second = system.findBestSeats(showtimeId, 4);
+    std::vector<std::pair<int, int>> secondSeats = block(second);
+    CHECK(second["found"] == true);
+    CHECK(contiguous(secondSeats));
+    for (const auto& seat : secondSeats) {
+        CHECK(std::find(firstSeats.begin(), firstSeats.end(), seat) == firstSeats.end());
+    }
+
+    SeatPreferences rowB;
+    rowB.allowedRows = {1};
+    json inRowB = system.findBestSeats(showtimeId, 3, rowB);
+    CHECK(inRowB["found"] == true);
+    CHECK(inRowB["row"] == "B");
+
+    const int seatsPerRow = system.getSeatMap(showtimeId, "", "bitmap")["seatsPerRow"];
+    json tooWide = system.findBestSeats(showtimeId, seatsPerRow + 1);
+    CHECK(tooWide["found"] == false);
+    CHECK(tooWide["seats"].empty());
+}
+
+// Range totals agree with the bookings in range; bookings with no usable
+// date are reported in the undated bucket rather than dropped
+void testAnalyticsRange() {
+    TempDataset data(2);
+    json undatedBooking = {{"id", "undated-1"}, {"userId", "user-9"}, {"movieId", 1},
+                           {"showtimeId", "show-test-1"}, {"showtimeDate", "TBD"},
+                           {"bookingDate", "unknown"}, {"cinemaId", 1}, {"seats", {"J1"}},
+                           {"totalPrice", 333.33}};
+    std::ofstream(data.path() + "/bookings.json") << json::array({undatedBooking}).dump();
+    BookingSystem system(data.path());
+    loadDataset(system, data);
+
+    std::vector<std::string> ids;
+    for (int i = 0; i < 3; i++) {
+        BookingRequest request = bookingFor(system, "user-" + std::to_string(i), "show-test-" + std::to_string(i % 2),
+                                            {seat_label(2, i), seat_label(2, i + 10)});
+        request.showtimeDate = "2025-05-01";
+        request.showtimeTime = "7:45 PM";
+        request.cinemaId = 1;
+        ids.push_back(system.createBooking(request).getId());
+    }
+    CHECK(system.cancelBooking(ids[2]));
+
+    json range = system.analyticsRange("2025-05-01", "2025-05-01");
+    const json& total = range["totals"]["total"];
+    CHECK(total["bookings"] == 2);
+    CHECK(total["tickets"] == 4);
+    CHECK(total["cancellations"] == 1);
+    CHECK(std::abs(total["revenue"].get<double>() - 4 * 333.33) < 0.005);
+    CHECK(total["capacity"].get<long long>() > 0);
+    CHECK(!range["buckets"].empty());
+
+    json undated = range["undated"]["total"];
+    CHECK(undated["bookings"] == 1);
+    CHECK(undated["tickets"] == 1);
+    CHECK(system.getAnalytics()["totalBookings"] == total["bookings"].get<int>() + undated["bookings"].get<int>());
+
+    json byMovie = system.analyticsRange("2025-05-01", "2025-05-01", "movie", "week");
+    CHECK(byMovie["totals"]["1"]["bookings"] == 2);
+    CHECK(system.analyticsRange("2025-05-02", "2025-05-30")["totals"].empty());
+    CHECK(system.analyticsRange("", "")["totals"]["total"]["bookings"] == 2);
+
+    bool rejected = false;
+    try {
+        system.analyticsRange("not-a-date", "");
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    CHECK(rejected);
+}
+
+// Chunks fold in order into the same result at any thread count, and an
+// exception from a worker reaches the caller: the lowest failing chunk's
+void testParallelReduce() {
+#ifdef _OPENMP
+    const int previousThreads = omp_get_max_threads();
+    omp_set_num_threads(4);
+#endif
+    const size_t count = 100000;
+    auto fold = [](long long& sum, size_t i) { sum += static_cast<long long>(i); };
+    auto merge = [](long long& into, const long long& from) { into += from; };
+    CHECK(parallel_reduce<long long>(count, fold, merge, 1) == static_cast<long long>(count * (count - 1) / 2));
+
+    std::string message;
+    try {
+        parallel_reduce<long long>(count,
+            [count](long long& sum, size_t i) {
+                if (i == count / 4 + 1 || i == 3 * count / 4 + 1) {
+                    throw std::runtime_error("fold failed at " + std::to_string(i));
+                }
+                sum += static_cast<long long>(i);
+            },
+            merge, 1);
+    } catch (const std::runtime_error& e) {
+        message = e.what();
+    }
+    CHECK(message == "fold failed at " + std::to_string(count / 4 + 1));
+#ifdef _OPENMP
+    omp_set_num_threads(previousThreads);
+#endif
+}
+
+// Relative error well inside 3 standard errors (1.04 / sqrt(4096) = 1.6%)
+void testHyperLogLog() {
+    for (int distinct : {100, 1000, 100000}) {
+        HyperLogLog sketch;
+        HyperLogLog half;
+        for (int i = 0; i < distinct; i++) {
+            uint64_t hash = hash64("user-" + std::to_string(i));
+            sketch.add(hash);
+            sketch.add(hash);  // Repeats never count
+            if (i % 2 == 0) half.add(hash);
+        }
+        double error = std::abs(sketch.estimate() - distinct) / distinct;
+        CHECK(error < 0.05);
+
+        HyperLogLog merged = half;
+        merged.merge(sketch);
+        CHECK(merged.estimate() == sketch.estimate());
+    }
+}
+
+// Never below the true count; above it by at most e/width of the stream
+// total for all but a small fraction of keys
+void testCountMinSketch() {
+    const size_t width = 2048;
+    CountMinSketch sketch(width, 4);
+    std::mt19937_64 rng(7);
+    std::unordered_map<int, long long> truth;
+    long long total = 0;
+    for (int i = 0; i < 200000; i++) {
+        int key = static_cast<int>(rng() % 20000);
+        sketch.add(hash64(key), 1);
+        truth[key]++;
+        total++;
+    }
+    // Cancellations subtract exactly
+    for (int key = 0; key < 100; key++) {
+        sketch.add(hash64(key), -truth[key]);
+        total -= truth[key];
+        truth[key] = 0;
+    }
+
+    const double bound = std::exp(1.0) / width * total;
+    size_t outside = 0;
+    bool underestimated = false;
+    for (const auto& [key, count] : truth) {
+        long long estimate = sketch.estimate(hash64(key));
+        underestimated = underestimated || estimate < count;
+        if (estimate - count > bound) outside++;
+    }
+    CHECK(!underestimated);
+    CHECK(outside < truth.size() / 100);
+}
+
+// Every key heavier than total / capacity is tracked, and each reported
+// count brackets the true one: count - error <= true <= count
+void testSpaceSaving() {
+    const size_t capacity = 64;
+    SpaceSaving<int> summary(capacity);
+    std::mt19937_64 rng(11);
+    std::map<int, long long> truth;
+    long long total = 0;
+    for (int i = 0; i < 100000; i++) {
+        // Zipf-like: key k with weight ~ 1/(k+1)
+        int key = static_cast<int>(std::floor(std::pow(5000.0, std::generate_canonical<double, 53>(rng)))) - 1;
+        summary.add(key, 1);
+        truth[key]++;
+        total++;
+    }
+
+    auto top = summary.top(capacity);
+    CHECK(top.size() == capacity);
+    std::set<int> tracked;
+    for (const auto& entry : top) {
+        tracked.insert(entry.key);
+        CHECK(entry.count - entry.error <= truth[entry.key]);
+        CHECK(truth[entry.key] <= entry.count);
+    }
+    for (const auto& [key, count] : truth) {
+        if (count > total / static_cast<long long>(capacity)) CHECK(tracked.count(key) == 1);
+    }
+}
+
+// Timers fire on exactly their tick at every wheel level, including past the
+// outermost wheel (2^26 ticks), whether time advances in small steps or in one jump
+void testTimerWheel() {
+    const std::vector<uint64_t> delays{1, 2, 255, 256, 257, 1000, 16383, 16384, 16385, 100000,
+                                       1048576, 1048577, 5000000, 67108863, 67108864, 67108865, 70000000};
+    for (uint64_t step : {uint64_t(4093), delays.back()}) {
+        const uint64_t start = 12345;
+        TimerWheel<uint64_t> wheel(start);
+        for (uint64_t delay : delays) wheel.schedule(start + delay, start + delay);
+        TimerWheel<uint64_t>::TimerId cancelled = wheel.schedule(start + 300, 0);
+        CHECK(wheel.cancel(cancelled));
+        CHECK(!wheel.cancel(cancelled));
+
+        std::vector<uint64_t> fired;
+        uint64_t now = start;
+        const uint64_t end = start + delays.back();
+        while (now < end) {
+            now = std::min(end, now + step);
+            wheel.advance(now, [&](uint64_t due) {
+                CHECK(due == wheel.currentTick());
+                fired.push_back(due);
+            });
+        }
+        CHECK(fired.size() == delays.size());
+        CHECK(std::is_sorted(fired.begin(), fired.end()));
+        CHECK(wheel.size() == 0);
+    }
+
+    // A timer already in the past fires on the next tick
+    TimerWheel<int> wheel(100);
+    wheel.schedule(50, 1);
+    int fired = 0;
+    wheel.advance(101, [&](int) { fired++; });
+    CHECK(fired == 1);
+}
+
+// Entries expire after the TTL, the oldest is evicted at capacity and a key
+// reused for a different request is rejected
+void testIdempotencyTable() {
+    IdempotencyTable<std::string> table(3, 10.0);
+    table.insert("a", 1, "booking-a", 100.0);
+    CHECK(table.find("a", 1, 105.0) != nullptr);
+    CHECK(*table.find("a", 1, 105.0) == "booking-a");
+
+    bool rejected = false;
+    try {
+        table.find("a", 2, 105.0);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    CHECK(rejected);
+
+    // A repeated insert keeps the original value
+    table.insert("a", 1, "booking-other", 106.0);
+    CHECK(*table.find("a", 1, 106.0) == "booking-a");
+    CHECK(table.find("a", 1, 110.0) == nullptr);
+    CHECK(table.size() == 0);
+
+    table.insert("b", 1, "booking-b", 200.0);
+    table.insert("c", 1, "booking-c", 201.0);
+    table.insert("d", 1, "booking-d", 202.0);
+    table.insert("e", 1, "booking-e", 203.0);
+    CHECK(table.size() == 3);
+    CHECK(table.find("b", 1, 203.0) == nullptr);
+    CHECK(table.find("c", 1, 203.0) != nullptr);
+    CHECK(table.find("e", 1, 203.0) != nullptr);
+}
+
+// A keyed retry returns the original booking without being admitted again,
+// and its current record, so a retry after a cancel sees the cancellation
+void testIdempotentBooking() {
+    TempDataset data(1);
+    BookingSystem system(data.path());
+    loadDataset(system, data);
+    AdmissionConfig admission;
+    admission.enabled = true;
+    admission.userRate = 0.001;  // One request per user, then 429s
+    admission.userBurst = 1.0;
+    system.configureAdmission(admission);
+
+    BookingRequest request = bookingFor(system, "user-1", "show-test-0", {"C4", "C5"});
+    request.idempotencyKey = "key-1";
+    Booking original = system.createBooking(request);
+    for (int i = 0; i < 3; i++) {
+        Booking retry = system.createBooking(request);
+        CHECK(retry.getId() == original.getId());
+        CHECK(!retry.isCancelled());
+    }
+    CHECK(system.getAllBookings().size() == 1);
+
+    CHECK(system.cancelBooking(original.getId()));
+    Booking afterCancel = system.createBooking(request);
+    CHECK(afterCancel.getId() == original.getId());
+    CHECK(afterCancel.isCancelled());
+
+    // The same key for a different request is rejected
+    BookingRequest other = bookingFor(system, "user-1", "show-test-0", {"D4"});
+    other.idempotencyKey = "key-1";
+    bool rejected = false;
+    try {
+        system.createBooking(other);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    CHECK(rejected);
+}
+
+// Seats another buyer has are refused by the lock-free claim, a buyer's own
+// hold is not a conflict, and bookings appended to bookings.json reload intact
+void testSeatClaims() {
+    TempDataset data(1);
+    const std::string showtimeId = "show-test-0";
+    std::string bookedId;
+    {
+        BookingSystem system(data.path());
+        loadDataset(system, data);
+        system.holdSeats(showtimeId, {"F1", "F2"}, "holder", 60.0);
+        json before = system.getSeatClaimStats();
+
+        bool refused = false;
+        try {
+            system.createBooking(bookingFor(system, "other", showtimeId, {"F2", "F3"}));
+        } catch (const std::runtime_error&) {
+            refused = true;
+        }
+        CHECK(refused);
+        json after = system.getSeatClaimStats();
+        CHECK(after["rejected"].get<int>() == before["rejected"].get<int>() + 1);
+        CHECK(after["lockedFallbacks"] == before["lockedFallbacks"]);
+
+        // F3 was rolled back with the refused claim
+        system.createBooking(bookingFor(system, "other", showtimeId, {"F3"}));
+        bookedId = system.createBooking(bookingFor(system, "holder", showtimeId, {"F1", "F2"})).getId();
+        CHECK(system.getSeatClaimStats()["optimisticClaims"].get<int>() == before["optimisticClaims"].get<int>() + 2);
+    }
+
+    BookingSystem reloaded(data.path());
+    loadDataset(reloaded, data);
+    CHECK(reloaded.getAllBookings().size() == 2);
+    Booking booking = reloaded.getBookingById(bookedId);
+    CHECK(booking.getSeats() == std::vector<std::string>({"F1", "F2"}));
+    CHECK(reloaded.getBookedSeatsForShowtime(showtimeId).size() == 3);
+}
+
+// A full bucket allows `burst` requests at once, then refills at `rate`
+void testTokenBucket() {
+    TokenBucket bucket;
+    const double rate = 2.0;
+    const double burst = 5.0;
+    for (int i = 0; i < 5; i++) CHECK(bucket.take(rate, burst, 10.0));
+    CHECK(!bucket.take(rate, burst, 10.0));
+    CHECK(!bucket.full(rate, burst, 10.0));
+
+    CHECK(bucket.take(rate, burst, 10.5));
+    CHECK(!bucket.take(rate, burst, 10.5));
+
+    // Idle time never banks more than the burst
+    CHECK(bucket.full(rate, burst, 100.0));
+    int allowed = 0;
+    while (bucket.take(rate, burst, 100.0)) allowed++;
+    CHECK(allowed == 5);
+}
+
+// Idle waiting-room tickets keep their place without blocking anyone, blocked
+// requests time out, and requests are admitted in ticket order
+void testAdmissionQueue() {
+    AdmissionConfig config;
+    config.enabled = true;
+    config.maxConcurrent = 1;
+    config.userRate = 1000;
+    config.userBurst = 1000;
+    config.queueTimeoutSeconds = 0.2;
+    AdmissionController admission;
+    admission.configure(config);
+    auto queued = [&] {
+        json stats = admission.stats();
+        return stats.contains("S1") ? stats["S1"]["queued"].get<int>() : 0;
+    };
+
+    uint64_t idle = admission.enter("S1", "alice");
+    CHECK(admission.position("S1", idle) == 0);
+    {
+        AdmissionController::Lease lease = admission.acquire("S1", "bob");
+        CHECK(queued() == 1);
+
+        bool timedOut = false;
+        try {
+            admission.acquire("S1", "carol");
+        } catch (const AdmissionError&) {
+            timedOut = true;
+        }
+        CHECK(timedOut);
+        CHECK(queued() == 1);
+    }
+
+    config.queueTimeoutSeconds = 10;
+    admission.configure(config);
+    std::mutex orderMutex;
+    std::vector<std::string> order;
+    auto book = [&](std::string userId, uint64_t ticket) {
+        AdmissionController::Lease lease = admission.acquire("S1", userId, ticket);
+        std::lock_guard<std::mutex> lock(orderMutex);
+        order.push_back(userId);
+    };
+    auto waitForQueued = [&](int count) {
+        while (queued() < count) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    };
+    std::vector<std::thread> threads;
+    {
+        AdmissionController::Lease lease = admission.acquire("S1", "host");
+        threads.emplace_back(book, "bob", 0);
+        waitForQueued(2);
+        threads.emplace_back(book, "carol", 0);
+        waitForQueued(3);
+        // alice's ticket is ahead of both, so she goes first once she asks
+        threads.emplace_back(book, "alice", idle);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    for (auto& thread : threads) thread.join();
+    CHECK((order == std::vector<std::string>{"alice", "bob", "carol"}));
+    CHECK(queued() == 0);
+}
+
+// ETags change exactly when the seat map does, and bitmaps set bit
+// row * seatsPerRow + column, least significant bit first
+void testSeatMapEncoding() {
+    CHECK(base64_encode({}) == "");
+    CHECK(base64_encode({'f'}) == "Zg==");
+    CHECK(base64_encode({'f', 'o'}) == "Zm8=");
+    CHECK(base64_encode({'f', 'o', 'o', 'b', 'a', 'r'}) == "Zm9vYmFy");
+    CHECK(seat_etag(0xabc, 42) == "0000000000000abc-42");
+
+    TempDataset data(1);
+    BookingSystem system(data.path());
+    loadDataset(system, data);
+    const std::string showtimeId = "show-test-0";
+    json before = system.getSeatMap(showtimeId, "", "bitmap");
+    CHECK(before["notModified"] == false);
+    const std::string etag = before["etag"];
+    CHECK(system.getSeatMap(showtimeId, etag)["notModified"] == true);
+    for (uint8_t byte : base64Decode(before["booked"])) CHECK(byte == 0);
+
+    system.createBooking(bookingFor(system, "user-1", showtimeId, {"A1", "B3"}));
+    json after = system.getSeatMap(showtimeId, etag, "bitmap");
+    CHECK(after["notModified"] == false);
+    CHECK(after["etag"] != etag);
+
+    const size_t seatsPerRow = after["seatsPerRow"];
+    const size_t rows = after["rows"];
+    std::vector<uint8_t> booked = base64Decode(after["booked"]);
+    CHECK(booked.size() == (rows * seatsPerRow + 7) / 8);
+    std::set<size_t> bits;
+    for (size_t bit = 0; bit < booked.size() * 8; bit++) {
+        if (booked[bit >> 3] & (1u << (bit & 7))) bits.insert(bit);
+    }
+    CHECK(bits == std::set<size_t>({0, seatsPerRow + 2}));
+    CHECK(system.getSeatMap(showtimeId, after["etag"])["notModified"] == true);
+}
+
+#ifndef _WIN32
+// Journal readers see every complete entry once, in order, while a writer
+// appends concurrently; a reader that falls a whole ring behind is told so
+void testSharedJournal() {
+    const std::string name = "/cinema_tests_" + std::to_string(getpid());
+    {
+        SharedSeatInventory inventory(name, true);
+        CHECK(inventory.created());
+        inventory.markReady();
+
+        const uint64_t count = SharedSeatInventory::kJournalEntries / 2;
+        std::thread writer([&] {
+            for (uint64_t i = 0; i < count; i++) {
+                inventory.append(SharedSeatInventory::EntryKind::Booked, std::to_string(i) + std::string(i % 200, 'x'));
+            }
+        });
+        uint64_t cursor = 0;
+        std::vector<SharedSeatInventory::Record> records;
+        while (records.size() < count) {
+            CHECK(inventory.readSince(cursor, records));
+        }
+        writer.join();
+        CHECK(records.size() == count);
+        for (uint64_t i = 0; i < records.size(); i++) {
+            CHECK(records[i].payload == std::to_string(i) + std::string(i % 200, 'x'));
+            CHECK(records[i].kind == SharedSeatInventory::EntryKind::Booked);
+            CHECK(records[i].pid == SharedSeatInventory::processId());
+        }
+
+        // Lap the ring: the stale reader skips to the oldest surviving entry
+        for (uint64_t i = 0; i < SharedSeatInventory::kJournalEntries; i++) {
+            inventory.append(SharedSeatInventory::EntryKind::Cancelled, "lap-" + std::to_string(i));
+        }
+        uint64_t stale = 0;
+        records.clear();
+        CHECK(!inventory.readSince(stale, records));
+        CHECK(records.size() == SharedSeatInventory::kJournalEntries);
+        CHECK(!records.empty() && records.front().payload == "lap-0");
+        CHECK(stale == count + SharedSeatInventory::kJournalEntries);
+
+        // A change larger than an entry spans several and reads back whole,
+        // and a reader never sees part of one still being written
+        std::string large(SharedSeatInventory::kJournalPayload * 2 + 100, 'b');
+        inventory.append(SharedSeatInventory::EntryKind::Batch, large);
+        inventory.append(SharedSeatInventory::EntryKind::Batch, "");
+        records.clear();
+        CHECK(inventory.readSince(stale, records));
+        CHECK(records.size() == 2);
+        CHECK(!records.empty() && records.front().kind == SharedSeatInventory::EntryKind::Batch);
+        CHECK(!records.empty() && records.front().payload == large);
+        CHECK(records.size() == 2 && records.back().payload.empty());
+        CHECK(stale == count + SharedSeatInventory::kJournalEntries + 4);
+
+        // Claims are all or nothing
+        CHECK(inventory.claim("show-1", {1, 2, 70}));
+        CHECK(!inventory.claim("show-1", {3, 70}));
+        CHECK(inventory.claim("show-1", {3}));
+        inventory.release("show-1", {1, 2, 3, 70});
+        for (uint64_t word : inventory.snapshot("show-1")) CHECK(word == 0);
+    }
+    shm_unlink(name.c_str());
+}
+#endif
+
+struct Test {
+    const char* name;
+    void (*run)();
+};
+
+const Test kTests[] = {
+    {"analytics_reversal", testAnalyticsReversal},
+    {"batch_rollback", testBatchRollback},
+    {"price_verification", testPriceVerification},
+    {"seat_holds", testSeatHolds},
+    {"find_best_seats", testFindBestSeats},
+    {"analytics_range", testAnalyticsRange},
+    {"parallel_reduce", testParallelReduce},
+    {"hyperloglog", testHyperLogLog},
+    {"count_min_sketch", testCountMinSketch},
+    {"space_saving", testSpaceSaving},
+    {"timer_wheel", testTimerWheel},
+    {"idempotency_table", testIdempotencyTable},
+    {"idempotent_booking", testIdempotentBooking},
+    {"seat_claims", testSeatClaims},
+    {"token_bucket", testTokenBucket},
+    {"admission_queue", testAdmissionQueue},
+    {"seat_map_encoding", testSeatMapEncoding},
+#ifndef _WIN32
+    {"shared_journal", testSharedJournal},
+#endif
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    setLogLevel(LogLevel::Warn);
+    std::set<std::string> selected(argv + 1, argv + argc);
+    int failed = 0;
+    for (const Test& test : kTests) {
+        if (!selected.empty() && !selected.count(test.name)) continue;
+        int before = failures;
+        try {
+            test.run();
+        } catch (const std::exception& e) {
+            std::cerr << "  unexpected exception: " << e.what() << "\n";
+            failures++;
+        }
+        bool passed = failures == before;
+        std::cout << (passed ? "PASS " : "FAIL ") << test.name << std::endl;
+        failed += passed ? 0 : 1;
+    }
+    flushLog();
+    return failed == 0 ? 0 : 1;
+}
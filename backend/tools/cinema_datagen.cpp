@@ -0,0 +1,673 @@
+// Synthetic dataset generator for the booking engine.
+//
+// Writes movies.json, cinemas.json (with showtimes), showtimes.json,
+// users.json and bookings.json in the schemas of backend/data, at any scale,
+// so the engine, app.py and cinema_bench can run against production-sized
+// inventories. Records are serialised through the engine's own model classes,
+// and --verify loads the result back through BookingSystem.
+//
+// Output is a function of the flags alone: the same --seed and sizes give the
+// same files. The generator uses its own PRNG and distributions (<random>'s
+// distributions are implementation-defined), and every section draws from its
+// own stream, so changing --bookings does not reshuffle the movies.
+//
+// Demand is skewed the way box offices are:
+//  - movie popularity follows a Zipf law (--zipf) over a shuffled rank, so
+//    popularity is independent of movie id;
+//  - a share of movies (--new_releases) opens inside the window and sells
+//    --opening_spike times its base demand on opening day, decaying with a
+//    half-life of --spike_half_life days; the rest opened before it;
+//  - evenings and weekends sell more than matinees and weekdays, and cinemas
+//    have a milder Zipf skew of their own (--cinema_zipf);
+//  - users book with a Zipf skew too (--user_zipf), so a few are heavy users.
+// Showtimes are scheduled in proportion to that demand and bookings pick
+// showtimes by it. Seats are assigned without conflicts on the standard
+// layout, best-centred first; a booking whose showtime has no room is
+// resampled and eventually dropped (reported as "soldOut").
+#include "cinema_core.h"
+
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+// splitmix64: tiny, fast and fully specified, so seeds reproduce everywhere
+class Rng {
+public:
+    Rng(uint64_t seed, uint64_t stream) : state_(seed ^ (stream * 0xD1B54A32D192ED03ULL)) {
+        next();
+    }
+
+    uint64_t next() {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, 1) from the top 53 bits
+    double uniform() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    // Uniform in [0, n); the modulo bias is negligible for the small n used here
+    uint64_t below(uint64_t n) { return n ? next() % n : 0; }
+
+    bool chance(double p) { return uniform() < p; }
+
+    template <typename T>
+    const T& pick(const std::vector<T>& items) { return items[below(items.size())]; }
+
+private:
+    uint64_t state_;
+};
+
+// Streams, one per section of the dataset
+enum Stream : uint64_t { kMovies = 1, kCinemas, kSchedule, kUsers, kBookings };
+
+// Samples indices in proportion to their weights by binary search over the
+// running totals: O(n) to build, O(log n) per draw
+class WeightedSampler {
+public:
+    void add(double weight) {
+        cumulative_.push_back((cumulative_.empty() ? 0.0 : cumulative_.back()) + std::max(weight, 0.0));
+    }
+
+    bool empty() const { return cumulative_.empty() || cumulative_.back() <= 0.0; }
+
+    size_t sample(Rng& rng) const {
+        double target = rng.uniform() * cumulative_.back();
+        auto it = std::upper_bound(cumulative_.begin(), cumulative_.end(), target);
+        return std::min(static_cast<size_t>(it - cumulative_.begin()), cumulative_.size() - 1);
+    }
+
+private:
+    std::vector<double> cumulative_;
+};
+
+// Zipf weights 1/(rank+1)^s over a shuffled rank order
+std::vector<double> zipfWeights(size_t count, double exponent, Rng& rng) {
+    std::vector<size_t> rank(count);
+    for (size_t i = 0; i < count; i++) rank[i] = i;
+    for (size_t i = count; i > 1; i--) std::swap(rank[i - 1], rank[rng.below(i)]);
+    std::vector<double> weights(count);
+    for (size_t i = 0; i < count; i++) {
+        weights[i] = 1.0 / std::pow(static_cast<double>(rank[i] + 1), exponent);
+    }
+    return weights;
+}
+
+// Random (version 4 shaped) UUID drawn from the generator's stream
+std::string uuidFrom(Rng& rng) {
+    uint64_t high = rng.next(), low = rng.next();
+    char buffer[40];
+    std::snprintf(buffer, sizeof(buffer), "%08x-%04x-4%03x-%04x-%012llx",
+                  static_cast<unsigned>(high >> 32), static_cast<unsigned>((high >> 16) & 0xffff),
+                  static_cast<unsigned>(high & 0xfff), static_cast<unsigned>(0x8000 | ((low >> 48) & 0x3fff)),
+                  static_cast<unsigned long long>(low & 0xffffffffffffULL));
+    return buffer;
+}
+
+// 1970-01-01 was a Thursday
+bool isWeekend(long long day) {
+    int weekday = static_cast<int>(((day % 7) + 11) % 7);  // 0 = Sunday
+    return weekday == 0 || weekday == 6;
+}
+
+const std::vector<std::string> kAdjectives = {
+    "Last", "Silent", "Crimson", "Hidden", "Broken", "Golden", "Midnight", "Lost", "Burning", "Frozen",
+    "Secret", "Eternal", "Savage", "Electric", "Fallen", "Wild", "Iron", "Paper", "Hollow", "Velvet",
+    "Distant", "Shattered", "Rising", "Northern"};
+const std::vector<std::string> kNouns = {
+    "Horizon", "Kingdom", "Monsoon", "Empire", "Promise", "Frontier", "Echo", "Storm", "Garden", "River",
+    "Signal", "Harbour", "Legacy", "Circuit", "Mirage", "Orbit", "Station", "Season", "Verdict", "Summit",
+    "Carnival", "Shadow", "Festival", "Voyage"};
+const std::vector<std::string> kGenres = {
+    "Action", "Adventure", "Animation", "Comedy", "Crime", "Drama", "Family", "Fantasy", "Horror",
+    "Musical", "Mystery", "Romance", "Sci-Fi", "Thriller"};
+const std::vector<std::string> kLanguages = {
+    "Hindi", "Hindi", "Hindi", "English", "English", "Tamil", "Telugu", "Malayalam", "Kannada", "Bengali", "Marathi"};
+const std::vector<std::string> kFirstNames = {
+    "Aarav", "Vivaan", "Aditya", "Arjun", "Sai", "Reyansh", "Kabir", "Ishaan", "Rohan", "Karan",
+    "Ananya", "Diya", "Saanvi", "Aadhya", "Kiara", "Meera", "Priya", "Riya", "Sara", "Tara",
+    "Neha", "Vikram", "Rahul", "Pooja"};
+const std::vector<std::string> kLastNames = {
+    "Sharma", "Verma", "Gupta", "Mehta", "Iyer", "Nair", "Reddy", "Rao", "Kapoor", "Khan",
+    "Singh", "Patel", "Das", "Bose", "Joshi", "Kulkarni", "Menon", "Pillai", "Chopra", "Malhotra"};
+const std::vector<std::string> kChains = {"PVR", "INOX", "Cinepolis", "Carnival", "Miraj", "Movietime", "Star Cinema"};
+const std::vector<std::string> kMalls = {
+    "City Centre", "Phoenix Mall", "Central Plaza", "Orion Mall", "Forum Mall", "Mall of India",
+    "Ambience Mall", "Grand Square", "Metro Walk", "Select Citywalk"};
+const std::vector<std::string> kCities = {
+    "New Delhi", "Mumbai", "Bengaluru", "Chennai", "Hyderabad", "Kolkata", "Pune", "Ahmedabad",
+    "Jaipur", "Lucknow", "Kochi", "Chandigarh"};
+
+// Screen formats by screen number and their base ticket prices (INR)
+const std::vector<std::pair<std::string, double>> kPremiumScreens = {
+    {"IMAX", 550.0}, {"Dolby Atmos", 450.0}, {"4DX", 600.0}, {"Recliner", 700.0}};
+constexpr double kStandardPrice = 250.0;
+
+// Show times through the day and the share of demand each gets
+struct Slot {
+    const char* time;
+    double demand;
+};
+const std::vector<Slot> kSlots = {
+    {"9:30 AM", 0.5}, {"12:15 PM", 0.8}, {"3:00 PM", 0.9}, {"6:15 PM", 1.4}, {"9:30 PM", 1.6}, {"11:45 PM", 0.7}};
+
+// Seats per booking: mostly pairs, some families, a few groups
+const std::vector<double> kPartySizes = {0.0, 0.15, 0.45, 0.15, 0.17, 0.05, 0.03};
+
+// sha256("password"), the password of every generated user
+const char* kPasswordHash = "5e884898da28047151d0e56f8dc6292773603d0d6aabbdd62a11ef721d1542d8";
+
+struct Options {
+    std::string outDir;
+    uint64_t seed = 42;
+    int movies = 200;
+    int cinemas = 50;
+    int screens = 6;
+    int days = 14;
+    std::string startDate = "2025-05-01";
+    int showsPerScreen = 4;
+    int64_t users = 10000;
+    int admins = 1;
+    int64_t bookings = 100000;
+    double zipf = 1.1;
+    double cinemaZipf = 0.6;
+    double userZipf = 0.8;
+    double newReleases = 0.25;
+    double openingSpike = 5.0;
+    double spikeHalfLife = 2.0;
+    double weekendLift = 1.4;
+    double cancelRate = 0.05;
+    int indent = 2;
+    bool movieDetails = true;
+    bool verify = false;
+};
+
+struct MovieInfo {
+    Movie movie;
+    double popularity;
+    long long openingDay;  // days since epoch
+};
+
+struct CinemaInfo {
+    int id;
+    std::string name;
+    std::string location;
+    double weight;
+};
+
+struct ShowInfo {
+    uint32_t cinema;   // index into cinemas
+    uint32_t movie;    // index into movies
+    uint16_t day;      // offset from the start date
+    uint8_t screen;
+    uint8_t slot;
+};
+
+// Relative demand for a movie on a day: nothing before it opens, a spike on
+// opening day decaying back to its base popularity
+double movieDemand(const MovieInfo& movie, long long day, const Options& options) {
+    if (day < movie.openingDay) return 0.0;
+    double age = static_cast<double>(day - movie.openingDay);
+    return movie.popularity * (1.0 + (options.openingSpike - 1.0) * std::pow(0.5, age / options.spikeHalfLife));
+}
+
+std::string screenType(int screen, int screens) {
+    if (screens >= 4 && screen < static_cast<int>(kPremiumScreens.size()) - 1) return kPremiumScreens[screen].first;
+    if (screens >= 3 && screen == screens - 1) return kPremiumScreens.back().first;
+    return "Standard";
+}
+
+double screenPrice(const std::string& type) {
+    for (const auto& [name, price] : kPremiumScreens) {
+        if (name == type) return price;
+    }
+    return kStandardPrice;
+}
+
+// Streams a JSON array one element at a time, laid out as json::dump(indent)
+// would lay out the whole array
+class ArrayWriter {
+public:
+    ArrayWriter(const std::filesystem::path& path, int indent) : file_(path, std::ios::out | std::ios::trunc), indent_(indent) {
+        if (!file_.is_open()) {
+            throw std::runtime_error("Could not open " + path.string() + " for writing");
+        }
+        file_ << "[";
+    }
+
+    void add(const json& element) {
+        if (indent_ < 0) {
+            file_ << (count_ ? "," : "") << element.dump();
+        } else {
+            const std::string pad(indent_, ' ');
+            std::string text = element.dump(indent_);
+            std::string shifted;
+            shifted.reserve(text.size() + text.size() / 8);
+            for (char c : text) {
+                shifted += c;
+                if (c == '\n') shifted += pad;
+            }
+            file_ << (count_ ? ",\n" : "\n") << pad << shifted;
+        }
+        count_++;
+    }
+
+    void close() {
+        file_ << (count_ && indent_ >= 0 ? "\n]" : "]");
+        file_.close();
+        if (file_.fail()) {
+            throw std::runtime_error("Failed writing dataset file");
+        }
+    }
+
+private:
+    std::ofstream file_;
+    int indent_;
+    size_t count_ = 0;
+};
+
+std::vector<MovieInfo> generateMovies(const Options& options, long long startDay) {
+    Rng rng(options.seed, kMovies);
+    std::vector<double> popularity = zipfWeights(options.movies, options.zipf, rng);
+    const size_t titles = kAdjectives.size() * kNouns.size();
+
+    std::vector<MovieInfo> movies;
+    movies.reserve(options.movies);
+    for (int i = 0; i < options.movies; i++) {
+        int id = 1000 + i;
+        // Distinct titles until the word lists run out, then sequels
+        size_t combo = (static_cast<size_t>(i) * 7919) % titles;
+        std::string title = "The " + kAdjectives[combo / kNouns.size()] + " " + kNouns[combo % kNouns.size()];
+        if (static_cast<size_t>(i) >= titles) {
+            title += " " + std::to_string(i / titles + 1);
+        }
+
+        long long openingDay = rng.chance(options.newReleases)
+                                   ? startDay + static_cast<long long>(rng.below(options.days))
+                                   : startDay - 1 - static_cast<long long>(rng.below(90));
+
+        std::string genres = rng.pick(kGenres);
+        for (int extra = static_cast<int>(rng.below(3)); extra > 0; extra--) {
+            const std::string& genre = rng.pick(kGenres);
+            if (genres.find(genre) == std::string::npos) genres += ", " + genre;
+        }
+        std::string cast;
+        for (int actor = 3 + static_cast<int>(rng.below(3)); actor > 0; actor--) {
+            cast += (cast.empty() ? "" : ", ") + rng.pick(kFirstNames) + " " + rng.pick(kLastNames);
+        }
+        std::string director = rng.pick(kFirstNames) + " " + rng.pick(kLastNames);
+        double rating = std::round((5.0 + rng.uniform() * 4.5) * 10.0) / 10.0;
+        int minutes = 95 + static_cast<int>(rng.below(90));
+        std::string duration = std::to_string(minutes / 60) + "h " + std::to_string(minutes % 60) + "m";
+        std::string image = "https://images.cineverse.example/movies/" + std::to_string(id);
+
+        movies.push_back({Movie(id, title, image + "/poster.jpg", image + "/banner.jpg",
+                                title + " - a " + genres.substr(0, genres.find(',')) + " feature directed by " + director + ".",
+                                rating, duration, civil_from_days(openingDay), genres, rng.pick(kLanguages),
+                                director, cast),
+                          popularity[i], openingDay});
+    }
+    return movies;
+}
+
+std::vector<CinemaInfo> generateCinemas(const Options& options) {
+    Rng rng(options.seed, kCinemas);
+    std::vector<double> weights = zipfWeights(options.cinemas, options.cinemaZipf, rng);
+    std::vector<CinemaInfo> cinemas;
+    cinemas.reserve(options.cinemas);
+    for (int i = 0; i < options.cinemas; i++) {
+        const std::string& city = rng.pick(kCities);
+        const std::string& mall = rng.pick(kMalls);
+        cinemas.push_back({i + 1, rng.pick(kChains) + " " + mall + " " + std::to_string(i + 1),
+                           "Level " + std::to_string(2 + rng.below(3)) + ", " + mall + ", " + city,
+                           weights[i]});
+    }
+    return cinemas;
+}
+
+// Every screen of every cinema runs showsPerScreen shows a day, each assigned
+// a movie in proportion to that day's demand
+std::vector<ShowInfo> generateSchedule(const Options& options, const std::vector<MovieInfo>& movies, long long startDay) {
+    Rng rng(options.seed, kSchedule);
+    std::vector<WeightedSampler> byDay(options.days);
+    for (int day = 0; day < options.days; day++) {
+        for (const auto& movie : movies) {
+            byDay[day].add(movieDemand(movie, startDay + day, options));
+        }
+    }
+
+    std::vector<ShowInfo> shows;
+    shows.reserve(static_cast<size_t>(options.cinemas) * options.screens * options.days * options.showsPerScreen);
+    for (int cinema = 0; cinema < options.cinemas; cinema++) {
+        for (int day = 0; day < options.days; day++) {
+            for (int screen = 0; screen < options.screens; screen++) {
+                for (int show = 0; show < options.showsPerScreen; show++) {
+                    // Spread the shows evenly over the day's slots
+                    int slot = show * static_cast<int>(kSlots.size()) / options.showsPerScreen;
+                    uint32_t movie = byDay[day].empty() ? static_cast<uint32_t>(rng.below(movies.size()))
+                                                        : static_cast<uint32_t>(byDay[day].sample(rng));
+                    shows.push_back({static_cast<uint32_t>(cinema), movie, static_cast<uint16_t>(day),
+                                     static_cast<uint8_t>(screen), static_cast<uint8_t>(slot)});
+                }
+            }
+        }
+    }
+    return shows;
+}
+
+void writeUsers(const Options& options, const std::filesystem::path& dir, std::vector<std::string>& ids) {
+    Rng rng(options.seed, kUsers);
+    ArrayWriter users(dir / "users.json", options.indent);
+    ids.reserve(options.users);
+    for (int64_t i = 0; i < options.users; i++) {
+        bool admin = i < options.admins;
+        std::string first = rng.pick(kFirstNames), last = rng.pick(kLastNames);
+        std::string id = uuidFrom(rng);
+        std::string name = admin ? "Admin User" + (i ? " " + std::to_string(i + 1) : std::string()) : first + " " + last;
+        std::string email = admin ? "admin" + (i ? std::to_string(i + 1) : std::string()) + "@example.com"
+                                  : first + "." + last + std::to_string(i) + "@example.com";
+        std::transform(email.begin(), email.end(), email.begin(), ::tolower);
+        users.add({{"id", id}, {"name", name}, {"email", email}, {"password", kPasswordHash}, {"isAdmin", admin}});
+        ids.push_back(std::move(id));
+    }
+    users.close();
+}
+
+std::string showtimeId(size_t show) {
+    return "show-" + std::to_string(100000000 + show);
+}
+
+// Find the best-centred run of `count` free seats, scanning rows outwards from
+// a preferred one; sets the chosen seats in `taken`
+bool claimSeats(const SeatLayout& layout, uint64_t* taken, int count, int preferredRow, std::vector<std::string>& seats) {
+    const int rows = layout.rows(), columns = layout.seatsPerRow();
+    const double centre = (columns - 1) / 2.0;
+    auto isFree = [&](int row, int column) {
+        size_t bit = static_cast<size_t>(row) * columns + column;
+        return !layout.unavailable().test(row, column) && !(taken[bit / 64] >> (bit % 64) & 1);
+    };
+
+    for (int step = 0; step < 2 * rows; step++) {
+        int row = preferredRow + (step % 2 ? -(step + 1) / 2 : step / 2);
+        if (row < 0 || row >= rows) continue;
+        int bestStart = -1;
+        double bestDistance = 1e9;
+        int run = 0;
+        for (int column = 0; column < columns; column++) {
+            run = isFree(row, column) ? run + 1 : 0;
+            if (run >= count) {
+                int start = column - count + 1;
+                double distance = std::fabs(start + (count - 1) / 2.0 - centre);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    bestStart = start;
+                }
+            }
+        }
+        if (bestStart >= 0) {
+            for (int column = bestStart; column < bestStart + count; column++) {
+                size_t bit = static_cast<size_t>(row) * columns + column;
+                taken[bit / 64] |= uint64_t{1} << (bit % 64);
+                seats.push_back(seat_label(row, column));
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "usage: " << program << " --out=<dir> [--seed=<n>]\n"
+              << "       [--movies=<n>] [--cinemas=<n>] [--screens=<n>] [--days=<n>] [--start_date=YYYY-MM-DD]\n"
+              << "       [--shows_per_screen=<1-6>] [--users=<n>] [--admins=<n>] [--bookings=<n>]\n"
+              << "       [--zipf=<s>] [--cinema_zipf=<s>] [--user_zipf=<s>] [--new_releases=<share>]\n"
+              << "       [--opening_spike=<x>] [--spike_half_life=<days>] [--weekend_lift=<x>]\n"
+              << "       [--cancel_rate=<p>] [--indent=<n>|-1] [--no_movie_details] [--verify]\n";
+}
+
+bool flagValue(const std::string& arg, const std::string& flag, std::string& value) {
+    const std::string prefix = "--" + flag + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) return false;
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i], value;
+        if (flagValue(arg, "out", value)) options.outDir = value;
+        else if (flagValue(arg, "seed", value)) options.seed = std::stoull(value);
+        else if (flagValue(arg, "movies", value)) options.movies = std::stoi(value);
+        else if (flagValue(arg, "cinemas", value)) options.cinemas = std::stoi(value);
+        else if (flagValue(arg, "screens", value)) options.screens = std::stoi(value);
+        else if (flagValue(arg, "days", value)) options.days = std::stoi(value);
+        else if (flagValue(arg, "start_date", value)) options.startDate = value;
+        else if (flagValue(arg, "shows_per_screen", value)) options.showsPerScreen = std::stoi(value);
+        else if (flagValue(arg, "users", value)) options.users = std::stoll(value);
+        else if (flagValue(arg, "admins", value)) options.admins = std::stoi(value);
+        else if (flagValue(arg, "bookings", value)) options.bookings = std::stoll(value);
+        else if (flagValue(arg, "zipf", value)) options.zipf = std::stod(value);
+        else if (flagValue(arg, "cinema_zipf", value)) options.cinemaZipf = std::stod(value);
+        else if (flagValue(arg, "user_zipf", value)) options.userZipf = std::stod(value);
+        else if (flagValue(arg, "new_releases", value)) options.newReleases = std::stod(value);
+        else if (flagValue(arg, "opening_spike", value)) options.openingSpike = std::stod(value);
+        else if (flagValue(arg, "spike_half_life", value)) options.spikeHalfLife = std::stod(value);
+        else if (flagValue(arg, "weekend_lift", value)) options.weekendLift = std::stod(value);
+        else if (flagValue(arg, "cancel_rate", value)) options.cancelRate = std::stod(value);
+        else if (flagValue(arg, "indent", value)) options.indent = std::stoi(value);
+        else if (arg == "--no_movie_details") options.movieDetails = false;
+        else if (arg == "--verify") options.verify = true;
+        else return false;
+    }
+    return !options.outDir.empty() && options.movies > 0 && options.cinemas > 0 && options.screens > 0 &&
+           options.screens <= 255 && options.days > 0 && options.days <= 65535 && options.showsPerScreen >= 1 &&
+           options.showsPerScreen <= static_cast<int>(kSlots.size()) && options.users > 0 && options.bookings >= 0 &&
+           options.spikeHalfLife > 0.0 && options.openingSpike >= 1.0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+    } catch (const std::exception&) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    long long startDay = 0;
+    if (!parse_date(options.startDate, startDay)) {
+        std::cerr << "Invalid --start_date: " << options.startDate << std::endl;
+        return 1;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    const std::filesystem::path dir(options.outDir);
+    json summary;
+    try {
+        std::filesystem::create_directories(dir);
+
+        std::vector<MovieInfo> movies = generateMovies(options, startDay);
+        std::vector<CinemaInfo> cinemas = generateCinemas(options);
+        std::vector<ShowInfo> shows = generateSchedule(options, movies, startDay);
+
+        ArrayWriter movieFile(dir / "movies.json", options.indent);
+        for (const auto& movie : movies) movieFile.add(movie.movie.to_json());
+        movieFile.close();
+
+        std::vector<std::string> userIds;
+        writeUsers(options, dir, userIds);
+
+        // Bookings: showtimes by demand, users by activity, seats best-centred
+        Rng rng(options.seed, kBookings);
+        // A movie's demand for the day is shared between its shows, so the
+        // schedule (already drawn by demand) does not square the skew
+        std::vector<uint32_t> showsOf(movies.size() * options.days, 0);
+        for (const auto& show : shows) showsOf[show.movie * options.days + show.day]++;
+        WeightedSampler showSampler;
+        for (const auto& show : shows) {
+            double demand = movieDemand(movies[show.movie], startDay + show.day, options) /
+                            showsOf[show.movie * options.days + show.day] * kSlots[show.slot].demand *
+                            cinemas[show.cinema].weight;
+            showSampler.add(isWeekend(startDay + show.day) ? demand * options.weekendLift : demand);
+        }
+        WeightedSampler userSampler;
+        for (double weight : zipfWeights(userIds.size(), options.userZipf, rng)) userSampler.add(weight);
+        WeightedSampler partySampler;
+        for (double weight : kPartySizes) partySampler.add(weight);
+
+        const auto layout = SeatLayout::standard();
+        const size_t words = (static_cast<size_t>(layout->rows()) * layout->seatsPerRow() + 63) / 64;
+        std::vector<uint64_t> taken(shows.size() * words, 0);
+        std::vector<int64_t> movieBookings(movies.size(), 0);
+
+        int64_t written = 0, cancelled = 0, soldOut = 0, seatsSold = 0;
+        ArrayWriter bookingFile(dir / "bookings.json", options.indent);
+        for (int64_t i = 0; i < options.bookings && !showSampler.empty(); i++) {
+            int count = static_cast<int>(partySampler.sample(rng));
+            std::vector<std::string> seats;
+            size_t show = 0;
+            bool placed = false;
+            for (int attempt = 0; attempt < 8 && !placed; attempt++) {
+                show = showSampler.sample(rng);
+                // Most people sit in the back half; a few want the front
+                int preferredRow = layout->rows() / 2 + static_cast<int>(rng.below(layout->rows() / 2 + 1)) -
+                                   (rng.chance(0.2) ? layout->rows() / 2 : 0);
+                placed = claimSeats(*layout, &taken[show * words], count, preferredRow, seats);
+            }
+            if (!placed) {
+                soldOut++;
+                continue;
+            }
+
+            const ShowInfo& info = shows[show];
+            const MovieInfo& movie = movies[info.movie];
+            const CinemaInfo& cinema = cinemas[info.cinema];
+            const std::string type = screenType(info.screen, options.screens);
+            const long long day = startDay + info.day;
+
+            // Book a few days ahead, further ahead for opening-day shows
+            long long lead = 0;
+            while (lead < 14 && rng.chance(0.55)) lead++;
+            if (day == movie.openingDay) lead += static_cast<long long>(rng.below(7));
+
+            bool isCancelled = rng.chance(options.cancelRate);
+            if (isCancelled) {
+                // The seats went back on sale
+                for (const auto& label : seats) {
+                    int row = 0, column = 0;
+                    parse_seat_label(label, row, column);
+                    size_t bit = static_cast<size_t>(row) * layout->seatsPerRow() + column;
+                    taken[show * words + bit / 64] &= ~(uint64_t{1} << (bit % 64));
+                }
+                cancelled++;
+            } else {
+                seatsSold += count;
+            }
+            movieBookings[info.movie]++;
+
+            Booking booking("bk-" + uuidFrom(rng), userIds[userSampler.sample(rng)], movie.movie.getId(),
+                            movie.movie.getTitle(), movie.movie.getPoster(), showtimeId(show), civil_from_days(day),
+                            kSlots[info.slot].time, cinema.id, cinema.name, type, seats,
+                            screenPrice(type) * count, civil_from_days(day - lead), isCancelled);
+            json booking_json = booking.to_json();
+            if (options.movieDetails) {
+                // As saveBookings writes them
+                const Movie& m = movie.movie;
+                booking_json["movieDetails"] = {
+                    {"id", m.getId()}, {"title", m.getTitle()}, {"poster", m.getPoster()},
+                    {"banner", m.getBanner()}, {"description", m.getDescription()}, {"rating", m.getRating()},
+                    {"duration", m.getDuration()}, {"releaseDate", m.getReleaseDate()}, {"genres", m.getGenres()},
+                    {"language", m.getLanguage()}, {"director", m.getDirector()}, {"cast", m.getCast()}};
+            }
+            bookingFile.add(booking_json);
+            written++;
+        }
+        bookingFile.close();
+
+        // Cinemas with their showtimes and booked seats, plus the flat showtime list app.py keeps
+        ArrayWriter cinemaFile(dir / "cinemas.json", options.indent);
+        ArrayWriter showtimeFile(dir / "showtimes.json", options.indent);
+        const size_t showsPerCinema = static_cast<size_t>(options.screens) * options.days * options.showsPerScreen;
+        for (size_t c = 0; c < cinemas.size(); c++) {
+            json cinema_json = Cinema(cinemas[c].id, cinemas[c].name, cinemas[c].location, options.screens,
+                                      options.screens * layout->capacity()).to_json();
+            for (size_t show = c * showsPerCinema; show < (c + 1) * showsPerCinema; show++) {
+                const ShowInfo& info = shows[show];
+                const std::string type = screenType(info.screen, options.screens);
+                Showtime showtime(showtimeId(show), movies[info.movie].movie.getId(), cinemas[c].id, cinemas[c].name,
+                                  civil_from_days(startDay + info.day), kSlots[info.slot].time, type, screenPrice(type));
+                showtime.setScreen(info.screen);
+                json showtime_json = showtime.to_json();
+                json booked = json::array();
+                for (int row = 0; row < layout->rows(); row++) {
+                    for (int column = 0; column < layout->seatsPerRow(); column++) {
+                        size_t bit = static_cast<size_t>(row) * layout->seatsPerRow() + column;
+                        if (taken[show * words + bit / 64] >> (bit % 64) & 1) {
+                            booked.push_back(seat_label(row, column));
+                        }
+                    }
+                }
+                showtime_json["bookedSeats"] = std::move(booked);
+                showtimeFile.add(showtime_json);
+                cinema_json["showtimes"].push_back(std::move(showtime_json));
+            }
+            cinemaFile.add(cinema_json);
+        }
+        cinemaFile.close();
+        showtimeFile.close();
+
+        // Skew check: share of bookings going to the top 1% of movies
+        std::vector<int64_t> ranked = movieBookings;
+        std::sort(ranked.rbegin(), ranked.rend());
+        int64_t top = 0;
+        for (size_t i = 0; i < std::max<size_t>(1, ranked.size() / 100); i++) top += ranked[i];
+
+        summary = {
+            {"seed", options.seed},
+            {"movies", movies.size()},
+            {"cinemas", cinemas.size()},
+            {"showtimes", shows.size()},
+            {"users", userIds.size()},
+            {"bookings", written},
+            {"cancelled", cancelled},
+            {"soldOut", soldOut},
+            {"seatsSold", seatsSold},
+            {"occupancy", shows.empty() ? 0.0 : static_cast<double>(seatsSold) / (shows.size() * layout->capacity())},
+            {"topMovieShare", written ? static_cast<double>(top) / written : 0.0},
+            {"dates", {civil_from_days(startDay), civil_from_days(startDay + options.days - 1)}},
+        };
+    } catch (const std::exception& e) {
+        std::cerr << "Error generating dataset: " << e.what() << std::endl;
+        return 1;
+    }
+    summary["elapsedSeconds"] = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    if (options.verify) {
+        // Load the dataset through the engine, with its logging muted
+        setLogLevel(LogLevel::Off);
+        BookingSystem system(options.outDir);
+        system.loadMovies((dir / "movies.json").string());
+        system.loadCinemas((dir / "cinemas.json").string());
+        size_t showtimes = 0;
+        for (const auto& cinema : system.getAllCinemas()) showtimes += cinema.getShowtimes().size();
+        json loaded = {{"movies", system.getAllMovies().size()},
+                       {"cinemas", system.getAllCinemas().size()},
+                       {"showtimes", showtimes},
+                       {"bookings", system.getAllBookings().size()}};
+        summary["verified"] = loaded["movies"] == summary["movies"] && loaded["cinemas"] == summary["cinemas"] &&
+                              loaded["showtimes"] == summary["showtimes"] && loaded["bookings"] == summary["bookings"];
+        summary["loaded"] = loaded;
+    }
+
+    std::cout << summary.dump(2) << std::endl;
+    return options.verify && !summary["verified"].get<bool>() ? 1 : 0;
+}
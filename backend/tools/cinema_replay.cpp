@@ -0,0 +1,727 @@
+// Replays recorded API traffic against the booking engine.
+//
+// Reads werkzeug access lines from backend.log (the Flask API, paths under
+// /api) and bridge/bridge.log (the proxy in front of it, same paths without
+// /api; its "Request body:" lines carry POST bodies), maps every request to
+// the engine calls app.py makes for it, and replays that call sequence
+// against a BookingSystem loaded from a copy of --data. Proxied requests that
+// also reached the backend log are counted once, with the bridge's body.
+//
+// Timing follows the log: --speed=1 replays at the recorded pace, --speed=10
+// ten times faster, --speed=max (the default) back to back. --max_gap caps
+// idle gaps so hours of quiet traffic do not have to be waited out. With
+// --threads=N calls run on N workers, each starting no earlier than its
+// scheduled time, so concurrent bursts in the log stay concurrent.
+//
+// Reports latency (p50/p99/p999/max) and share of engine time per endpoint.
+// Requests that are not engine calls (status, auth, OPTIONS) are counted
+// and skipped. POST /bookings without a recorded body books the best free
+// seats on the showtime the same client looked at last; bodies whose seats
+// are already taken in the replay dataset are moved to the best free seats,
+// so the write path is exercised rather than rejected. Bookings are priced
+// with quote() as the client does.
+//
+// Booking IDs in recorded paths mostly belong to bookings the recorded run
+// created, which the replay dataset does not have. Each such ID is bound on
+// first use to the oldest booking created during the replay that is not yet
+// bound, or else to one of the dataset's bookings, and keeps that binding so
+// a lookup, cancel and restore of one recorded booking hit the same record.
+// The report counts these calls by where their ID came from; calls left with
+// no booking to bind to are listed as unmapped rather than failed.
+#include "cinema_core.h"
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <regex>
+#include <unordered_map>
+#include <thread>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace {
+
+enum class Call {
+    Skip, Movies, Movie, Cinemas, Cinema, Showtimes, Showtime, SeatMap, SeatChanges, Availability, Layout,
+    Quote, BestSeats, CreateBooking, Booking, Cancel, Restore, UserBookings, AdminBookings, AdminAnalytics
+};
+
+struct Route {
+    const char* method;
+    std::regex pattern;  // against the path without /api and query
+    const char* name;
+    Call call;
+};
+
+const std::vector<Route>& routes() {
+    static const std::vector<Route> table = {
+        {"GET", std::regex("^/movies$"), "GET /movies", Call::Movies},
+        {"GET", std::regex("^/movies/([0-9]+)$"), "GET /movies/{id}", Call::Movie},
+        {"GET", std::regex("^/cinemas$"), "GET /cinemas", Call::Cinemas},
+        {"GET", std::regex("^/cinemas/([0-9]+)$"), "GET /cinemas/{id}", Call::Cinema},
+        {"GET", std::regex("^/showtimes$"), "GET /showtimes", Call::Showtimes},
+        {"GET", std::regex("^/showtimes/([^/]+)$"), "GET /showtimes/{id}", Call::Showtime},
+        {"GET", std::regex("^/showtimes/([^/]+)/seats$"), "GET /showtimes/{id}/seats", Call::SeatMap},
+        {"GET", std::regex("^/showtimes/([^/]+)/seats/changes$"), "GET /showtimes/{id}/seats/changes", Call::SeatChanges},
+        {"GET", std::regex("^/showtimes/([^/]+)/availability$"), "GET /showtimes/{id}/availability", Call::Availability},
+        {"GET", std::regex("^/showtimes/([^/]+)/layout$"), "GET /showtimes/{id}/layout", Call::Layout},
+        {"POST", std::regex("^/showtimes/([^/]+)/quote$"), "POST /showtimes/{id}/quote", Call::Quote},
+        {"POST", std::regex("^/showtimes/([^/]+)/best-seats$"), "POST /showtimes/{id}/best-seats", Call::BestSeats},
+        {"POST", std::regex("^/bookings$"), "POST /bookings", Call::CreateBooking},
+        {"GET", std::regex("^/bookings/([^/]+)$"), "GET /bookings/{id}", Call::Booking},
+        {"POST", std::regex("^/bookings/([^/]+)/cancel$"), "POST /bookings/{id}/cancel", Call::Cancel},
+        {"POST", std::regex("^/bookings/([^/]+)/restore$"), "POST /bookings/{id}/restore", Call::Restore},
+        {"GET", std::regex("^/users/([^/]+)/bookings$"), "GET /users/{id}/bookings", Call::UserBookings},
+        // Older frontends asked for a user's bookings here
+        {"GET", std::regex("^/bookings/user/([^/]+)$"), "GET /users/{id}/bookings", Call::UserBookings},
+        {"GET", std::regex("^/admin/bookings$"), "GET /admin/bookings", Call::AdminBookings},
+        {"GET", std::regex("^/admin/analytics$"), "GET /admin/analytics", Call::AdminAnalytics},
+    };
+    return table;
+}
+
+// One request recovered from the logs
+struct Request {
+    double time = 0.0;  // seconds since the epoch, log-local time
+    std::string method;
+    std::string path;   // without /api and query
+    std::map<std::string, std::string> query;
+    bool proxied = false;  // seen at the bridge (path had no /api prefix)
+    json body;
+    const Route* route = nullptr;
+    std::string id;     // path parameter
+    bool duplicate = false;
+};
+
+std::string urlDecode(const std::string& text) {
+    std::string decoded;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '%' && i + 2 < text.size() && std::isxdigit(static_cast<unsigned char>(text[i + 1])) &&
+            std::isxdigit(static_cast<unsigned char>(text[i + 2]))) {
+            decoded += static_cast<char>(std::stoi(text.substr(i + 1, 2), nullptr, 16));
+            i += 2;
+        } else {
+            decoded += text[i] == '+' ? ' ' : text[i];
+        }
+    }
+    return decoded;
+}
+
+// "2025-04-27 02:40:20,910" at the start of a line
+bool parseTimestamp(const std::string& line, double& seconds) {
+    int hour = 0, minute = 0, second = 0, millis = 0;
+    long long day = 0;
+    if (line.size() < 23 || !parse_date(line.substr(0, 10), day) ||
+        std::sscanf(line.c_str() + 11, "%d:%d:%d,%d", &hour, &minute, &second, &millis) != 4) {
+        return false;
+    }
+    seconds = day * 86400.0 + hour * 3600 + minute * 60 + second + millis / 1000.0;
+    return true;
+}
+
+// Access lines and bridge request bodies; ANSI colour codes are stripped first
+void readLog(const std::string& filename, std::vector<Request>& requests, json& sources) {
+    static const std::regex ansi("\x1b\\[[0-9;]*m");
+    static const std::regex access("\"(GET|POST|PUT|DELETE|PATCH|OPTIONS|HEAD) (\\S+) HTTP/[0-9.]+\" ([0-9]{3})");
+    static const std::regex bridgeRequest("- bridge - DEBUG - Request: ([A-Z]+) (\\S+)$");
+    static const std::regex bridgeBody("- bridge - DEBUG - Request body: (.*)$");
+
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open log " + filename);
+    }
+    int64_t lines = 0, parsed = 0;
+    std::map<std::string, json> pendingBodies;  // "POST /bookings" -> body awaiting its access line
+    std::string lastRequest;
+    std::string line;
+    while (std::getline(file, line)) {
+        lines++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        line = std::regex_replace(line, ansi, "");
+        std::smatch match;
+        if (std::regex_search(line, match, bridgeRequest)) {
+            lastRequest = match[1].str() + " " + match[2].str();
+            continue;
+        }
+        if (std::regex_search(line, match, bridgeBody)) {
+            json body = json::parse(match[1].str(), nullptr, false);
+            if (!body.is_discarded() && !lastRequest.empty()) pendingBodies[lastRequest] = body;
+            continue;
+        }
+        double time = 0.0;
+        if (!std::regex_search(line, match, access) || !parseTimestamp(line, time)) {
+            continue;
+        }
+
+        Request request;
+        request.time = time;
+        request.method = match[1];
+        std::string target = match[2];
+        auto pendingBody = pendingBodies.find(request.method + " " + target);
+        if (pendingBody != pendingBodies.end()) {
+            request.body = std::move(pendingBody->second);
+            pendingBodies.erase(pendingBody);
+        }
+        size_t question = target.find('?');
+        std::string path = target.substr(0, question);
+        if (question != std::string::npos) {
+            std::istringstream query(target.substr(question + 1));
+            std::string pair;
+            while (std::getline(query, pair, '&')) {
+                size_t eq = pair.find('=');
+                request.query[urlDecode(pair.substr(0, eq))] = eq == std::string::npos ? "" : urlDecode(pair.substr(eq + 1));
+            }
+        }
+        // The frontend sometimes doubled the prefix (/api/api/status)
+        request.proxied = path.compare(0, 4, "/api") != 0;
+        while (path.compare(0, 5, "/api/") == 0) path = path.substr(4);
+        if (path == "/api") path = "/";
+        request.path = path;
+
+        for (const auto& route : routes()) {
+            std::smatch params;
+            if (request.method == route.method && std::regex_match(path, params, route.pattern)) {
+                request.route = &route;
+                if (params.size() > 1) request.id = urlDecode(params[1]);
+                break;
+            }
+        }
+        requests.push_back(std::move(request));
+        parsed++;
+    }
+    sources.push_back({{"file", filename}, {"lines", lines}, {"requests", parsed}});
+}
+
+// A proxied request forwarded to the backend shows up in both logs: keep the
+// backend's copy (and hand it the bridge's body) when one follows within 5 s
+int64_t dropDuplicates(std::vector<Request>& requests) {
+    std::map<std::string, std::vector<size_t>> direct;  // method + path -> backend requests by time
+    for (size_t i = 0; i < requests.size(); i++) {
+        if (!requests[i].proxied) direct[requests[i].method + " " + requests[i].path].push_back(i);
+    }
+    std::vector<bool> claimed(requests.size(), false);
+    int64_t dropped = 0;
+    for (auto& request : requests) {
+        if (!request.proxied) continue;
+        auto it = direct.find(request.method + " " + request.path);
+        if (it == direct.end()) continue;
+        const auto& candidates = it->second;
+        auto first = std::lower_bound(candidates.begin(), candidates.end(), request.time,
+                                      [&](size_t index, double time) { return requests[index].time < time; });
+        for (auto candidate = first; candidate != candidates.end() && requests[*candidate].time <= request.time + 5.0;
+             ++candidate) {
+            if (claimed[*candidate]) continue;
+            claimed[*candidate] = true;
+            if (requests[*candidate].body.is_null()) requests[*candidate].body = request.body;
+            request.duplicate = true;
+            dropped++;
+            break;
+        }
+    }
+    requests.erase(std::remove_if(requests.begin(), requests.end(), [](const Request& r) { return r.duplicate; }),
+                   requests.end());
+    return dropped;
+}
+
+double fieldOr(const json& body, const char* key, double fallback) {
+    return body.is_object() && body.contains(key) && body[key].is_number() ? body[key].get<double>() : fallback;
+}
+
+std::string stringOr(const json& body, const char* key, const std::string& fallback) {
+    return body.is_object() && body.contains(key) && body[key].is_string() ? body[key].get<std::string>() : fallback;
+}
+
+// The booking a recorded POST /bookings asked for, moved to free seats and
+// re-priced for the replay dataset; false if the showtime is unknown or full
+bool bookingFor(BookingSystem& system, const Request& request, const std::string& lastShowtime, BookingRequest& booking) {
+    const json& body = request.body;
+    booking.showtimeId = stringOr(body, "showtimeId", lastShowtime);
+    booking.userId = stringOr(body, "userId", "replay-user");
+    if (booking.showtimeId.empty()) return false;
+    std::vector<std::string> seats;
+    if (body.is_object() && body.contains("seats") && body["seats"].is_array()) {
+        for (const auto& seat : body["seats"]) {
+            if (seat.is_string()) seats.push_back(seat.get<std::string>());
+        }
+    }
+    try {
+        Showtime showtime = system.getShowtimeById(booking.showtimeId);
+        auto booked = system.getBookedSeatsForShowtime(booking.showtimeId);
+        bool free = !seats.empty() && std::none_of(seats.begin(), seats.end(), [&](const std::string& seat) {
+            return std::find(booked.begin(), booked.end(), seat) != booked.end();
+        });
+        if (!free) {
+            json best = system.findBestSeats(booking.showtimeId, seats.empty() ? 2 : static_cast<int>(seats.size()));
+            if (!best["found"].get<bool>()) return false;
+            seats = best["seats"].get<std::vector<std::string>>();
+        }
+        booking.movieId = showtime.getMovieId();
+        booking.movieTitle = stringOr(body, "movieTitle", "");
+        booking.showtimeDate = showtime.getDate();
+        booking.showtimeTime = showtime.getTime();
+        booking.cinemaId = showtime.getCinemaId();
+        booking.cinemaName = showtime.getCinemaName();
+        booking.screenType = showtime.getScreenType();
+        booking.seats = seats;
+        booking.totalPrice = system.quote(booking.showtimeId, seats)["totalPrice"].get<double>();
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// Where the booking ID of a /bookings/{id} call came from
+enum class IdSource { Recorded, Created, Dataset, Unmapped, Count };
+const char* const kIdSourceNames[] = {"recorded", "created", "dataset", "unmapped"};
+
+// Recorded booking IDs to bookings of the replay (see the file comment); one
+// instance per replay round
+class BookingIdMap {
+public:
+    explicit BookingIdMap(std::vector<std::string> dataset) : dataset_(std::move(dataset)) {}
+    
+    void created(const std::string& id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        created_.push_back(id);
+    }
+    
+    // The replay's ID for a recorded one; the recorded ID itself when unmapped
+    std::string resolve(BookingSystem& system, const std::string& recorded, IdSource& source) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto bound = bindings_.find(recorded);
+        if (bound == bindings_.end()) {
+            Binding binding{recorded, IdSource::Recorded};
+            if (system.getBookingById(recorded).getId().empty()) {
+                if (nextCreated_ < created_.size()) {
+                    binding = {created_[nextCreated_++], IdSource::Created};
+                } else if (!dataset_.empty()) {
+                    binding = {dataset_[nextDataset_++ % dataset_.size()], IdSource::Dataset};
+                } else {
+                    binding.source = IdSource::Unmapped;
+                }
+            }
+            bound = bindings_.emplace(recorded, binding).first;
+        }
+        source = bound->second.source;
+        return bound->second.id;
+    }
+    
+private:
+    struct Binding {
+        std::string id;
+        IdSource source;
+    };
+    
+    std::mutex mutex_;
+    std::vector<std::string> dataset_;
+    std::vector<std::string> created_;
+    size_t nextCreated_ = 0;
+    size_t nextDataset_ = 0;
+    std::unordered_map<std::string, Binding> bindings_;
+};
+
+// The engine calls app.py makes for one request; false when the engine
+// reports not found / not possible. `bookingId` stands in for the path's
+// booking ID, and a created booking's ID is left in `createdId`.
+bool execute(BookingSystem& system, const Request& request, const BookingRequest* booking,
+             const std::string& bookingId, std::string& createdId) {
+    auto query = [&](const char* key) {
+        auto it = request.query.find(key);
+        return it != request.query.end() ? it->second : std::string();
+    };
+    switch (request.route->call) {
+        case Call::Movies:
+            system.getAllMovies();
+            return true;
+        case Call::Movie:
+            return system.getMovieById(std::stoi(request.id)).getId() != 0;
+        case Call::Cinemas:
+            system.getAllCinemas();
+            return true;
+        case Call::Cinema:
+            return system.getCinemaById(std::stoi(request.id)).getId() != 0;
+        case Call::Showtimes: {
+            std::string movieId = query("movieId"), date = query("date");
+            if (!movieId.empty() && !date.empty()) system.getShowtimesByMovieAndDate(std::stoi(movieId), date);
+            else if (!movieId.empty()) system.getShowtimesByMovie(std::stoi(movieId));
+            else if (!date.empty()) system.getShowtimesByDate(date);
+            else {
+                std::vector<Showtime> all;
+                for (const auto& cinema : system.getAllCinemas()) {
+                    for (const auto& showtime : cinema.getShowtimes()) all.push_back(showtime);
+                }
+            }
+            return true;
+        }
+        case Call::Showtime:
+            return !system.getShowtimeById(request.id).getId().empty();
+        case Call::SeatMap: {
+            std::string format = query("format");
+            system.getSeatMap(request.id, "", format.empty() ? "list" : format);
+            return true;
+        }
+        case Call::SeatChanges: {
+            std::string since = query("since");
+            system.seatChangesSince(request.id, since.empty() ? 0 : std::stoull(since));
+            return true;
+        }
+        case Call::Availability:
+            system.getSeatAvailability(request.id);
+            return true;
+        case Call::Layout:
+            system.getSeatLayout(request.id);
+            return true;
+        case Call::Quote:
+            system.quote(request.id, request.body.is_object() ? request.body.value("seats", std::vector<std::string>{})
+                                                            : std::vector<std::string>{});
+            return true;
+        case Call::BestSeats:
+            return system.findBestSeats(request.id, static_cast<int>(fieldOr(request.body, "count", 1)))["found"].get<bool>();
+        case Call::CreateBooking:
+            if (!booking) return false;
+            createdId = system.createBooking(*booking).getId();
+            return true;
+        case Call::Booking:
+            return !system.getBookingById(bookingId).getId().empty();
+        case Call::Cancel:
+            return system.cancelBooking(bookingId);
+        case Call::Restore:
+            return system.restoreBooking(bookingId);
+        case Call::UserBookings:
+            system.getBookingsByUser(request.id);
+            return true;
+        case Call::AdminBookings:
+            system.getAllBookings();
+            return true;
+        case Call::AdminAnalytics:
+            system.getAllCinemas();
+            system.getAllMovies();
+            system.analyticsRange("", "", "cinema");
+            system.analyticsRange("", "", "movie");
+            return true;
+        case Call::Skip:
+            break;
+    }
+    return false;
+}
+
+uint64_t percentile(const std::vector<uint64_t>& sorted, double q) {
+    if (sorted.empty()) return 0;
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(q * sorted.size()))];
+}
+
+std::filesystem::path workDir() {
+#ifdef _WIN32
+    static const std::string suffix = std::to_string(std::time(nullptr));
+#else
+    static const std::string suffix = std::to_string(getpid());
+#endif
+    return std::filesystem::temp_directory_path() / ("cinema_replay-" + suffix);
+}
+
+bool flagValue(const std::string& arg, const std::string& flag, std::string& value) {
+    const std::string prefix = "--" + flag + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) return false;
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "usage: " << program << " [--data=<dir>] [--speed=<x>|max] [--max_gap=<seconds>]\n"
+              << "       [--threads=<n>] [--repeat=<n>] [--format=console|json] [--dump_calls] [--engine_log]\n"
+              << "       <log>...\n"
+              << "e.g.   " << program << " --data=backend/data backend/backend.log bridge/bridge.log\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string dataDir = "data";
+    double speed = 0.0;  // 0 = as fast as possible
+    double maxGap = -1.0;
+    int threads = 1;
+    int repeat = 1;
+    std::string format = "console";
+    bool dumpCalls = false;
+    bool engineLog = false;
+    std::vector<std::string> logs;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i], value;
+            if (flagValue(arg, "data", value)) dataDir = value;
+            else if (flagValue(arg, "speed", value)) speed = value == "max" ? 0.0 : std::stod(value);
+            else if (flagValue(arg, "max_gap", value)) maxGap = std::stod(value);
+            else if (flagValue(arg, "threads", value)) threads = std::stoi(value);
+            else if (flagValue(arg, "repeat", value)) repeat = std::stoi(value);
+            else if (flagValue(arg, "format", value)) format = value;
+            else if (arg == "--dump_calls") dumpCalls = true;
+            else if (arg == "--engine_log") engineLog = true;
+            else if (arg.compare(0, 2, "--") != 0) logs.push_back(arg);
+            else {
+                printUsage(argv[0]);
+                return arg == "--help" ? 0 : 1;
+            }
+        }
+    } catch (const std::exception&) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (logs.empty() || threads < 1 || repeat < 1 || speed < 0.0 || (format != "console" && format != "json")) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // Extract the request sequence
+    std::vector<Request> requests;
+    json sources = json::array();
+    int64_t duplicates = 0;
+    try {
+        for (const auto& log : logs) readLog(log, requests, sources);
+        std::stable_sort(requests.begin(), requests.end(), [](const Request& a, const Request& b) { return a.time < b.time; });
+        duplicates = dropDuplicates(requests);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    std::map<std::string, int64_t> skipped;
+    std::vector<Request> calls;
+    for (auto& request : requests) {
+        if (request.route) {
+            calls.push_back(std::move(request));
+        } else {
+            // Collapse ids so the skipped list stays short
+            std::string path = std::regex_replace(request.path, std::regex("/[^/]*[0-9][^/]*"), "/{id}");
+            skipped[request.method + " " + path]++;
+        }
+    }
+    if (dumpCalls) {
+        for (const auto& call : calls) {
+            json entry = {{"time", call.time}, {"endpoint", call.route->name}, {"id", call.id}};
+            if (!call.query.empty()) entry["query"] = call.query;
+            if (!call.body.is_null()) entry["body"] = call.body;
+            std::cout << entry.dump() << "\n";
+        }
+        return 0;
+    }
+    if (calls.empty()) {
+        std::cerr << "No engine calls found in the logs" << std::endl;
+        return 1;
+    }
+
+    // Schedule: offsets from the first call, idle gaps capped, scaled by speed
+    std::vector<double> schedule(calls.size(), 0.0);
+    for (size_t i = 1; i < calls.size(); i++) {
+        double gap = calls[i].time - calls[i - 1].time;
+        if (maxGap >= 0.0) gap = std::min(gap, maxGap);
+        schedule[i] = schedule[i - 1] + gap;
+    }
+    const double recordedSpan = schedule.back();
+    if (speed > 0.0) {
+        for (auto& offset : schedule) offset /= speed;
+    }
+
+    // Results go to stdout; the engine's own logging is off unless asked for
+    std::ostream out(std::cout.rdbuf());
+    if (!engineLog) {
+        setLogLevel(LogLevel::Off);
+    }
+
+    // The replay writes bookings.json, so it runs on a copy of the data
+    const std::filesystem::path dir = workDir();
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    for (const char* name : {"movies.json", "cinemas.json", "bookings.json"}) {
+        if (std::filesystem::exists(std::filesystem::path(dataDir) / name)) {
+            std::filesystem::copy_file(std::filesystem::path(dataDir) / name, dir / name);
+        }
+    }
+
+    const size_t endpoints = routes().size();
+    // Aliases report under the first route of the same name
+    auto routeIndex = [&](const Request& call) {
+        for (size_t e = 0; e < endpoints; e++) {
+            if (std::strcmp(routes()[e].name, call.route->name) == 0) return e;
+        }
+        return static_cast<size_t>(call.route - routes().data());
+    };
+    std::vector<std::vector<uint64_t>> latencies(endpoints);
+    std::vector<int64_t> failed(endpoints, 0), errors(endpoints, 0);
+    std::vector<std::string> lastError(endpoints);
+    std::vector<int64_t> idSources(static_cast<size_t>(IdSource::Count), 0);
+    std::mutex resultsMutex;
+    double elapsed = 0.0;
+    json seatClaims;
+    {
+        BookingSystem system(dir.string());
+        system.loadMovies((dir / "movies.json").string());
+        system.loadCinemas((dir / "cinemas.json").string());
+        AdmissionConfig admission = system.getAdmissionConfig();
+        admission.enabled = false;  // the recorded clients were not throttled either
+        system.configureAdmission(admission);
+
+        for (int round = 0; round < repeat; round++) {
+            std::vector<std::string> datasetIds;
+            for (const auto& booking : system.getAllBookings()) datasetIds.push_back(booking.getId());
+            BookingIdMap bookingIds(std::move(datasetIds));
+            std::atomic<size_t> next{0};
+            std::mutex lastShowtimeMutex;
+            std::string lastShowtime;  // showtime most recently looked at, for body-less bookings
+            auto began = std::chrono::steady_clock::now();
+            auto work = [&] {
+                while (true) {
+                    size_t i = next.fetch_add(1);
+                    if (i >= calls.size()) return;
+                    const Request& call = calls[i];
+                    if (speed > 0.0) {
+                        std::this_thread::sleep_until(began + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                                  std::chrono::duration<double>(schedule[i])));
+                    }
+                    BookingRequest booking;
+                    bool haveBooking = false;
+                    if (call.route->call == Call::CreateBooking) {
+                        std::string showtime;
+                        {
+                            std::lock_guard<std::mutex> lock(lastShowtimeMutex);
+                            showtime = lastShowtime;
+                        }
+                        haveBooking = bookingFor(system, call, showtime, booking);
+                    } else if (!call.id.empty() && call.path.compare(0, 11, "/showtimes/") == 0) {
+                        std::lock_guard<std::mutex> lock(lastShowtimeMutex);
+                        lastShowtime = call.id;
+                    }
+                    std::string bookingId;
+                    IdSource idSource = IdSource::Count;
+                    if (call.route->call == Call::Booking || call.route->call == Call::Cancel ||
+                        call.route->call == Call::Restore) {
+                        bookingId = bookingIds.resolve(system, call.id, idSource);
+                    }
+
+                    bool ok = false;
+                    std::string error, createdId;
+                    auto started = std::chrono::steady_clock::now();
+                    try {
+                        ok = execute(system, call, haveBooking ? &booking : nullptr, bookingId, createdId);
+                    } catch (const std::exception& e) {
+                        error = e.what();
+                    }
+                    uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now() - started).count();
+                    if (!createdId.empty()) bookingIds.created(createdId);
+                    size_t endpoint = routeIndex(call);
+                    std::lock_guard<std::mutex> lock(resultsMutex);
+                    latencies[endpoint].push_back(nanos);
+                    if (idSource != IdSource::Count) idSources[static_cast<size_t>(idSource)]++;
+                    if (idSource == IdSource::Unmapped) {
+                        // Nothing in the replay to stand in for the recorded booking
+                    } else if (!error.empty()) {
+                        errors[endpoint]++;
+                        lastError[endpoint] = error;
+                    } else if (!ok) {
+                        failed[endpoint]++;
+                    }
+                }
+            };
+            std::vector<std::thread> workers;
+            for (int t = 1; t < threads; t++) workers.emplace_back(work);
+            work();
+            for (auto& worker : workers) worker.join();
+            elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+        }
+        seatClaims = system.getSeatClaimStats();
+    }
+    flushLog();
+    std::filesystem::remove_all(dir);
+
+    // Report, busiest endpoints by engine time first
+    double engineTotal = 0.0;
+    for (const auto& samples : latencies) {
+        for (uint64_t nanos : samples) engineTotal += nanos / 1e9;
+    }
+    std::vector<size_t> order;
+    for (size_t e = 0; e < endpoints; e++) {
+        if (!latencies[e].empty()) order.push_back(e);
+        std::sort(latencies[e].begin(), latencies[e].end());
+    }
+    auto seconds = [&](size_t e) {
+        double total = 0.0;
+        for (uint64_t nanos : latencies[e]) total += nanos / 1e9;
+        return total;
+    };
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return seconds(a) > seconds(b); });
+
+    const int64_t replayed = static_cast<int64_t>(calls.size()) * repeat;
+    json endpointsJson = json::object();
+    for (size_t e : order) {
+        const auto& samples = latencies[e];
+        endpointsJson[routes()[e].name] = {
+            {"count", samples.size()},
+            {"share", static_cast<double>(samples.size()) / replayed},
+            {"failed", failed[e]},
+            {"errors", errors[e]},
+            {"p50Us", percentile(samples, 0.50) / 1e3},
+            {"p99Us", percentile(samples, 0.99) / 1e3},
+            {"p999Us", percentile(samples, 0.999) / 1e3},
+            {"maxUs", samples.back() / 1e3},
+            {"engineSeconds", seconds(e)},
+            {"engineShare", engineTotal > 0.0 ? seconds(e) / engineTotal : 0.0},
+        };
+        if (!lastError[e].empty()) endpointsJson[routes()[e].name]["lastError"] = lastError[e];
+    }
+    json report = {
+        {"sources", sources},
+        {"duplicatesDropped", duplicates},
+        {"skipped", skipped},
+        {"calls", calls.size()},
+        {"repeat", repeat},
+        {"threads", threads},
+        {"speed", speed > 0.0 ? json(speed) : json("max")},
+        {"recordedSeconds", recordedSpan},
+        {"elapsedSeconds", elapsed},
+        {"callsPerSecond", replayed / elapsed},
+        {"engineSeconds", engineTotal},
+        {"endpoints", endpointsJson},
+        {"seatClaims", seatClaims},
+    };
+    json bookingIdsJson = json::object();
+    for (size_t source = 0; source < idSources.size(); source++) {
+        bookingIdsJson[kIdSourceNames[source]] = idSources[source];
+    }
+    report["bookingIds"] = bookingIdsJson;
+
+    if (format == "json") {
+        out << report.dump(2) << std::endl;
+        return 0;
+    }
+    int64_t skippedTotal = 0;
+    for (const auto& [name, count] : skipped) skippedTotal += count;
+    out << calls.size() << " engine calls from " << logs.size() << " log(s) (" << duplicates
+        << " proxied duplicates dropped, " << skippedTotal << " non-engine requests skipped)\n"
+        << std::fixed << std::setprecision(2) << "replayed " << replayed << " calls in " << elapsed << " s ("
+        << std::setprecision(0) << replayed / elapsed << " calls/s), " << std::setprecision(1) << recordedSpan
+        << " s of recorded traffic\n";
+    out << "booking IDs: " << idSources[static_cast<size_t>(IdSource::Recorded)] << " recorded, "
+        << idSources[static_cast<size_t>(IdSource::Created)] << " bound to replay bookings, "
+        << idSources[static_cast<size_t>(IdSource::Dataset)] << " bound to dataset bookings, "
+        << idSources[static_cast<size_t>(IdSource::Unmapped)] << " unmapped\n\n";
+    out << std::left << std::setw(36) << "endpoint" << std::right << std::setw(8) << "count" << std::setw(8) << "mix%"
+        << std::setw(8) << "failed" << std::setw(11) << "p50 us" << std::setw(11) << "p99 us" << std::setw(11)
+        << "p999 us" << std::setw(11) << "max us" << std::setw(9) << "time%" << "\n";
+    for (size_t e : order) {
+        const json& row = endpointsJson[routes()[e].name];
+        out << std::left << std::setw(36) << routes()[e].name << std::right << std::setw(8) << row["count"].get<int64_t>()
+            << std::setw(8) << std::setprecision(1) << row["share"].get<double>() * 100 << std::setw(8)
+            << row["failed"].get<int64_t>() + row["errors"].get<int64_t>() << std::setw(11) << row["p50Us"].get<double>()
+            << std::setw(11) << row["p99Us"].get<double>() << std::setw(11) << row["p999Us"].get<double>()
+            << std::setw(11) << row["maxUs"].get<double>() << std::setw(9) << row["engineShare"].get<double>() * 100
+            << "\n";
+    }
+    out.flush();
+    return 0;
+}
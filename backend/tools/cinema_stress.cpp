@@ -0,0 +1,597 @@
+// Concurrent booking stress test with a correctness oracle.
+//
+// --threads workers run a realistic mix of seat lookups, bookings, cancels
+// and restores against a few hot showtimes (--showtimes, Zipf-skewed by
+// --skew) for --seconds, then the run is checked:
+//  - seat log: the engine's seat changes, replayed per showtime in version
+//    order, never book a seat that is already booked or free one that is
+//    free, and have no gaps - so no seat was ever sold twice, even briefly;
+//  - ledger: every booking a worker created, cancelled or restored is in the
+//    state the engine last reported to that worker;
+//  - inventory: each showtime's booked seats are exactly the seats of its
+//    active bookings, and no seat belongs to two active bookings;
+//  - reload: bookings.json loaded into a fresh engine agrees with memory.
+// A "book" is a quote followed by createBooking, as clients do.
+// Throughput and p50/p99/p999 latency per operation are reported, as a table
+// or with --format=json; the exit status is non-zero if any check fails.
+//
+// Workers book random seat runs, so hot showtimes sell out and bookings
+// conflict; cancels and restores (of the worker's own bookings) keep seats
+// churning. Admission control is off unless --admission is given.
+// --lock_profile profiles the engine mutex during the run and reports the
+// call sites that waited longest for it.
+#include "cinema_core.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <set>
+#include <thread>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace {
+
+enum Op { kAvailability, kSeatMap, kBook, kCancel, kRestore, kOpCount };
+const char* kOpNames[kOpCount] = {"availability", "seatMap", "book", "cancel", "restore"};
+
+constexpr double kTicketPrice = 300.0;
+
+struct Options {
+    int threads = 8;
+    double seconds = 5.0;
+    int showtimes = 4;
+    double skew = 1.0;
+    int maxSeats = 4;
+    uint64_t seed = 42;
+    int mix[kOpCount] = {30, 30, 25, 10, 5};
+    std::string data;
+    std::string format = "console";
+    bool admission = false;
+    bool keep = false;
+    bool engineLog = false;
+    bool lockProfile = false;
+};
+
+// Per-worker results: latencies in nanoseconds and outcomes per operation
+struct WorkerStats {
+    std::vector<uint64_t> latencies[kOpCount];
+    int64_t ok[kOpCount] = {};
+    int64_t rejected[kOpCount] = {};
+    std::string lastError[kOpCount];
+};
+
+// A booking as its worker last saw it
+struct Owned {
+    std::string id;
+    std::string showtimeId;
+    std::vector<std::string> seats;
+    bool active = true;
+};
+
+struct Check {
+    std::string name;
+    bool passed = true;
+    std::string detail;
+    int64_t violations = 0;
+
+    void fail(const std::string& what) {
+        if (violations++ < 5) detail += (detail.empty() ? "" : "; ") + what;
+        passed = false;
+    }
+};
+
+std::filesystem::path workDir() {
+#ifdef _WIN32
+    static const std::string suffix = std::to_string(std::time(nullptr));
+#else
+    static const std::string suffix = std::to_string(getpid());
+#endif
+    return std::filesystem::temp_directory_path() / ("cinema_stress-" + suffix);
+}
+
+// One cinema running the hot showtimes on the standard layout
+void writeDataset(const std::filesystem::path& dir, int showtimes) {
+    json movies = json::array({{{"id", 1}, {"title", "Stress Test"}, {"rating", 7.0}, {"genres", {"Drama"}},
+                                {"cast", {"Actor"}}, {"language", "English"}, {"duration", "2h 10m"},
+                                {"releaseDate", "2025-04-01"}}});
+    std::ofstream(dir / "movies.json") << movies.dump();
+
+    json list = json::array();
+    for (int i = 0; i < showtimes; i++) {
+        list.push_back({{"id", "show-stress-" + std::to_string(i)}, {"movieId", 1}, {"cinemaId", 1},
+                        {"cinemaName", "Cinema 1"}, {"date", "2025-05-01"}, {"time", "7:45 PM"},
+                        {"screenType", "Standard"}, {"price", kTicketPrice}, {"screen", i % 8}});
+    }
+    json cinemas = json::array({{{"id", 1}, {"name", "Cinema 1"}, {"location", "City"}, {"screens", 8},
+                                 {"totalSeats", 1120}, {"showtimes", list}}});
+    std::ofstream(dir / "cinemas.json") << cinemas.dump();
+}
+
+// A run of `count` adjacent seats at a random spot; may cross the aisle or
+// the edge, which the engine rejects like any other bad request
+std::vector<std::string> randomSeats(const SeatLayout& layout, int count, std::mt19937_64& rng) {
+    int row = static_cast<int>(rng() % layout.rows());
+    int column = static_cast<int>(rng() % layout.seatsPerRow());
+    std::vector<std::string> seats;
+    for (int i = 0; i < count; i++) {
+        seats.push_back(seat_label(row, column + i));
+    }
+    return seats;
+}
+
+uint64_t percentile(const std::vector<uint64_t>& sorted, double q) {
+    if (sorted.empty()) return 0;
+    size_t index = std::min(sorted.size() - 1, static_cast<size_t>(q * sorted.size()));
+    return sorted[index];
+}
+
+void worker(BookingSystem& system, const Options& options, const std::vector<std::string>& showtimes,
+            const std::vector<int>& movieIds, int index, const std::atomic<bool>& stop, WorkerStats& stats, std::vector<Owned>& owned) {
+    std::mt19937_64 rng(options.seed * 1000003 + index);
+    std::vector<double> weights;
+    for (size_t i = 0; i < showtimes.size(); i++) weights.push_back(1.0 / std::pow(i + 1.0, options.skew));
+    std::discrete_distribution<size_t> pickShowtime(weights.begin(), weights.end());
+    std::discrete_distribution<int> pickOp(std::begin(options.mix), std::end(options.mix));
+    const auto layout = SeatLayout::standard();
+    const std::string userId = "stress-user-" + std::to_string(index);
+    std::vector<size_t> active, cancelled;  // indices into owned
+
+    while (!stop.load(std::memory_order_relaxed)) {
+        Op op = static_cast<Op>(pickOp(rng));
+        if ((op == kCancel && active.empty()) || (op == kRestore && cancelled.empty())) {
+            op = kAvailability;
+        }
+        const size_t hot = pickShowtime(rng);
+        const std::string& showtimeId = showtimes[hot];
+
+        BookingRequest request;
+        size_t slot = 0;
+        if (op == kBook) {
+            request.userId = userId;
+            request.movieId = movieIds[hot];
+            request.showtimeId = showtimeId;
+            request.seats = randomSeats(*layout, 1 + static_cast<int>(rng() % options.maxSeats), rng);
+        } else if (op == kCancel) {
+            slot = rng() % active.size();
+        } else if (op == kRestore) {
+            slot = rng() % cancelled.size();
+        }
+
+        bool succeeded = true;
+        auto started = std::chrono::steady_clock::now();
+        try {
+            switch (op) {
+                case kAvailability:
+                    system.getSeatAvailability(showtimeId);
+                    break;
+                case kSeatMap:
+                    system.getSeatMap(showtimeId, "", rng() % 2 ? "bitmap" : "list");
+                    break;
+                case kBook: {
+                    // Quote then book, as clients do
+                    request.totalPrice = system.quote(showtimeId, request.seats)["totalPrice"].get<double>();
+                    Booking booking = system.createBooking(request);
+                    owned.push_back({booking.getId(), showtimeId, booking.getSeats(), true});
+                    active.push_back(owned.size() - 1);
+                    break;
+                }
+                case kCancel:
+                    succeeded = system.cancelBooking(owned[active[slot]].id);
+                    if (succeeded) {
+                        owned[active[slot]].active = false;
+                        cancelled.push_back(active[slot]);
+                        active.erase(active.begin() + slot);
+                    }
+                    break;
+                case kRestore:
+                    succeeded = system.restoreBooking(owned[cancelled[slot]].id);
+                    if (succeeded) {
+                        owned[cancelled[slot]].active = true;
+                        active.push_back(cancelled[slot]);
+                        cancelled.erase(cancelled.begin() + slot);
+                    }
+                    break;
+                default:
+                    break;
+            }
+        } catch (const std::exception& e) {
+            succeeded = false;
+            stats.lastError[op] = e.what();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - started;
+        stats.latencies[op].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        (succeeded ? stats.ok : stats.rejected)[op]++;
+    }
+}
+
+// Replay the seat change log of each showtime in version order
+Check checkSeatLog(const std::vector<SeatChange>& changes,
+                   const std::map<std::string, std::set<std::string>>& initial,
+                   std::map<std::string, std::set<std::string>>& replayed) {
+    Check check{"seatLog", true, "", 0};
+    std::map<std::string, std::vector<const SeatChange*>> byShowtime;
+    for (const auto& change : changes) byShowtime[change.showtimeId].push_back(&change);
+
+    int64_t applied = 0;
+    for (auto& [showtimeId, log] : byShowtime) {
+        std::sort(log.begin(), log.end(), [](const SeatChange* a, const SeatChange* b) { return a->version < b->version; });
+        auto it = initial.find(showtimeId);
+        std::set<std::string> booked = it != initial.end() ? it->second : std::set<std::string>{};
+        for (size_t i = 0; i < log.size(); i++) {
+            const SeatChange& change = *log[i];
+            if (i > 0 && change.version != log[i - 1]->version + 1) {
+                check.fail(showtimeId + " jumps from version " + std::to_string(log[i - 1]->version) + " to " +
+                           std::to_string(change.version));
+            }
+            for (const auto& seat : change.seats) {
+                if (change.kind == SeatChange::Kind::Booked && !booked.insert(seat).second) {
+                    check.fail(showtimeId + " " + seat + " sold twice at version " + std::to_string(change.version));
+                } else if (change.kind == SeatChange::Kind::Unbooked && booked.erase(seat) == 0) {
+                    check.fail(showtimeId + " " + seat + " freed while free at version " + std::to_string(change.version));
+                }
+            }
+            applied++;
+        }
+        replayed[showtimeId] = std::move(booked);
+    }
+    if (check.passed) {
+        check.detail = std::to_string(applied) + " changes over " + std::to_string(byShowtime.size()) + " showtimes";
+    }
+    return check;
+}
+
+Check checkLedger(const BookingSystem& system, const std::vector<std::vector<Owned>>& ledgers) {
+    Check check{"ledger", true, "", 0};
+    int64_t bookings = 0;
+    for (const auto& ledger : ledgers) {
+        for (const auto& entry : ledger) {
+            bookings++;
+            try {
+                Booking booking = system.getBookingById(entry.id);
+                if (booking.isCancelled() == entry.active) {
+                    check.fail(entry.id + " is " + (booking.isCancelled() ? "cancelled" : "active") +
+                               " but its worker saw it " + (entry.active ? "active" : "cancelled"));
+                }
+            } catch (const std::exception&) {
+                check.fail(entry.id + " is missing");
+            }
+        }
+    }
+    if (check.passed) check.detail = std::to_string(bookings) + " bookings as their workers saw them";
+    return check;
+}
+
+// Active bookings' seats per showtime; a seat in two active bookings is a violation
+std::map<std::string, std::set<std::string>> activeSeats(const std::vector<Booking>& bookings, Check& check) {
+    std::map<std::string, std::set<std::string>> seats;
+    for (const auto& booking : bookings) {
+        if (booking.isCancelled()) continue;
+        auto& taken = seats[booking.getShowtimeId()];
+        for (const auto& seat : booking.getSeats()) {
+            if (!taken.insert(seat).second) {
+                check.fail(booking.getShowtimeId() + " " + seat + " is in two active bookings");
+            }
+        }
+    }
+    return seats;
+}
+
+Check checkInventory(BookingSystem& system, const std::vector<std::string>& showtimes,
+                     const std::map<std::string, std::set<std::string>>& replayed) {
+    Check check{"inventory", true, "", 0};
+    auto seats = activeSeats(system.getAllBookings(), check);
+    size_t sold = 0;
+    for (const auto& showtimeId : showtimes) {
+        auto booked = system.getBookedSeatsForShowtime(showtimeId);
+        std::set<std::string> inventory(booked.begin(), booked.end());
+        const std::set<std::string>& expected = seats[showtimeId];
+        if (inventory != expected) {
+            check.fail(showtimeId + " has " + std::to_string(inventory.size()) + " booked seats but " +
+                       std::to_string(expected.size()) + " in active bookings");
+        }
+        auto it = replayed.find(showtimeId);
+        if (it != replayed.end() && it->second != inventory) {
+            check.fail(showtimeId + " seat log replays to " + std::to_string(it->second.size()) +
+                       " booked seats but inventory has " + std::to_string(inventory.size()));
+        }
+        sold += inventory.size();
+    }
+    if (check.passed) check.detail = std::to_string(sold) + " seats sold across " + std::to_string(showtimes.size()) + " showtimes";
+    return check;
+}
+
+Check checkReload(const BookingSystem& system, const std::filesystem::path& dir) {
+    Check check{"reload", true, "", 0};
+    BookingSystem reloaded(dir.string());
+    std::map<std::string, bool> saved;
+    for (const auto& booking : reloaded.getAllBookings()) saved[booking.getId()] = booking.isCancelled();
+    auto bookings = system.getAllBookings();
+    if (saved.size() != bookings.size()) {
+        check.fail(std::to_string(saved.size()) + " bookings on disk, " + std::to_string(bookings.size()) + " in memory");
+    }
+    for (const auto& booking : bookings) {
+        auto it = saved.find(booking.getId());
+        if (it == saved.end()) {
+            check.fail(booking.getId() + " is not on disk");
+        } else if (it->second != booking.isCancelled()) {
+            check.fail(booking.getId() + " is " + (it->second ? "cancelled" : "active") + " on disk");
+        }
+    }
+    activeSeats(reloaded.getAllBookings(), check);
+    if (check.passed) check.detail = std::to_string(saved.size()) + " bookings on disk match memory";
+    return check;
+}
+
+bool flagValue(const std::string& arg, const std::string& flag, std::string& value) {
+    const std::string prefix = "--" + flag + "=";
+    if (arg.compare(0, prefix.size(), prefix) != 0) return false;
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+// "availability:30,seatMap:30,book:25,cancel:10,restore:5"; unnamed operations get 0
+bool parseMix(const std::string& text, int (&mix)[kOpCount]) {
+    std::fill(std::begin(mix), std::end(mix), 0);
+    std::istringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        size_t colon = item.find(':');
+        if (colon == std::string::npos) return false;
+        auto name = std::find(std::begin(kOpNames), std::end(kOpNames), item.substr(0, colon));
+        if (name == std::end(kOpNames)) return false;
+        mix[name - std::begin(kOpNames)] = std::stoi(item.substr(colon + 1));
+    }
+    return std::accumulate(std::begin(mix), std::end(mix), 0) > 0;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "usage: " << program << " [--threads=<n>] [--seconds=<s>] [--showtimes=<n>] [--skew=<s>]\n"
+              << "       [--max_seats=<n>] [--seed=<n>] [--mix=availability:30,seatMap:30,book:25,cancel:10,restore:5]\n"
+              << "       [--data=<dir>] [--format=console|json] [--admission] [--keep] [--engine_log]\n"
+              << "       [--lock_profile]\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i], value;
+        if (flagValue(arg, "threads", value)) options.threads = std::stoi(value);
+        else if (flagValue(arg, "seconds", value)) options.seconds = std::stod(value);
+        else if (flagValue(arg, "showtimes", value)) options.showtimes = std::stoi(value);
+        else if (flagValue(arg, "skew", value)) options.skew = std::stod(value);
+        else if (flagValue(arg, "max_seats", value)) options.maxSeats = std::stoi(value);
+        else if (flagValue(arg, "seed", value)) options.seed = std::stoull(value);
+        else if (flagValue(arg, "mix", value)) {
+            if (!parseMix(value, options.mix)) return false;
+        }
+        else if (flagValue(arg, "data", value)) options.data = value;
+        else if (flagValue(arg, "format", value)) options.format = value;
+        else if (arg == "--admission") options.admission = true;
+        else if (arg == "--keep") options.keep = true;
+        else if (arg == "--engine_log") options.engineLog = true;
+        else if (arg == "--lock_profile") options.lockProfile = true;
+        else return false;
+    }
+    return options.threads > 0 && options.seconds > 0 && options.showtimes > 0 && options.maxSeats > 0 &&
+           (options.format == "console" || options.format == "json");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+    } catch (const std::exception&) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // Results go to stdout; the engine's own logging is off unless asked for
+    std::ostream out(std::cout.rdbuf());
+    if (!options.engineLog) {
+        setLogLevel(LogLevel::Off);
+    }
+
+    // The run writes bookings.json, so it works on a copy of --data
+    const std::filesystem::path dir = workDir();
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    if (options.data.empty()) {
+        writeDataset(dir, options.showtimes);
+    } else {
+        for (const char* name : {"movies.json", "cinemas.json", "bookings.json"}) {
+            if (std::filesystem::exists(std::filesystem::path(options.data) / name)) {
+                std::filesystem::copy_file(std::filesystem::path(options.data) / name, dir / name);
+            }
+        }
+    }
+
+    json report;
+    bool passed = true;
+    {
+        BookingSystem system(dir.string());
+        system.loadMovies((dir / "movies.json").string());
+        system.loadCinemas((dir / "cinemas.json").string());
+        AdmissionConfig admission = system.getAdmissionConfig();
+        admission.enabled = options.admission;
+        system.configureAdmission(admission);
+
+        // Hot showtimes: the first --showtimes of the catalogue
+        std::vector<std::string> showtimes;
+        std::vector<int> movieIds;
+        for (const auto& cinema : system.getAllCinemas()) {
+            for (const auto& showtime : cinema.getShowtimes()) {
+                if (static_cast<int>(showtimes.size()) < options.showtimes) {
+                    showtimes.push_back(showtime.getId());
+                    movieIds.push_back(showtime.getMovieId());
+                }
+            }
+        }
+        if (showtimes.empty()) {
+            flushLog();
+            std::cerr << "No showtimes to stress" << std::endl;
+            return 1;
+        }
+        std::map<std::string, std::set<std::string>> initial;
+        for (const auto& showtimeId : showtimes) {
+            auto booked = system.getBookedSeatsForShowtime(showtimeId);
+            initial[showtimeId] = std::set<std::string>(booked.begin(), booked.end());
+        }
+
+        std::mutex changesMutex;
+        std::vector<SeatChange> changes;
+        int subscription = system.subscribeSeatChanges([&](const SeatChange& change) {
+            std::lock_guard<std::mutex> lock(changesMutex);
+            changes.push_back(change);
+        });
+
+        std::vector<WorkerStats> stats(options.threads);
+        std::vector<std::vector<Owned>> ledgers(options.threads);
+        std::atomic<bool> stop{false};
+        std::mutex startMutex;
+        std::condition_variable startSignal;
+        bool started = false;
+        std::vector<std::thread> workers;
+        for (int t = 0; t < options.threads; t++) {
+            workers.emplace_back([&, t] {
+                {
+                    std::unique_lock<std::mutex> lock(startMutex);
+                    startSignal.wait(lock, [&] { return started; });
+                }
+                worker(system, options, showtimes, movieIds, t, stop, stats[t], ledgers[t]);
+            });
+        }
+        if (options.lockProfile) system.setLockProfiling(true);
+        auto began = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(startMutex);
+            started = true;
+        }
+        startSignal.notify_all();
+        std::this_thread::sleep_for(std::chrono::duration<double>(options.seconds));
+        stop = true;
+        for (auto& thread : workers) thread.join();
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+        system.unsubscribeSeatChanges(subscription);
+        json lockProfile;
+        if (options.lockProfile) {
+            system.setLockProfiling(false);
+            lockProfile = system.lockContentionReport();
+        }
+
+        // Latency and throughput per operation
+        json ops = json::object();
+        int64_t total = 0;
+        for (int op = 0; op < kOpCount; op++) {
+            std::vector<uint64_t> latencies;
+            int64_t ok = 0, rejected = 0;
+            std::string lastError;
+            for (auto& worker : stats) {
+                latencies.insert(latencies.end(), worker.latencies[op].begin(), worker.latencies[op].end());
+                ok += worker.ok[op];
+                rejected += worker.rejected[op];
+                if (!worker.lastError[op].empty()) lastError = worker.lastError[op];
+            }
+            std::sort(latencies.begin(), latencies.end());
+            total += static_cast<int64_t>(latencies.size());
+            ops[kOpNames[op]] = {
+                {"count", latencies.size()},
+                {"ok", ok},
+                {"rejected", rejected},
+                {"opsPerSecond", latencies.size() / elapsed},
+                {"p50Us", percentile(latencies, 0.50) / 1e3},
+                {"p99Us", percentile(latencies, 0.99) / 1e3},
+                {"p999Us", percentile(latencies, 0.999) / 1e3},
+                {"maxUs", latencies.empty() ? 0.0 : latencies.back() / 1e3},
+            };
+            if (!lastError.empty()) ops[kOpNames[op]]["lastError"] = lastError;
+        }
+
+        std::map<std::string, std::set<std::string>> replayed;
+        std::vector<Check> checks;
+        checks.push_back(checkSeatLog(changes, initial, replayed));
+        checks.push_back(checkLedger(system, ledgers));
+        checks.push_back(checkInventory(system, showtimes, replayed));
+        checks.push_back(checkReload(system, dir));
+
+        json checksJson = json::object();
+        for (const auto& check : checks) {
+            checksJson[check.name] = {{"passed", check.passed}, {"violations", check.violations}, {"detail", check.detail}};
+            passed = passed && check.passed;
+        }
+        report = {
+            {"config", {{"threads", options.threads}, {"seconds", options.seconds}, {"showtimes", showtimes.size()},
+                        {"skew", options.skew}, {"maxSeats", options.maxSeats}, {"seed", options.seed},
+                        {"admission", options.admission}, {"data", options.data}}},
+            {"elapsedSeconds", elapsed},
+            {"opsPerSecond", total / elapsed},
+            {"ops", ops},
+            {"seatClaims", system.getSeatClaimStats()},
+            {"checks", checksJson},
+            {"passed", passed},
+        };
+        if (options.lockProfile) report["lockProfile"] = lockProfile;
+    }
+    flushLog();
+    if (!options.keep) {
+        std::filesystem::remove_all(dir);
+    }
+
+    if (options.format == "json") {
+        out << report.dump(2) << std::endl;
+    } else {
+        out << options.threads << " threads, " << report["config"]["showtimes"] << " hot showtimes, "
+            << std::fixed << std::setprecision(1) << report["elapsedSeconds"].get<double>() << " s, "
+            << std::setprecision(0) << report["opsPerSecond"].get<double>() << " ops/s\n\n";
+        out << std::left << std::setw(14) << "op" << std::right << std::setw(10) << "count" << std::setw(10) << "ok"
+            << std::setw(10) << "rejected" << std::setw(12) << "ops/s" << std::setw(11) << "p50 us" << std::setw(11)
+            << "p99 us" << std::setw(11) << "p999 us" << std::setw(11) << "max us" << "\n";
+        for (const char* name : kOpNames) {
+            const json& op = report["ops"][name];
+            out << std::left << std::setw(14) << name << std::right << std::setw(10) << op["count"].get<int64_t>()
+                << std::setw(10) << op["ok"].get<int64_t>() << std::setw(10) << op["rejected"].get<int64_t>()
+                << std::setw(12) << std::setprecision(0) << op["opsPerSecond"].get<double>() << std::setprecision(1)
+                << std::setw(11) << op["p50Us"].get<double>() << std::setw(11) << op["p99Us"].get<double>()
+                << std::setw(11) << op["p999Us"].get<double>() << std::setw(11) << op["maxUs"].get<double>() << "\n";
+        }
+        out << "\n";
+        for (const auto& [name, check] : report["checks"].items()) {
+            out << (check["passed"].get<bool>() ? "PASS " : "FAIL ") << std::left << std::setw(10) << name
+                << check["detail"].get<std::string>() << "\n";
+        }
+        if (report.contains("lockProfile")) {
+            const json& profile = report["lockProfile"];
+            out << "\nlock wait " << std::setprecision(3) << profile["totalWaitSeconds"].get<double>() << " s, hold "
+                << profile["totalHoldSeconds"].get<double>() << " s over " << std::setprecision(1)
+                << profile["windowSeconds"].get<double>() << " s\n";
+            out << std::left << std::setw(34) << "site" << std::right << std::setw(10) << "acquired" << std::setw(10)
+                << "contended" << std::setw(9) << "waiters" << std::setw(9) << "wait %" << std::setw(12)
+                << "wait p99 us" << std::setw(12) << "hold p99 us" << std::setw(12) << "hold max us" << "\n";
+            int shown = 0;
+            for (const auto& site : profile["sites"]) {
+                if (shown++ == 10) break;
+                out << std::left << std::setw(34) << site["site"].get<std::string>() << std::right << std::setw(10)
+                    << site["acquisitions"].get<uint64_t>() << std::setw(10) << site["contended"].get<uint64_t>()
+                    << std::setw(9) << std::setprecision(1) << site["meanWaiters"].get<double>() << std::setw(9)
+                    << site["waitShare"].get<double>() * 100 << std::setw(12) << site["wait"]["p99Us"].get<double>()
+                    << std::setw(12) << site["hold"]["p99Us"].get<double>() << std::setw(12)
+                    << site["hold"]["maxUs"].get<double>() << "\n";
+            }
+        }
+        out.flush();
+    }
+    return passed ? 0 : 1;
+}